@@ -16,6 +16,10 @@
  *  01-May-2021  DVS  Fixed a bug with data line parsing (bug found by Leonid Yadrennikov).
  *  29-Jun-2021  DVS  Added support of getopt() for xBSD annd compile for xBSD
  *  04-Jul-2021  DVS  Added around for FreeBSD 10.4 on PowerPC Mac G4
+ *  19-Oct-2026  DVS  Added symbol/line map output file (-m option)
+ *  19-Oct-2026  DVS  Hash tables for names, growable line/name tables and
+ *                    input line buffer (no fixed limits for source size)
+ *  19-Oct-2026  DVS  Added binary object file output (-b option)
  *
  */
 
@@ -144,12 +148,11 @@ typedef struct sym_tables {
 
 
 #if defined(__USE_AUTOCODE_SMALL_TABLES__)
-#define  MAX_PARSED_LINES                 3000
 #define  MAX_TEXT_LINE_SIZE                128
 #else
 #define  MAX_TEXT_LINE_SIZE                2000
-#define  MAX_PARSED_LINES                 10000
 #endif
+#define  INIT_PARSED_LINES                1024
 #define  MAX_LEXICAL_WORD_SIZE              128
 #define  MAX_LEXICAL_WORD_NUM                32
 #define  MAX_CHECK_LEXICAL_WORD_NUM           8
@@ -196,19 +199,21 @@ typedef  struct parsed_line {
 
 
 #define  MAX_ABS_VALUE_NAME_SIZE    64
-#define  MAX_ABS_VALUES_NUM        512
+#define  INIT_ABS_VALUES_NUM       512
 
 typedef struct absolute_value {
   t_value  abs_value;
+  int      hash_next;
   char     abs_name[MAX_ABS_VALUE_NAME_SIZE+1];
 } ABSOLUTE_VALUE, *PABSOLUTE_VALUE;
 
 
 #define  MAX_SYM_VALUE_NAME_SIZE    64
-#define  MAX_SYM_VALUES_NUM        512
+#define  INIT_SYM_VALUES_NUM       512
 
 typedef struct symbolic_value {
   int      sym_value;
+  int      hash_next;
   char     sym_name[MAX_SYM_VALUE_NAME_SIZE+1];
 } SYMBOLIC_VALUE, *PSYMBOLIC_VALUE;
 
@@ -222,6 +227,8 @@ extern  char     * optarg;
 char         * out_file = NULL;
 char         * in_file = NULL;
 char         * list_file = NULL;
+char         * map_file = NULL;
+char         * bin_file = NULL;
 int           verbose = 0;
 int           quiet = 0;
 int           out_address_code = 0;
@@ -251,14 +258,19 @@ SYM_TABLES  sym_table_rus_utf8   = { 0 };
 
 int  read_lines_num = 0;
 int  parsed_lines_num = 0;
-//PARSED_LINE   parsed_lines_array[MAX_PARSED_LINES] = { 0 };
-PARSED_LINE   parsed_lines_array[MAX_PARSED_LINES];
+int  parsed_lines_size = 0;
+PPARSED_LINE   parsed_lines_array = NULL;
 
+/* name tables grow by doubling, index by name is hash table (chains by index) */
 int  abs_values_num = 0;
-ABSOLUTE_VALUE  abs_values_table[MAX_ABS_VALUES_NUM] = { 0 };
+int  abs_values_size = 0;
+PABSOLUTE_VALUE  abs_values_table = NULL;
+int *  abs_hash_heads = NULL;
 
 int  sym_values_num = 0;
-SYMBOLIC_VALUE  sym_values_table[MAX_SYM_VALUES_NUM] = { 0 };
+int  sym_values_size = 0;
+PSYMBOLIC_VALUE  sym_values_table = NULL;
+int *  sym_hash_heads = NULL;
 
 int   program_start_address = 1;
 
@@ -266,7 +278,8 @@ char  author_name[128]   = { 0 };
 char  module_name[128]   = { 0 };
 char  program_title[256] = { 0 };
 
-static unsigned char big_text_buf[MAX_TEXT_BUF_SIZE];
+static char * big_text_buf = NULL;
+static size_t big_text_buf_size = 0;
 static unsigned char out_text_buf[MAX_TEXT_BUF_SIZE+128];
 
 
@@ -424,6 +437,59 @@ strcasestr(s, find)
 
 
 
+/*
+ *  Read text line of any length into big_text_buf (NULL at end of file)
+ */
+
+char *  read_text_line( FILE * fp )
+{
+  size_t  len = 0;
+  char *  p;
+
+  if (big_text_buf == NULL) {
+      big_text_buf = (char *) malloc( MAX_TEXT_BUF_SIZE );
+      if (big_text_buf == NULL) return NULL;
+      big_text_buf_size = MAX_TEXT_BUF_SIZE;
+  }
+
+  big_text_buf[0] = '\0';
+  while( fgets(big_text_buf+len,(int)(big_text_buf_size-len),fp) != NULL) {
+      len += strlen(big_text_buf+len);
+      if ((len > 0) && (big_text_buf[len-1] == '\n')) break;
+      if (len+1 < big_text_buf_size) break;
+      p = (char *) realloc( big_text_buf, big_text_buf_size*2 );
+      if (p == NULL) break;
+      big_text_buf = p;
+      big_text_buf_size *= 2;
+  }
+
+  if (len == 0) return NULL;
+  return big_text_buf;
+}
+
+
+
+/*
+ *  Grow parsed lines array (doubling), new lines are zeroed
+ */
+
+int  grow_parsed_lines_array( void )
+{
+  int  new_size;
+  PPARSED_LINE  p;
+
+  new_size = (parsed_lines_size == 0) ? INIT_PARSED_LINES : (parsed_lines_size * 2);
+  p = (PPARSED_LINE) realloc( parsed_lines_array, new_size * sizeof(PARSED_LINE) );
+  if (p == NULL) return 1;
+  memset( &p[parsed_lines_size], 0, (new_size - parsed_lines_size) * sizeof(PARSED_LINE) );
+  parsed_lines_array = p;
+  parsed_lines_size = new_size;
+
+  return 0;
+}
+
+
+
 /*
  *  Build work tables from data files of selected encoding
  */
@@ -455,9 +521,7 @@ void  process_tables_file( char * filename, int encoding, PSYM_TABLES  p_sym_tab
   fp = fopen( filename, "rt" );
   if (fp == NULL) return;
 
-  memset( big_text_buf, 0, sizeof(big_text_buf) );
-
-  while( fgets(big_text_buf,sizeof(big_text_buf)-1,fp) != NULL) {
+  while( read_text_line(fp) != NULL) {
 
        //printf( "%s", big_text_buf );
        line_num++;
@@ -680,20 +744,112 @@ int  is_numeric_exp( char * expr )
 
 
 
-t_value  search_abs_value_per_abs_values_table( char * abs_name )
+/*
+ *  Case-insensitive hash of name (ASCII folding as strcasecmp)
+ */
+unsigned int  name_hash_value( char * name )
 {
-  t_value m_code = 0;
-  int i;
+  unsigned int h = 0;
+  unsigned int c;
+
+  while( *name ) {
+    c = (unsigned char)*name++;
+    if ((c >= 'a') && (c <= 'z')) c = c - 'a' + 'A';
+    h = h * 31 + c;
+  }
+
+  return h;
+}
+
+
+
+/*
+ *  Grow name table (doubling) and rebuild its hash index
+ */
+void *  grow_name_table( void * table, int * size, size_t elem_size, int init_size,
+                         int ** heads )
+{
+  void * p;
+  int    new_size = (*size == 0) ? init_size : (*size * 2);
+
+  p = realloc( table, new_size * elem_size );
+  if (p == NULL) return NULL;
+  free( *heads );
+  *heads = (int *) malloc( new_size * sizeof(int) );
+  if (*heads == NULL) return NULL;
+  *size = new_size;
+  return p;
+}
+
+
 
-  if (abs_name == NULL) return m_code;
+void  rehash_abs_values_table( void )
+{
+  int i;
+  unsigned int h;
 
+  for( i=0; i<abs_values_size; i++ ) abs_hash_heads[i] = -1;
   for( i=0; i<abs_values_num; i++ ) {
-     //printf( "%s,%s\n", abs_name,abs_values_table[i].abs_name );
-     if (strcasecmp(abs_name,abs_values_table[i].abs_name) == 0) {
-       m_code = abs_values_table[i].abs_value;
-       return m_code;
-     }
+     h = name_hash_value( abs_values_table[i].abs_name ) % abs_values_size;
+     abs_values_table[i].hash_next = abs_hash_heads[h];
+     abs_hash_heads[h] = i;
+  }
+}
+
+
+
+void  rehash_sym_values_table( void )
+{
+  int i;
+  unsigned int h;
+
+  for( i=0; i<sym_values_size; i++ ) sym_hash_heads[i] = -1;
+  for( i=0; i<sym_values_num; i++ ) {
+     h = name_hash_value( sym_values_table[i].sym_name ) % sym_values_size;
+     sym_values_table[i].hash_next = sym_hash_heads[h];
+     sym_hash_heads[h] = i;
   }
+}
+
+
+
+int  find_abs_value_index( char * abs_name )
+{
+  int i;
+
+  if ((abs_name == NULL) || (abs_values_size == 0)) return -1;
+
+  for( i=abs_hash_heads[name_hash_value(abs_name) % abs_values_size]; i>=0; i=abs_values_table[i].hash_next ) {
+     if (strcasecmp(abs_name,abs_values_table[i].abs_name) == 0) return i;
+  }
+
+  return -1;
+}
+
+
+
+int  find_sym_value_index( char * sym_name )
+{
+  int i;
+
+  if ((sym_name == NULL) || (sym_values_size == 0)) return -1;
+
+  for( i=sym_hash_heads[name_hash_value(sym_name) % sym_values_size]; i>=0; i=sym_values_table[i].hash_next ) {
+     if (strcasecmp(sym_name,sym_values_table[i].sym_name) == 0) return i;
+  }
+
+  return -1;
+}
+
+
+
+t_value  search_abs_value_per_abs_values_table( char * abs_name )
+{
+  t_value m_code = 0;
+  int i;
+
+  i = find_abs_value_index( abs_name );
+  if (i >= 0) m_code = abs_values_table[i].abs_value;
 
   return m_code;
 }
@@ -706,14 +862,8 @@ int  search_sym_value_per_sym_values_table( char * sym_name )
   int i_code = 0;
   int i;
 
-  if (sym_name == NULL) return i_code;
-
-  for( i=0; i<sym_values_num; i++ ) {
-     if (strcasecmp(sym_name,sym_values_table[i].sym_name) == 0) {
-       i_code = sym_values_table[i].sym_value;
-       return i_code;
-     }
-  }
+  i = find_sym_value_index( sym_name );
+  if (i >= 0) i_code = sym_values_table[i].sym_value;
 
   return i_code;
 }
@@ -723,25 +873,36 @@ int  search_sym_value_per_sym_values_table( char * sym_name )
 void  add_new_sym_to_symtab( char * name, int value )
 {
     int i;
+    unsigned int h;
+    void * p;
 
     if (name == NULL) return;
 
-    if (sym_values_num < MAX_SYM_VALUES_NUM) {
-        for( i=0; i<sym_values_num; i++ ) {
-          if (strcasecmp(name,sym_values_table[i].sym_name) == 0) {
-            fprintf( stderr, "ERROR: duplicate symbolic name found (%s,%d:%s).\n", name,i,sym_values_table[i].sym_name );
-            return;
-          }
-        }
-        i = sym_values_num;
-        sym_values_table[i].sym_value = value;
-        strncpy( sym_values_table[i].sym_name, name, MAX_SYM_VALUE_NAME_SIZE );
-        sym_values_num++;
-    }
-    else {
-        fprintf( stderr, "ERROR: symbolic name table is fully occupied (%d,%d).\n", sym_values_num, MAX_SYM_VALUES_NUM );
+    i = find_sym_value_index( name );
+    if (i >= 0) {
+        fprintf( stderr, "ERROR: duplicate symbolic name found (%s,%d:%s).\n", name,i,sym_values_table[i].sym_name );
         return;
     }
+
+    if (sym_values_num >= sym_values_size) {
+        p = grow_name_table( sym_values_table, &sym_values_size, sizeof(SYMBOLIC_VALUE),
+                             INIT_SYM_VALUES_NUM, &sym_hash_heads );
+        if (p == NULL) {
+            fprintf( stderr, "ERROR: no memory for symbolic name table (%d).\n", sym_values_num );
+            exit(13);
+        }
+        sym_values_table = (PSYMBOLIC_VALUE) p;
+        rehash_sym_values_table();
+    }
+
+    i = sym_values_num;
+    memset( &sym_values_table[i], 0, sizeof(SYMBOLIC_VALUE) );
+    sym_values_table[i].sym_value = value;
+    strncpy( sym_values_table[i].sym_name, name, MAX_SYM_VALUE_NAME_SIZE );
+    h = name_hash_value( sym_values_table[i].sym_name ) % sym_values_size;
+    sym_values_table[i].hash_next = sym_hash_heads[h];
+    sym_hash_heads[h] = i;
+    sym_values_num++;
 }
 
 
@@ -749,25 +910,36 @@ void  add_new_sym_to_symtab( char * name, int value )
 void  add_new_abs_to_abstab( char * name, t_value value )
 {
     int i;
+    unsigned int h;
+    void * p;
 
     if (name == NULL) return;
 
-    if (abs_values_num < MAX_ABS_VALUES_NUM) {
-        for( i=0; i<abs_values_num; i++ ) {
-          if (strcasecmp(name,abs_values_table[i].abs_name) == 0) {
-            fprintf( stderr, "ERROR: duplicate absolute value found (%s,%d:%s).\n", name,i,abs_values_table[i].abs_name );
-            return;
-          }
-        }
-        i = abs_values_num;
-        abs_values_table[i].abs_value = value;
-        strncpy( abs_values_table[i].abs_name, name, MAX_ABS_VALUE_NAME_SIZE );
-        abs_values_num++;
-    }
-    else {
-        fprintf( stderr, "ERROR: absolute values table is fully occupied (%d,%d).\n", abs_values_num, MAX_ABS_VALUES_NUM );
+    i = find_abs_value_index( name );
+    if (i >= 0) {
+        fprintf( stderr, "ERROR: duplicate absolute value found (%s,%d:%s).\n", name,i,abs_values_table[i].abs_name );
         return;
     }
+
+    if (abs_values_num >= abs_values_size) {
+        p = grow_name_table( abs_values_table, &abs_values_size, sizeof(ABSOLUTE_VALUE),
+                             INIT_ABS_VALUES_NUM, &abs_hash_heads );
+        if (p == NULL) {
+            fprintf( stderr, "ERROR: no memory for absolute values table (%d).\n", abs_values_num );
+            exit(13);
+        }
+        abs_values_table = (PABSOLUTE_VALUE) p;
+        rehash_abs_values_table();
+    }
+
+    i = abs_values_num;
+    memset( &abs_values_table[i], 0, sizeof(ABSOLUTE_VALUE) );
+    abs_values_table[i].abs_value = value;
+    strncpy( abs_values_table[i].abs_name, name, MAX_ABS_VALUE_NAME_SIZE );
+    h = name_hash_value( abs_values_table[i].abs_name ) % abs_values_size;
+    abs_values_table[i].hash_next = abs_hash_heads[h];
+    abs_hash_heads[h] = i;
+    abs_values_num++;
 }
 
 
@@ -994,9 +1166,7 @@ void  parse_input_assembly_file( char * filename, PSYM_TABLES  p_sym_tables )
   fp = fopen( filename, "rt" );
   if (fp == NULL) return;
 
-  memset( big_text_buf, 0, sizeof(big_text_buf) );
-
-  while( fgets(big_text_buf,sizeof(big_text_buf)-1,fp) != NULL) {
+  while( read_text_line(fp) != NULL) {
        //if (debug_parsing) printf( "%s", big_text_buf );
        read_lines_num++;
        s = strchr(big_text_buf,'\r');
@@ -1004,9 +1174,11 @@ void  parse_input_assembly_file( char * filename, PSYM_TABLES  p_sym_tables )
        s = strchr(big_text_buf,'\n');
        if (s != NULL) *s = '\0';
 
-       if (read_lines_num > MAX_PARSED_LINES) {
-         fprintf( stderr, "ERROR: max. parsed lines limit reached (%d,%d).\n", read_lines_num, MAX_PARSED_LINES );
-         return;
+       if (read_lines_num > parsed_lines_size) {
+         if (grow_parsed_lines_array() != 0) {
+           fprintf( stderr, "ERROR: no memory for parsed lines (%d).\n", read_lines_num );
+           return;
+         }
        }
 
        slen = strlen(big_text_buf);
@@ -1774,6 +1946,136 @@ void  produce_output_listing_file( char * filename )
 
 
 
+/*
+ *  Produce symbol/line map file for emulator (text format)
+ *
+ *  ; comment
+ *  @ssss              program start address
+ *  S aaaa name        label (symbolic value)
+ *  A vvvvvvvvvvvvvvv name   absolute value
+ *  L aaaa nnnnn       source line number for address
+ */
+
+void  write_map_data( FILE * fp )
+{
+  int  i;
+
+  fprintf( fp, "; M-20 symbol map: %s\n", module_name );
+  fprintf( fp, "@%04o\n", program_start_address & MAX_ADDR_VALUE );
+
+  for( i=0; i<sym_values_num; i++ )
+      fprintf( fp, "S %04o %s\n", sym_values_table[i].sym_value & MAX_ADDR_VALUE, sym_values_table[i].sym_name );
+
+  for( i=0; i<abs_values_num; i++ )
+      fprintf( fp, "A %015llo %s\n", abs_values_table[i].abs_value, abs_values_table[i].abs_name );
+
+  for(i=0;i<read_lines_num;i++) {
+      if (parsed_lines_array[i].skip_this_line) continue;
+      if (parsed_lines_array[i].this_code || parsed_lines_array[i].this_data)
+          fprintf( fp, "L %04o %05d\n", parsed_lines_array[i].obj_code_line.location_addr & MAX_ADDR_VALUE,
+                   parsed_lines_array[i].line_num );
+  }
+}
+
+
+void  produce_output_map_file( char * filename )
+{
+  FILE * fp;
+
+  if (filename == NULL) return;
+
+  if (verbose) printf( "Make map filename: %s\n", filename );
+
+  fp = fopen( filename, "wt" );
+  if (fp == NULL) return;
+
+  write_map_data( fp );
+
+  fclose(fp);
+
+}
+
+
+
+
+/*
+ *  Produce binary object M-20 file (see M20_OBJ_xxx in m20_defs.h)
+ *  Consecutive words are written as runs, symbol map is appended.
+ */
+
+static void  put_le_value( unsigned char * p, t_value value, int size )
+{
+  int  i;
+
+  for( i=0; i<size; i++ ) p[i] = (unsigned char)((value >> (i*8)) & 0xFF);
+}
+
+
+void  produce_output_binary_file( char * filename )
+{
+  FILE * fp;
+  int  i, j, k;
+  int  runs_num = 0;
+  int  run_addr, run_len;
+  long map_pos, map_end;
+  unsigned char  hdr[M20_OBJ_HEADER_SIZE];
+  unsigned char  buf[M20_OBJ_WORD_SIZE];
+
+  if (filename == NULL) return;
+
+  if (verbose) printf( "Make binary object filename: %s\n", filename );
+
+  fp = fopen( filename, "wb" );
+  if (fp == NULL) return;
+
+  memset( hdr, 0, sizeof(hdr) );
+  fwrite( hdr, 1, sizeof(hdr), fp );
+
+  i = 0;
+  while( i < read_lines_num ) {
+      /* collect run of consecutive addresses */
+      if (parsed_lines_array[i].skip_this_line ||
+          !(parsed_lines_array[i].this_code || parsed_lines_array[i].this_data)) { i++; continue; }
+      run_addr = parsed_lines_array[i].obj_code_line.location_addr & MAX_ADDR_VALUE;
+      run_len = 0;
+      for( j=i; j<read_lines_num; j++ ) {
+          if (parsed_lines_array[j].skip_this_line ||
+              !(parsed_lines_array[j].this_code || parsed_lines_array[j].this_data)) continue;
+          if ((parsed_lines_array[j].obj_code_line.location_addr & MAX_ADDR_VALUE) != run_addr + run_len) break;
+          run_len++;
+      }
+      put_le_value( buf, run_addr, 2 );
+      put_le_value( buf+2, run_len, 2 );
+      fwrite( buf, 1, M20_OBJ_RUN_SIZE, fp );
+      for( k=i; k<j; k++ ) {
+          if (parsed_lines_array[k].skip_this_line ||
+              !(parsed_lines_array[k].this_code || parsed_lines_array[k].this_data)) continue;
+          put_le_value( buf, parsed_lines_array[k].obj_code_line.mcode & WORD45, M20_OBJ_WORD_SIZE );
+          fwrite( buf, 1, M20_OBJ_WORD_SIZE, fp );
+      }
+      runs_num++;
+      i = j;
+  }
+
+  map_pos = ftell( fp );
+  write_map_data( fp );
+  map_end = ftell( fp );
+
+  memcpy( hdr, M20_OBJ_MAGIC, 4 );
+  put_le_value( hdr+4, M20_OBJ_VERSION, 2 );
+  put_le_value( hdr+6, program_start_address & MAX_ADDR_VALUE, 2 );
+  put_le_value( hdr+8, runs_num, 2 );
+  put_le_value( hdr+12, map_end - map_pos, 4 );
+  fseek( fp, 0, SEEK_SET );
+  fwrite( hdr, 1, sizeof(hdr), fp );
+
+  fclose(fp);
+
+}
+
+
+
+
  
 /*
  *  Print help screen
@@ -1783,7 +2085,8 @@ void usage(void)
   fprintf( stderr, "\n" );
   fprintf( stderr, "Symbolic assembly coding system for M-20, version %s\n", prog_ver );
   fprintf( stderr, "Copyright (C) 2015 Dmitry Stefankov. All rights reserved.\n" );
-  fprintf( stderr, "Usage: autocode_m20 [-hvapc] [-e enctype] [-i s20-file] [-o m20-file][-l l20-file]\n" );
+  fprintf( stderr, "Usage: autocode_m20 [-hvapc] [-e enctype] [-i s20-file] [-o m20-file][-l l20-file][-m map-file]\n"
+                   "                    [-b b20-file]\n" );
   fprintf( stderr, "       -h   this help\n" );
   fprintf( stderr, "       -v   verbose output\n" );
   fprintf( stderr, "       -a   output address codes\n" );
@@ -1793,6 +2096,8 @@ void usage(void)
   fprintf( stderr, "       -i   input file (M-20 symbolic coding file, assembly file)\n" );
   fprintf( stderr, "       -o   output file (M-20 text object file, M-20 emulator format)\n" );
   fprintf( stderr, "       -l   listing file (M-20 object code listing file, w/sym_tables)\n" );
+  fprintf( stderr, "       -m   map file (symbols and source lines for emulator, LOAD -S)\n" );
+  fprintf( stderr, "       -b   binary object file (M-20 emulator format, with symbol map)\n" );
   fprintf( stderr, "Default parameters:\n" );
   fprintf( stderr, "   encoding_types: 0=auto,1=ascii-7,2=cp866,3=cp1251,4=koi8r,5=utf8\n" );
   fprintf( stderr, "   table file for encoding type 1: %s\n", m20_eng_tab_filename );
@@ -1824,7 +2129,7 @@ int main( int argc, char ** argv )
 
 /* Process command line  */  
   opterr = 0;
-  while( (op = getopt(argc,argv,"acvphe:i:o:l:")) != -1)
+  while( (op = getopt(argc,argv,"acvphe:i:o:l:m:b:")) != -1)
     switch(op) {
       case 'e':
                encoding_type = atoi(optarg);
@@ -1838,6 +2143,12 @@ int main( int argc, char ** argv )
       case 'l':
                list_file = optarg;
       	       break;       
+      case 'm':
+               map_file = optarg;
+      	       break;       
+      case 'b':
+               bin_file = optarg;
+      	       break;       
       case 'a':
                out_address_code = 1;
                break;
@@ -1941,12 +2252,11 @@ int main( int argc, char ** argv )
       exit(12);
   }
 
-  // Zeroing
-  memset( parsed_lines_array, 0, sizeof(parsed_lines_array) );
-
   parse_input_assembly_file( in_file, p_cur_sym_tables );
   produce_output_object_file( out_file );
   if (list_file != NULL) produce_output_listing_file( list_file );
+  if (map_file != NULL) produce_output_map_file( map_file );
+  if (bin_file != NULL) produce_output_binary_file( bin_file );
 
   if (0) goto all_done;
 
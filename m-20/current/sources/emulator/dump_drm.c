@@ -10,6 +10,7 @@
  *
  *  04-Mar-2015  DVS  Initial Implemementation
  *  28-Jun-2021  DVS  Added support of getopt() for xBSD
+ *  19-Oct-2026  DVS  Added sparse drum images (read and -s conversion)
  *
  */
 
@@ -53,6 +54,7 @@ extern  int        opterr;
 extern  char     * optarg;
 
 char         * in_file = NULL;
+char         * sparse_file = NULL;
 int           verbose = 0;
 int           quiet = 0;
 int           auto_skip_zero_address = 0;
@@ -60,8 +62,13 @@ int           auto_skip_zero_address = 0;
 static unsigned char big_text_buf[MAX_TEXT_BUF_SIZE];
 static unsigned char out_text_buf[MAX_TEXT_BUF_SIZE+128];
 
+static t_value       drum_words[DRUM_SIZE];
+static t_value       drum_map[DRUM_SPARSE_MAP_WORDS];
+static t_value       drum_tab[DRUM_SPARSE_BLOCKS];
+static t_value       zero_block[DRUM_SPARSE_BLOCK];
 
-const char prog_ver[] = "1.0.0";
+
+const char prog_ver[] = "1.1.0";
 const char rcs_id[] = "$Id$";
 
 
@@ -78,13 +85,15 @@ void usage(void)
   fprintf( stderr, "\n" );
   fprintf( stderr, "Dump magnetic drum storage in text format, version %s\n", prog_ver );
   fprintf( stderr, "Copyright (C) 2015 Dmitry Stefankov. All rights reserved.\n" );
-  fprintf( stderr, "Usage: dump_drm [-hzv [-i drum-file]\n" );
+  fprintf( stderr, "Usage: dump_drm [-hzv] [-s sparse-file] [-i drum-file]\n" );
   fprintf( stderr, "       -h   this help\n" );
   fprintf( stderr, "       -v   verbose output\n" );
   fprintf( stderr, "       -z   disable auto_skip_zero_address\n" );
+  fprintf( stderr, "       -s   write drum contents as sparse image (ATTACH -S)\n" );
   fprintf( stderr, "Default parameters:\n" );
   fprintf( stderr, "Sample command line:\n" );
   fprintf( stderr, "   ./dump_drm  -i mydrum.drum0 \n" );
+  fprintf( stderr, "   ./dump_drm  -i mydrum.drum0 -s mydrum_sparse.drum0\n" );
   fprintf( stderr, "\n" );
   exit(1);
 }
@@ -92,6 +101,83 @@ void usage(void)
 
 
 
+/*
+ *  Read sparse drum image (magic is already read)
+ */
+int read_sparse_image( FILE * fp_in )
+{
+  t_value   hdr[DRUM_SPARSE_HDR_WORDS-1];
+  int       b;
+
+  if ((fread( hdr, sizeof(t_value), DRUM_SPARSE_HDR_WORDS-1, fp_in ) != DRUM_SPARSE_HDR_WORDS-1) ||
+      (hdr[0] != DRUM_SPARSE_VERSION) || (hdr[1] != DRUM_SIZE) || (hdr[2] != DRUM_SPARSE_BLOCK) ||
+      (fread( drum_map, sizeof(t_value), DRUM_SPARSE_MAP_WORDS, fp_in ) != DRUM_SPARSE_MAP_WORDS) ||
+      (fread( drum_tab, sizeof(t_value), DRUM_SPARSE_BLOCKS, fp_in ) != DRUM_SPARSE_BLOCKS)) {
+    return(-1);
+  }
+  for( b=0; b<DRUM_SPARSE_BLOCKS; b++ ) {
+    if (drum_tab[b] == 0) continue;
+    if ((fseek( fp_in, (long)drum_tab[b], SEEK_SET ) != 0) ||
+        (fread( &drum_words[b*DRUM_SPARSE_BLOCK], sizeof(t_value), DRUM_SPARSE_BLOCK, fp_in ) != DRUM_SPARSE_BLOCK)) {
+      return(-1);
+    }
+  }
+  return(0);
+}
+
+
+
+/*
+ *  Write sparse drum image
+ */
+int write_sparse_image( const char * name )
+{
+  FILE *    fp_out;
+  t_value   hdr[DRUM_SPARSE_HDR_WORDS-1];
+  t_value   tab[DRUM_SPARSE_BLOCKS];
+  t_value   pos = DRUM_SPARSE_DATA_POS;
+  int       a, b, used;
+
+  memset( hdr, 0, sizeof(hdr) );
+  hdr[0] = DRUM_SPARSE_VERSION;
+  hdr[1] = DRUM_SIZE;
+  hdr[2] = DRUM_SPARSE_BLOCK;
+  for( b=0; b<DRUM_SPARSE_BLOCKS; b++ ) {
+    used = 0;
+    for( a=b*DRUM_SPARSE_BLOCK; a<(b+1)*DRUM_SPARSE_BLOCK; a++ ) {
+      if ((drum_map[a >> 6] >> (a & 077)) & 1) used = 1;
+    }
+    tab[b] = 0;
+    if (used) {
+      tab[b] = pos;
+      pos += DRUM_SPARSE_BLOCK * sizeof(t_value);
+    }
+  }
+
+  fp_out = fopen( name, "wb" );
+  if (fp_out == NULL) return(-1);
+  fwrite( DRUM_SPARSE_MAGIC, 1, 8, fp_out );
+  fwrite( hdr, sizeof(t_value), DRUM_SPARSE_HDR_WORDS-1, fp_out );
+  fwrite( drum_map, sizeof(t_value), DRUM_SPARSE_MAP_WORDS, fp_out );
+  fwrite( tab, sizeof(t_value), DRUM_SPARSE_BLOCKS, fp_out );
+  for( b=0; b<DRUM_SPARSE_BLOCKS; b++ ) {
+    if (tab[b] == 0) continue;
+    /* words which were never written are stored as zero */
+    for( a=b*DRUM_SPARSE_BLOCK; a<(b+1)*DRUM_SPARSE_BLOCK; a++ ) {
+      zero_block[a - b*DRUM_SPARSE_BLOCK] = ((drum_map[a >> 6] >> (a & 077)) & 1) ? drum_words[a] : 0;
+    }
+    fwrite( zero_block, sizeof(t_value), DRUM_SPARSE_BLOCK, fp_out );
+  }
+  if (ferror(fp_out)) {
+    fclose(fp_out);
+    return(-1);
+  }
+  fclose(fp_out);
+  return(0);
+}
+
+
+
 /*
  *  Main program stream
  */
@@ -100,20 +186,26 @@ int main( int argc, char ** argv )
   int                 ret_code = 0;
   int                 op;
   FILE *              fp_in = NULL;
-  t_value             value;
   size_t              read_count;
   size_t              total_nwords = 0;
   int                 addr = 0;
+  int                 i;
+  int                 sparse = 0;
+  int                 last_printed = -1;
+  char                magic[8];
 
 /* Initialize */
 
 /* Process command line  */  
   opterr = 0;
-  while( (op = getopt(argc,argv,"vhi:z")) != -1)
+  while( (op = getopt(argc,argv,"vhi:s:z")) != -1)
     switch(op) {
       case 'i':
                in_file = optarg;
       	       break;       
+      case 's':
+               sparse_file = optarg;
+      	       break;       
       case 'v':
                verbose = 1;
       	       break;       
@@ -137,26 +229,57 @@ int main( int argc, char ** argv )
     return(10);
   }
 
-  printf( "File: %s\n\n", in_file );
+  /* Load drum image: flat file of words or sparse image */
+  read_count = fread( magic, 1, sizeof(magic), fp_in );
+  if ((read_count == sizeof(magic)) && (memcmp( magic, DRUM_SPARSE_MAGIC, sizeof(magic) ) == 0)) {
+    sparse = 1;
+    if (read_sparse_image( fp_in ) != 0) {
+      fprintf( stderr, "ERROR: bad sparse drum image %s!\n", in_file );
+      fclose(fp_in);
+      return(11);
+    }
+  }
+  else {
+    fseek( fp_in, 0, SEEK_SET );
+    read_count = fread( drum_words, sizeof(t_value), DRUM_SIZE, fp_in );
+    for( i=0; i<(int)read_count; i++ ) drum_map[i >> 6] |= (t_value)1 << (i & 077);
+  }
+
+  if (sparse_file != NULL) {
+    if (write_sparse_image( sparse_file ) != 0) {
+      fprintf( stderr, "ERROR: cannot write file %s!\n", sparse_file );
+      ret_code = 12;
+    }
+    else if (verbose) printf( "Sparse drum image %s written.\n", sparse_file );
+    goto all_done;
+  }
+
+  printf( "File: %s%s\n\n", in_file, sparse ? " (sparse image)" : "" );
 
   if (verbose) printf( "Dump drum storage contents.\n" );
 
   if (auto_skip_zero_address) addr = 1;
 
-  while( 1 ) {
-     if ((addr & 7) == 0) {
-       printf( ":%04o\n", addr );
-     }
-     if (auto_skip_zero_address && (addr==1)) {
-       printf( ":%04o\n", addr );
+  for( i=0; ; i++, addr++ ) {
+     if (sparse) {
+       /* only initialized words, address label after gap */
+       if (i >= DRUM_SIZE) break;
+       if (!((drum_map[i >> 6] >> (i & 077)) & 1)) continue;
+       if (((addr & 7) == 0) || (last_printed != i-1) || (auto_skip_zero_address && (addr==1))) {
+         printf( ":%04o\n", addr );
+       }
+       last_printed = i;
      }
-     addr++;
-     value = 0;
-     read_count = fread( &value, sizeof(value), 1, fp_in );
-     if (read_count != 1) {
-       break;
+     else {
+       if ((addr & 7) == 0) {
+         printf( ":%04o\n", addr );
+       }
+       if (auto_skip_zero_address && (addr==1)) {
+         printf( ":%04o\n", addr );
+       }
+       if (i >= DRUM_SIZE || !((drum_map[i >> 6] >> (i & 077)) & 1)) break;
      }
-     printf( "%015llo\n", value );
+     printf( "%015llo\n", drum_words[i] );
      total_nwords++;
   }
 
@@ -164,7 +287,7 @@ int main( int argc, char ** argv )
 
   if (verbose) printf( "Dump drum storage contents completed.\n" );
 
-//all_done:
+all_done:
   if (fp_in  != NULL) fclose(fp_in);
 
   return(ret_code);
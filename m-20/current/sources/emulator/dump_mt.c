@@ -10,6 +10,7 @@
  *
  *  04-Mar-2015  DVS  Initial Implemementation
  *  28-Jun-2021  DVS  Added support of getopt() for xBSD
+ *  19-Oct-2026  DVS  Added compressed tape container (read, -c and -x conversion)
  *
  */
 
@@ -53,14 +54,19 @@ extern  int        opterr;
 extern  char     * optarg;
 
 char         * in_file = NULL;
+char         * cont_file = NULL;
+char         * flat_file = NULL;
 int           verbose = 0;
 int           quiet = 0;
 
 static unsigned char big_text_buf[MAX_TEXT_BUF_SIZE];
 static unsigned char out_text_buf[MAX_TEXT_BUF_SIZE+128];
 
+static t_value     * tape_words = NULL;
+static long          tape_nwords = 0;
 
-const char prog_ver[] = "1.0.0";
+
+const char prog_ver[] = "1.1.0";
 const char rcs_id[] = "$Id$";
 
 
@@ -77,12 +83,15 @@ void usage(void)
   fprintf( stderr, "\n" );
   fprintf( stderr, "Dump magnetic tape storage in text format, version %s\n", prog_ver );
   fprintf( stderr, "Copyright (C) 2015 Dmitry Stefankov. All rights reserved.\n" );
-  fprintf( stderr, "Usage: dump_mt [-hv [-i mt-file]\n" );
+  fprintf( stderr, "Usage: dump_mt [-hv] [-c cont-file] [-x flat-file] [-i mt-file]\n" );
   fprintf( stderr, "       -h   this help\n" );
   fprintf( stderr, "       -v   verbose output\n" );
+  fprintf( stderr, "       -c   write tape as compressed container (ATTACH -C)\n" );
+  fprintf( stderr, "       -x   write tape as flat image\n" );
   fprintf( stderr, "Default parameters:\n" );
   fprintf( stderr, "Sample command line:\n" );
   fprintf( stderr, "   ./dump_mt  -i mytape.mt0 \n" );
+  fprintf( stderr, "   ./dump_mt  -i mytape.mt0 -c mytape_cont.mt0\n" );
   fprintf( stderr, "\n" );
   exit(1);
 }
@@ -90,6 +99,183 @@ void usage(void)
 
 
 
+/*
+ *  Read n words coded as runs of container
+ */
+int get_runs( FILE * fp_in, t_value * w, long n )
+{
+  t_value   ctl;
+  long      i = 0, j, cnt;
+
+  while( i < n ) {
+    if (fread( &ctl, sizeof(t_value), 1, fp_in ) != 1) return(-1);
+    cnt = (long)(ctl & 0xFFFFFFFF);
+    if ((cnt <= 0) || (cnt > n-i)) return(-1);
+    if ((ctl >> BITS_32) == MT_CONT_REPEAT) {
+      if (fread( &w[i], sizeof(t_value), 1, fp_in ) != 1) return(-1);
+      for( j=1; j<cnt; j++ ) w[i+j] = w[i];
+    }
+    else if ((ctl >> BITS_32) == MT_CONT_LITERAL) {
+      if (fread( &w[i], sizeof(t_value), cnt, fp_in ) != (size_t)cnt) return(-1);
+    }
+    else return(-1);
+    i += cnt;
+  }
+  return(0);
+}
+
+
+
+/*
+ *  Write words of zone as runs of container
+ */
+void put_runs( FILE * fp_out, t_value * w, long n )
+{
+  t_value   ctl;
+  long      i = 0, r, l;
+
+  while( i < n ) {
+    for( r=1; (i+r < n) && (w[i+r] == w[i]); r++ ) ;
+    if (r >= MT_CONT_MIN_REPEAT) {
+      ctl = ((t_value)MT_CONT_REPEAT << BITS_32) | (t_value)r;
+      fwrite( &ctl, sizeof(t_value), 1, fp_out );
+      fwrite( &w[i], sizeof(t_value), 1, fp_out );
+      i += r;
+      continue;
+    }
+    for( l=i+1; l<n; l++ ) {
+      if ((l+2 < n) && (w[l] == w[l+1]) && (w[l] == w[l+2])) break;
+    }
+    ctl = ((t_value)MT_CONT_LITERAL << BITS_32) | (t_value)(l-i);
+    fwrite( &ctl, sizeof(t_value), 1, fp_out );
+    fwrite( &w[i], sizeof(t_value), l-i, fp_out );
+    i = l;
+  }
+}
+
+
+
+/*
+ *  Read compressed tape container (magic is already read)
+ */
+int read_container( FILE * fp_in )
+{
+  t_value   hdr[MT_CONT_HDR_WORDS-1];
+  t_value * dir;
+  long      ndir, i, pos = 0;
+  int       res = -1;
+
+  if ((fread( hdr, sizeof(t_value), MT_CONT_HDR_WORDS-1, fp_in ) != MT_CONT_HDR_WORDS-1) ||
+      (hdr[0] != MT_CONT_VERSION)) {
+    return(-1);
+  }
+  tape_nwords = (long)hdr[1];
+  ndir = (long)hdr[2];
+  if ((tape_nwords < 0) || (ndir < 0) || (ndir > tape_nwords)) return(-1);
+  tape_words = (t_value *)malloc( (tape_nwords+1)*sizeof(t_value) );
+  dir = (t_value *)malloc( (ndir*MT_CONT_DIR_WORDS+1)*sizeof(t_value) );
+  if ((tape_words == NULL) || (dir == NULL)) goto done;
+  if ((fseek( fp_in, (long)hdr[3], SEEK_SET ) != 0) ||
+      (fread( dir, sizeof(t_value), ndir*MT_CONT_DIR_WORDS, fp_in ) != (size_t)(ndir*MT_CONT_DIR_WORDS))) {
+    goto done;
+  }
+  for( i=0; i<ndir; i++ ) {
+    t_value * e = &dir[i*MT_CONT_DIR_WORDS];
+    if (((long)e[1] != pos) || ((long)e[2] > tape_nwords-pos)) goto done;
+    if (fseek( fp_in, (long)e[3], SEEK_SET ) != 0) goto done;
+    if (get_runs( fp_in, &tape_words[pos], (long)e[2] ) != 0) goto done;
+    pos += (long)e[2];
+  }
+  if (pos == tape_nwords) res = 0;
+
+done:
+  if (dir != NULL) free(dir);
+  return(res);
+}
+
+
+
+/*
+ *  Write compressed tape container
+ */
+int write_container( const char * name )
+{
+  FILE *    fp_out;
+  t_value   hdr[MT_CONT_HDR_WORDS-1];
+  t_value * dir;
+  long      pos = 0, ndir = 0, n;
+  int       size;
+
+  dir = (t_value *)malloc( (tape_nwords+1)*MT_CONT_DIR_WORDS*sizeof(t_value) );
+  if (dir == NULL) return(-1);
+  fp_out = fopen( name, "wb" );
+  if (fp_out == NULL) {
+    free(dir);
+    return(-1);
+  }
+  memset( hdr, 0, sizeof(hdr) );
+  fwrite( MT_CONT_MAGIC, 1, 8, fp_out );
+  fwrite( hdr, sizeof(t_value), MT_CONT_HDR_WORDS-1, fp_out );
+
+  /* zones, then irregular tail */
+  while( pos < tape_nwords ) {
+    t_value * e = &dir[ndir*MT_CONT_DIR_WORDS];
+    size = (int)(tape_words[pos] >> BITS_32);
+    if ((size >= 0) && (size <= MAX_TAPE_ZONE_SIZE) && (pos+size+2 <= tape_nwords)) {
+      n = size+2;
+      e[0] = tape_words[pos];
+    }
+    else {
+      n = tape_nwords-pos;
+      e[0] = MT_CONT_TAIL;
+    }
+    e[1] = pos;
+    e[2] = n;
+    e[3] = ftell(fp_out);
+    put_runs( fp_out, &tape_words[pos], n );
+    pos += n;
+    ndir++;
+  }
+
+  hdr[0] = MT_CONT_VERSION;
+  hdr[1] = tape_nwords;
+  hdr[2] = ndir;
+  hdr[3] = ftell(fp_out);
+  fwrite( dir, sizeof(t_value), ndir*MT_CONT_DIR_WORDS, fp_out );
+  hdr[4] = ftell(fp_out);
+  fseek( fp_out, sizeof(t_value), SEEK_SET );
+  fwrite( hdr, sizeof(t_value), MT_CONT_HDR_WORDS-1, fp_out );
+  free(dir);
+  if (ferror(fp_out)) {
+    fclose(fp_out);
+    return(-1);
+  }
+  fclose(fp_out);
+  return(0);
+}
+
+
+
+/*
+ *  Write flat tape image
+ */
+int write_flat( const char * name )
+{
+  FILE *    fp_out;
+
+  fp_out = fopen( name, "wb" );
+  if (fp_out == NULL) return(-1);
+  fwrite( tape_words, sizeof(t_value), tape_nwords, fp_out );
+  if (ferror(fp_out)) {
+    fclose(fp_out);
+    return(-1);
+  }
+  fclose(fp_out);
+  return(0);
+}
+
+
+
 /*
  *  Main program stream
  */
@@ -102,16 +288,25 @@ int main( int argc, char ** argv )
   size_t              read_count;
   size_t              total_nwords = 0;
   int                 cur_zone_num, cur_zone_size;
+  long                pos = 0;
+  int                 cont = 0;
+  char                magic[8];
 
 /* Initialize */
 
 /* Process command line  */  
   opterr = 0;
-  while( (op = getopt(argc,argv,"vhi:")) != -1)
+  while( (op = getopt(argc,argv,"vhi:c:x:")) != -1)
     switch(op) {
       case 'i':
                in_file = optarg;
       	       break;       
+      case 'c':
+               cont_file = optarg;
+      	       break;       
+      case 'x':
+               flat_file = optarg;
+      	       break;       
       case 'v':
                verbose = 1;
       	       break;       
@@ -133,16 +328,51 @@ int main( int argc, char ** argv )
   }
 
 
-  printf( "File: %s\n\n", in_file );
+  /* Load tape image: flat file of zones or compressed container */
+  read_count = fread( magic, 1, sizeof(magic), fp_in );
+  if ((read_count == sizeof(magic)) && (memcmp( magic, MT_CONT_MAGIC, sizeof(magic) ) == 0)) {
+    cont = 1;
+    if (read_container( fp_in ) != 0) {
+      fprintf( stderr, "ERROR: bad tape container %s!\n", in_file );
+      fclose(fp_in);
+      return(11);
+    }
+  }
+  else {
+    fseek( fp_in, 0, SEEK_END );
+    tape_nwords = ftell(fp_in) / (long)sizeof(t_value);
+    fseek( fp_in, 0, SEEK_SET );
+    tape_words = (t_value *)malloc( (tape_nwords+1)*sizeof(t_value) );
+    if (tape_words == NULL) {
+      fprintf( stderr, "ERROR: no memory for file %s!\n", in_file );
+      fclose(fp_in);
+      return(11);
+    }
+    tape_nwords = (long)fread( tape_words, sizeof(t_value), tape_nwords, fp_in );
+  }
+
+  if ((cont_file != NULL) || (flat_file != NULL)) {
+    if ((cont_file != NULL) && (write_container( cont_file ) != 0)) {
+      fprintf( stderr, "ERROR: cannot write file %s!\n", cont_file );
+      ret_code = 12;
+    }
+    if ((flat_file != NULL) && (write_flat( flat_file ) != 0)) {
+      fprintf( stderr, "ERROR: cannot write file %s!\n", flat_file );
+      ret_code = 12;
+    }
+    if (verbose && (ret_code == 0)) printf( "%ld words of tape written.\n", tape_nwords );
+    goto all_done;
+  }
+
+  printf( "File: %s%s\n\n", in_file, cont ? " (compressed container)" : "" );
 
   if (verbose) printf( "Dump mtape storage contents.\n" );
 
   while( 1 ) {
-     value = 0;
-     read_count = fread( &value, sizeof(value), 1, fp_in );
-     if (read_count != 1) {
+     if (pos >= tape_nwords) {
        break;
      }
+     value = tape_words[pos++];
      total_nwords++;
      /* extract zone number and length */
      cur_zone_num = value & 0xFFFFFFF;
@@ -152,21 +382,19 @@ int main( int argc, char ** argv )
      printf( "****** ZONE %lu, LEN = %lu\n", cur_zone_num, cur_zone_size );
      /* read user words */
      while( cur_zone_size-- ) {
-       value = 0;
-       read_count = fread( &value, sizeof(value), 1, fp_in );
-       if (read_count != 1) {
+       if (pos >= tape_nwords) {
          //break;
          goto done;
        }
+       value = tape_words[pos++];
        printf( "%015llo\n", value );
        total_nwords++;
      }
      /* read checksum */
-     value = 0;
-     read_count = fread( &value, sizeof(value), 1, fp_in );
-     if (read_count != 1) {
+     if (pos >= tape_nwords) {
          break;
      }
+     value = tape_words[pos++];
      printf( "*** CHKSUM: %015llo\n\n", value );
      total_nwords++;
   }
@@ -176,7 +404,8 @@ done:
 
   if (verbose) printf( "Dump drum storage contents completed.\n" );
 
-
+all_done:
+  if (tape_words != NULL) free(tape_words);
   if (fp_in  != NULL) fclose(fp_in);
 
   return(ret_code);
@@ -0,0 +1,369 @@
+/*
+ * File:     libm20.c
+ * Purpose:  M-20 simulator embedding interface (libm20)
+ *
+ * Copyright (c) 2026, Dmitry Stefankov
+ *
+ * $Id$
+ *
+ * Library build of the simulator:  SIMH runtime is initialized in
+ * the same way as scp.c main() does it, but no command line,
+ * startup banner and command files are processed.  Library uses
+ * scp.c compiled with -Dmain=scp_main (see makefiles).
+ *
+ * Revision History.
+ *
+ *  19-Oct-2026  DVS  Initial Implementation
+ *  19-Oct-2026  DVS  M20_LIB_BUDGET differs from success (0)
+ *
+ */
+
+
+#include "m20_defs.h"
+#include "libm20.h"
+
+
+#define M20_LIB_IMAGE_NAME  "libm20.image"
+#define M20_LIB_LPT_NAME    "libm20.lpt"
+#define M20_LIB_RUN_CHUNK   0x40000000
+
+
+/* external references (SIMH) */
+
+extern DEVICE sim_scp_dev;
+extern DEVICE sim_expect_dev;
+extern DEVICE sim_step_dev;
+extern DEVICE sim_flush_dev;
+extern DEVICE sim_runlimit_dev;
+
+extern t_stat sim_brk_init (void);
+extern t_stat detach_all (int32 start_device, t_bool shutdown);
+extern void   sim_init_sock (void);
+
+/* external references (M-20) */
+
+extern UNIT     lpt_unit;
+
+extern int      print_sys_stat;
+
+extern uint16   regKRA;
+extern uint16   regRA;
+extern int      trgSW;
+extern t_value  regRR;
+extern t_value  RPU1;
+extern t_value  RPU2;
+extern t_value  RPU3;
+extern t_value  RPU4;
+extern t_value  MOSU[MAX_MEM_SIZE];
+
+extern t_stat   cpu_examine (t_value *vptr, t_addr addr, UNIT *uptr, int32 sw);
+extern t_stat   cpu_deposit (t_value val, t_addr addr, UNIT *uptr, int32 sw);
+
+extern t_stat       m20_mem_put (const char * name, const void * data, size_t size);
+extern const void * m20_mem_get (const char * name, size_t * size);
+extern t_stat       m20_mem_free (const char * name);
+extern void         m20_mem_free_all (void);
+extern FILE *       m20_mem_fopen (const char * name, int read_only, int create);
+extern int          m20_mem_fclose (FILE * fp);
+
+
+/* Machine handle (simulator state is global, so only one exists) */
+struct m20_machine {
+    int   created;
+};
+
+static m20_machine  lib_machine = { 0 };
+static int          lib_initialized = 0;
+
+
+
+/*
+ *  One-time SIMH runtime initialization (see scp.c main)
+ */
+static t_stat m20_lib_init (void)
+{
+    t_stat r;
+
+    if (lib_initialized) return SCPE_OK;
+
+    if (stdnul == NULL) stdnul = fopen (NULL_DEVICE, "wb");
+    sim_quiet = 1;
+    sim_init_sock ();
+    AIO_INIT;
+    sim_finit ();
+    stop_cpu = FALSE;
+    sim_interval = 0;
+    sim_clock_queue = QUEUE_LIST_END;
+    sim_is_running = FALSE;
+    sim_log = NULL;
+    if (sim_emax <= 0) sim_emax = 1;
+    if (sim_timer_init ()) return SCPE_IERR;
+
+    sim_register_internal_device (&sim_scp_dev);
+    sim_register_internal_device (&sim_expect_dev);
+    sim_register_internal_device (&sim_step_dev);
+    sim_register_internal_device (&sim_flush_dev);
+    sim_register_internal_device (&sim_runlimit_dev);
+
+    if ((r = sim_ttinit ()) != SCPE_OK) return r;
+    if ((sim_eval = (t_value *) calloc (sim_emax, sizeof (t_value))) == NULL) return SCPE_MEM;
+    if (sim_dflt_dev == NULL) sim_dflt_dev = sim_devices[0];
+    if ((r = reset_all_p (0)) != SCPE_OK) return r;
+    if ((r = sim_brk_init ()) != SCPE_OK) return r;
+
+    print_sys_stat = 0;                 /* no reports to stdout (DEPOSIT PRINT_SYS_STAT 1) */
+    lib_initialized = 1;
+    return SCPE_OK;
+}
+
+
+
+/*
+ *  Create and destroy machine
+ */
+m20_machine * m20_lib_create (void)
+{
+    if (lib_machine.created) return NULL;
+    if (m20_lib_init () != SCPE_OK) return NULL;
+
+    lib_machine.created = 1;
+    if ((m20_lib_reset (&lib_machine, TRUE) != SCPE_OK) ||
+        (m20_lib_printer_clear (&lib_machine) != SCPE_OK)) {
+        m20_lib_destroy (&lib_machine);
+        return NULL;
+    }
+    return &lib_machine;
+}
+
+
+void m20_lib_destroy (m20_machine * m)
+{
+    if ((m != &lib_machine) || !m->created) return;
+
+    detach_all (0, TRUE);
+    m20_mem_free_all ();
+    m->created = 0;
+}
+
+
+int m20_lib_reset (m20_machine * m, int clear_memory)
+{
+    if ((m != &lib_machine) || !m->created) return SCPE_ARG;
+
+    if (clear_memory) {
+        memset (MOSU, 0, sizeof(MOSU));
+        regKRA = 0;
+        regRA = 0;
+        regRR = 0;
+        trgSW = 0;
+    }
+    sim_step = 0;
+    return sim_run_boot_prep (RU_BOOT);
+}
+
+
+
+/*
+ *  Load program image from buffer
+ */
+int m20_lib_load_image (m20_machine * m, const void * data, size_t size)
+{
+    FILE * f;
+    t_stat r;
+
+    if ((m != &lib_machine) || !m->created || (data == NULL)) return SCPE_ARG;
+
+    r = m20_mem_put (M20_LIB_IMAGE_NAME, data, size);
+    if (r != SCPE_OK) return r;
+    f = m20_mem_fopen (M20_LIB_IMAGE_NAME, TRUE, FALSE);
+    if (f == NULL) {
+        m20_mem_free (M20_LIB_IMAGE_NAME);
+        return SCPE_OPENERR;
+    }
+    sim_switches = 0;
+    r = sim_load (f, "", M20_LIB_IMAGE_NAME, 0);
+    m20_mem_fclose (f);
+    m20_mem_free (M20_LIB_IMAGE_NAME);
+
+    return r;
+}
+
+
+
+/*
+ *  Registers and memory
+ */
+static t_value * m20_lib_key_reg (int n)
+{
+    switch (n) {
+      case 1:  return &RPU1;
+      case 2:  return &RPU2;
+      case 3:  return &RPU3;
+      case 4:  return &RPU4;
+    }
+    return NULL;
+}
+
+
+int m20_lib_set_key (m20_machine * m, int n, m20_word value)
+{
+    t_value * reg = m20_lib_key_reg (n);
+
+    if ((m != &lib_machine) || (reg == NULL)) return SCPE_ARG;
+    *reg = (t_value) value & WORD45;
+    return SCPE_OK;
+}
+
+
+int m20_lib_get_key (m20_machine * m, int n, m20_word * value)
+{
+    t_value * reg = m20_lib_key_reg (n);
+
+    if ((m != &lib_machine) || (reg == NULL) || (value == NULL)) return SCPE_ARG;
+    *value = (m20_word) *reg;
+    return SCPE_OK;
+}
+
+
+int m20_lib_set_pc (m20_machine * m, int addr)
+{
+    if ((m != &lib_machine) || (addr < 0) || (addr >= MAX_MEM_SIZE)) return SCPE_ARG;
+    regKRA = (uint16) addr;
+    return SCPE_OK;
+}
+
+
+int m20_lib_get_pc (m20_machine * m)
+{
+    if (m != &lib_machine) return -1;
+    return regKRA;
+}
+
+
+int m20_lib_read_mem (m20_machine * m, int addr, m20_word * value)
+{
+    t_value  val;
+    t_stat   r;
+
+    if ((m != &lib_machine) || (addr < 0) || (value == NULL)) return SCPE_ARG;
+    r = cpu_examine (&val, (t_addr) addr, NULL, 0);
+    if (r == SCPE_OK) *value = (m20_word) val;
+    return r;
+}
+
+
+int m20_lib_write_mem (m20_machine * m, int addr, m20_word value)
+{
+    if ((m != &lib_machine) || (addr < 0)) return SCPE_ARG;
+    return cpu_deposit ((t_value) value & WORD45, (t_addr) addr, NULL, 0);
+}
+
+
+
+/*
+ *  Run for max_instr instructions (0 = until stop).  SCP step counter
+ *  is decremented by the CPU loop once per instruction, so long budgets
+ *  are split into chunks.  Returns M20_LIB_BUDGET or stop code.
+ */
+int m20_lib_run (m20_machine * m, unsigned long long max_instr,
+                 unsigned long long * executed)
+{
+    unsigned long long  done = 0;
+    int32  chunk;
+    t_stat r;
+
+    if ((m != &lib_machine) || !m->created) return SCPE_ARG;
+
+    do {
+        chunk = M20_LIB_RUN_CHUNK;
+        if (max_instr && (max_instr - done < (unsigned long long) chunk))
+            chunk = (int32) (max_instr - done);
+        sim_step = chunk;
+        sim_is_running = TRUE;
+        r = sim_instr ();
+        sim_is_running = FALSE;
+        done += chunk - ((sim_step > 0) ? sim_step : 0);
+        if ((r != SCPE_STOP) || (sim_step > 0)) break;      /* real stop */
+        r = M20_LIB_BUDGET;
+    } while (!max_instr || (done < max_instr));
+
+    sim_step = 0;
+    if (executed != NULL) *executed = done;
+    return (r == M20_LIB_BUDGET) ? r : SCPE_BARE_STATUS (r);
+}
+
+
+
+/*
+ *  Printer output and memory files
+ */
+const char * m20_lib_printer_output (m20_machine * m, size_t * size)
+{
+    if ((m != &lib_machine) || !(lpt_unit.flags & UNIT_ATT) || (lpt_unit.filename == NULL) ||
+        (strncasecmp (lpt_unit.filename, "mem:", 4) != 0))
+        return NULL;
+    return (const char *) m20_mem_get (lpt_unit.filename + 4, size);
+}
+
+
+int m20_lib_printer_clear (m20_machine * m)
+{
+    t_stat r;
+
+    if (lpt_unit.flags & UNIT_ATT) {
+        r = m20_lib_command (m, "DETACH LPT");
+        if (r != SCPE_OK) return r;
+    }
+    return m20_lib_command (m, "ATTACH -N LPT mem:" M20_LIB_LPT_NAME);
+}
+
+
+int m20_lib_put_file (m20_machine * m, const char * name,
+                      const void * data, size_t size)
+{
+    if ((m != &lib_machine) || (name == NULL) || ((data == NULL) && size)) return SCPE_ARG;
+    return m20_mem_put (name, data, size);
+}
+
+
+const void * m20_lib_get_file (m20_machine * m, const char * name, size_t * size)
+{
+    if ((m != &lib_machine) || (name == NULL)) return NULL;
+    return m20_mem_get (name, size);
+}
+
+
+
+/*
+ *  Execute simulator command
+ */
+int m20_lib_command (m20_machine * m, const char * cmd)
+{
+    char    gbuf[CBUFSIZE];
+    CONST char * cptr;
+    CTAB *  cmdp;
+
+    if ((m != &lib_machine) || !m->created || (cmd == NULL)) return SCPE_ARG;
+
+    cptr = get_glyph (cmd, gbuf, 0);
+    if (gbuf[0] == 0) return SCPE_OK;
+    cmdp = find_cmd (gbuf);
+    if (cmdp == NULL) return SCPE_UNK;
+    sim_switches = 0;
+
+    return SCPE_BARE_STATUS (cmdp->action (cmdp->arg, cptr));
+}
+
+
+const char * m20_lib_error_text (int code)
+{
+    static char  buf[64];
+
+    if (code == M20_LIB_BUDGET) return "Instruction count expired";
+    if ((code > 0) && (code < SCPE_BASE)) {
+        if (sim_stop_messages[code] != NULL) return sim_stop_messages[code];
+        sprintf (buf, "Unknown stop code %d", code);
+        return buf;
+    }
+    return sim_error_text ((t_stat) code);
+}
@@ -0,0 +1,96 @@
+/*
+ * File:     libm20.h
+ * Purpose:  M-20 simulator embedding interface (libm20)
+ *
+ * Copyright (c) 2026, Dmitry Stefankov
+ *
+ * $Id$
+ *
+ * The library contains M-20 core (CPU, devices, loaders) and SIMH
+ * runtime without command line front-end.  Only one machine per
+ * process can exist, because simulator state is global.
+ *
+ * Typical usage:
+ *
+ *   m20_machine * m = m20_lib_create ();
+ *   m20_lib_load_image (m, image, image_size);
+ *   m20_lib_set_key (m, 1, 0111000100010377LL);
+ *   r = m20_lib_run (m, 1000000, &count);
+ *   text = m20_lib_printer_output (m, &size);
+ *   m20_lib_destroy (m);
+ *
+ * Printer is attached to memory buffer on create, so output is
+ * collected without host files.  Other devices are attached with
+ * m20_lib_command (m, "ATTACH DRUM0 mem:drum0") on buffers supplied
+ * by m20_lib_put_file().
+ *
+ * Return codes are SIMH status values:  0 is success, other values
+ * can be decoded by m20_lib_error_text().  m20_lib_run() returns
+ * M20_LIB_BUDGET (negative, not a SIMH status) when instruction
+ * count is expired.
+ *
+ * Revision History.
+ *
+ *  19-Oct-2026  DVS  Initial Implementation
+ *  19-Oct-2026  DVS  M20_LIB_BUDGET differs from success (0)
+ *
+ */
+
+#ifndef _LIBM20_H_
+#define _LIBM20_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#define M20_LIB_MEM_SIZE    4096        /* words of MOSU */
+#define M20_LIB_KEYS        4           /* key registers RPU1..RPU4 */
+
+#define M20_LIB_BUDGET      (-1)        /* run: instruction count expired */
+
+
+typedef unsigned long long  m20_word;   /* 45-bit machine word */
+typedef struct m20_machine  m20_machine;
+
+
+/* Machine */
+m20_machine * m20_lib_create (void);
+void          m20_lib_destroy (m20_machine * m);
+int           m20_lib_reset (m20_machine * m, int clear_memory);
+
+/* Program image (text absolute or binary object format) */
+int           m20_lib_load_image (m20_machine * m, const void * data, size_t size);
+
+/* Registers and memory */
+int           m20_lib_set_key (m20_machine * m, int n, m20_word value);
+int           m20_lib_get_key (m20_machine * m, int n, m20_word * value);
+int           m20_lib_set_pc (m20_machine * m, int addr);
+int           m20_lib_get_pc (m20_machine * m);
+int           m20_lib_read_mem (m20_machine * m, int addr, m20_word * value);
+int           m20_lib_write_mem (m20_machine * m, int addr, m20_word value);
+
+/* Execution: max_instr = 0 runs until stop */
+int           m20_lib_run (m20_machine * m, unsigned long long max_instr,
+                           unsigned long long * executed);
+
+/* Printer output and memory files */
+const char *  m20_lib_printer_output (m20_machine * m, size_t * size);
+int           m20_lib_printer_clear (m20_machine * m);
+int           m20_lib_put_file (m20_machine * m, const char * name,
+                                const void * data, size_t size);
+const void *  m20_lib_get_file (m20_machine * m, const char * name, size_t * size);
+
+/* Any simulator command (ATTACH, SET, DEPOSIT, ...) */
+int           m20_lib_command (m20_machine * m, const char * cmd);
+
+const char *  m20_lib_error_text (int code);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* _LIBM20_H_ */
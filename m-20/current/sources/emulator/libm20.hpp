@@ -0,0 +1,118 @@
+/*
+ * File:     libm20.hpp
+ * Purpose:  M-20 simulator embedding interface (C++ wrapper for libm20)
+ *
+ * Copyright (c) 2026, Dmitry Stefankov
+ *
+ * $Id$
+ *
+ * Header-only wrapper:  machine lifetime is bound to object scope,
+ * errors (except run stops) are thrown as m20::Error.
+ *
+ *   m20::Machine m;
+ *   m.load_image (image);
+ *   m.set_key (1, 0111000100010377LL);
+ *   int stop = m.run (1000000);
+ *   std::string text = m.printer_output ();
+ *
+ * Revision History.
+ *
+ *  19-Oct-2026  DVS  Initial Implementation
+ *
+ */
+
+#ifndef _LIBM20_HPP_
+#define _LIBM20_HPP_
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "libm20.h"
+
+
+namespace m20 {
+
+typedef m20_word  Word;
+
+
+class Error : public std::runtime_error {
+public:
+    explicit Error (int code)
+        : std::runtime_error (m20_lib_error_text (code)), code_ (code) {}
+    int code () const { return code_; }
+private:
+    int code_;
+};
+
+
+class Machine {
+public:
+    Machine () : m_ (m20_lib_create ()), executed_ (0)
+    {
+        if (m_ == NULL) throw std::runtime_error ("libm20: machine is not created");
+    }
+
+    ~Machine () { m20_lib_destroy (m_); }
+
+    void reset (bool clear_memory = true)   { check (m20_lib_reset (m_, clear_memory)); }
+
+    void load_image (const void * data, size_t size) { check (m20_lib_load_image (m_, data, size)); }
+    void load_image (const std::string & image)      { load_image (image.data (), image.size ()); }
+    void load_image (const std::vector<char> & image)
+    {
+        load_image (image.empty () ? "" : &image[0], image.size ());
+    }
+
+    void set_key (int n, Word value)    { check (m20_lib_set_key (m_, n, value)); }
+    Word key (int n) const              { Word v; check (m20_lib_get_key (m_, n, &v)); return v; }
+
+    void set_pc (int addr)              { check (m20_lib_set_pc (m_, addr)); }
+    int  pc () const                    { return m20_lib_get_pc (m_); }
+
+    Word read (int addr) const          { Word v; check (m20_lib_read_mem (m_, addr, &v)); return v; }
+    void write (int addr, Word value)   { check (m20_lib_write_mem (m_, addr, value)); }
+
+    /* returns M20_LIB_BUDGET or simulator stop code */
+    int run (unsigned long long max_instr = 0)
+    {
+        return m20_lib_run (m_, max_instr, &executed_);
+    }
+    unsigned long long executed () const { return executed_; }
+
+    std::string printer_output () const
+    {
+        size_t size = 0;
+        const char * p = m20_lib_printer_output (m_, &size);
+        return (p != NULL) ? std::string (p, size) : std::string ();
+    }
+    void clear_printer ()               { check (m20_lib_printer_clear (m_)); }
+
+    void put_file (const std::string & name, const std::string & data)
+    {
+        check (m20_lib_put_file (m_, name.c_str (), data.data (), data.size ()));
+    }
+    std::string file (const std::string & name) const
+    {
+        size_t size = 0;
+        const char * p = (const char *) m20_lib_get_file (m_, name.c_str (), &size);
+        return (p != NULL) ? std::string (p, size) : std::string ();
+    }
+
+    void command (const std::string & cmd) { check (m20_lib_command (m_, cmd.c_str ())); }
+
+    static const char * stop_text (int code) { return m20_lib_error_text (code); }
+
+private:
+    Machine (const Machine &);
+    Machine & operator= (const Machine &);
+
+    static void check (int code) { if (code != 0) throw Error (code); }
+
+    m20_machine *       m_;
+    unsigned long long  executed_;
+};
+
+}  /* namespace m20 */
+
+#endif  /* _LIBM20_HPP_ */
@@ -0,0 +1,98 @@
+/*
+ * File:     libm20_test.c
+ * Purpose:  M-20 simulator embedding library (libm20) example and test
+ *
+ * Copyright (c) 2026, Dmitry Stefankov
+ *
+ * $Id$
+ *
+ * Program 2+2 with printing of result is loaded from memory image,
+ * run until stop and checked (memory, printer output), then the wait
+ * loop of the same image is run with instruction budget.  Exit code
+ * is 0 if all checks are passed (make test_libm20).
+ *
+ * Revision History.
+ *
+ *  19-Oct-2026  DVS  Initial Implementation
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "libm20.h"
+
+
+static const char test_image[] =
+    "; 2+2 with printing, wait loop\n"
+    ":0020\n"
+    "=2\n"
+    "=2\n"
+    "=0\n"
+    ":0030\n"
+    "0 01 0020 0021 0022\n"
+    "0 50 2100 0000 0022\n"
+    "0 70 0022 0000 0000\n"
+    "0 77 0000 0000 0000\n"
+    ":0040\n"
+    "0 56 0000 0040 0000\n"
+    "@0030\n";
+
+static int  checks = 0;
+static int  failed = 0;
+
+
+static void check (int ok, const char * what)
+{
+    checks++;
+    if (ok) return;
+    failed++;
+    fprintf (stderr, "libm20_test: FAILED: %s\n", what);
+}
+
+
+int main (void)
+{
+    m20_machine * m;
+    m20_word  w, four;
+    unsigned long long  count;
+    const char * out;
+    size_t  size;
+    int  r;
+
+    m = m20_lib_create ();
+    check (m != NULL, "create");
+    if (m == NULL) return 1;
+
+    r = m20_lib_load_image (m, test_image, sizeof(test_image) - 1);
+    check (r == 0, "load image");
+    check (m20_lib_get_pc (m) == 030, "start address");
+
+    /* run until stop */
+    r = m20_lib_run (m, 0, &count);
+    check ((r != 0) && (r != M20_LIB_BUDGET), "run until stop");
+    check (count == 3, "instructions until stop");   /* stop (077) is not counted */
+    check (m20_lib_get_pc (m) == 033, "stop address");
+    check ((m20_lib_read_mem (m, 020, &w) == 0) && (m20_lib_read_mem (m, 022, &four) == 0) &&
+           (w != four) && (four != 0), "result in memory");
+    out = m20_lib_printer_output (m, &size);
+    check ((out != NULL) && (size > 0) && (out[size-1] == '\n'), "printer output");
+
+    /* wait loop with budget */
+    check (m20_lib_set_pc (m, 040) == 0, "set pc");
+    r = m20_lib_run (m, 1000, &count);
+    check (r == M20_LIB_BUDGET, "run with budget");
+    check (count == 1000, "instructions of budget");
+    check (m20_lib_get_pc (m) == 040, "pc in wait loop");
+
+    /* result codes */
+    check (M20_LIB_BUDGET != 0, "budget code is not success");
+    check (strcmp (m20_lib_error_text (0), m20_lib_error_text (M20_LIB_BUDGET)) != 0,
+           "text of success");
+    check (m20_lib_reset (m, 1) == 0, "reset");
+    check ((m20_lib_read_mem (m, 022, &w) == 0) && (w == 0), "memory cleared by reset");
+
+    m20_lib_destroy (m);
+
+    printf ("libm20_test: %d checks, %d failed\n", checks, failed);
+    return failed ? 1 : 0;
+}
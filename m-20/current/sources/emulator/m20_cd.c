@@ -24,6 +24,7 @@
  *  17-Jan-2015  DVS  Added another binary-decimal input form
  *  25-Jan-2015  DVS  Added more debugging to see input errors
  *  13-Mar-2015  DVS  Cleanup code
+ *  19-Oct-2026  DVS  Added in-memory attachments (mem:name)
  *
  */
 
@@ -62,6 +63,8 @@ extern int   active_cdp;
 extern t_value  ieee_to_m20 (double d);
 extern char *   skip_spaces (char *p);
 extern char *   skip_nonspaces (char *p);
+extern t_stat m20_attach_unit (UNIT *uptr, CONST char *cptr);
+extern t_stat m20_detach_unit (UNIT *uptr);
 
 /* external references (LP module) */
 extern  char bcd2char( int bcd_value );
@@ -199,7 +202,7 @@ t_stat cdr_attach (UNIT *uptr, char *cptr)
 {
     if (sim_deb && cdr_dev.dctrl) fprintf (sim_deb, "cdr: cdr_attach(..)\n");
 
-    return attach_unit (uptr, cptr);
+    return m20_attach_unit (uptr, cptr);
 }
 
 
@@ -210,7 +213,7 @@ t_stat cdr_detach (UNIT *uptr)
 {
     if (sim_deb && cdr_dev.dctrl) fprintf (sim_deb, "cdr: cdr_detach(..)\n");
 
-    return detach_unit (uptr);
+    return m20_detach_unit (uptr);
 }
 
 
@@ -551,7 +554,7 @@ t_stat cdp_attach (UNIT *uptr, char *cptr)
 
     active_cdp++;
 
-    return attach_unit (uptr, cptr);
+    return m20_attach_unit (uptr, cptr);
 }
 
 
@@ -564,7 +567,7 @@ t_stat cdp_detach (UNIT *uptr)
 
     active_cdp--;
 
-    return detach_unit (uptr);
+    return m20_detach_unit (uptr);
 }
 
 
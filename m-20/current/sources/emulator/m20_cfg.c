@@ -0,0 +1,617 @@
+/*
+ * File:     m20_cfg.c
+ * Purpose:  M-20 static control-flow and data-flow analysis of MOSU image
+ *
+ * Copyright (c) 2026, Dmitry Stefankov
+ *
+ * $Id$
+ *
+ * Analysis doesn't run the program.  Instructions are decoded from the
+ * entry addresses (three addresses and RA tags) and followed through
+ * jumps (016, 036, 056, 076), cycle jumps (011, 012, 031, 032, 051,
+ * 071) and alternative addresses of input (010, 030, 070).  Stops (017,
+ * 037, 057, 077) end the path, compare with stop (035) continues.  Paths
+ * which run into empty (never loaded) words or beyond 7777 are ended
+ * and reported.  Jumps with RA tag of second address have dynamic
+ * target and are only reported.
+ *
+ * Basic blocks end at control instructions and at i/o instructions (010,
+ * 030, 050, 070), which may schedule device events.  Loops are natural
+ * loops of back edges of depth-first search from the entries.  Stores
+ * of third address into reachable code are reported as self-modifying
+ * (013, 033, 053, 073 - addition and subtraction of commands), return
+ * slots (return jump written by 016) and other writes.  Loaded words
+ * which are neither reached nor referenced as operands are unreferenced.
+ *
+ * Module has no SCP references and is shared by the simulator (SHOW CPU
+ * CFG) and by the m20cfg tool.
+ *
+ *   m20_cfg_build (mem, used, entries, n)   analyze image, used[] marks
+ *                                           loaded words (NULL = non-zero)
+ *   m20_cfg_print (st, cfg)                 report of blocks, loops, ...
+ *   m20_cfg_dot (st, cfg)                   graph in Graphviz DOT format
+ *   m20_cfg_free (cfg)
+ *
+ * Revision History.
+ *
+ *  19-Oct-2026  DVS  Initial Implementation
+ *
+ */
+
+#include "m20_defs.h"
+
+
+#define  CFG_MAX_ENTRIES    16
+#define  CFG_MAX_LOOPS      1024
+#define  CFG_MAX_WRITES     1024
+
+/* Word flags */
+#define  CFG_CODE           0x0001	/* reachable instruction */
+#define  CFG_LEADER         0x0002	/* first instruction of block */
+#define  CFG_DATA           0x0004	/* operand of reachable instruction */
+#define  CFG_WRITTEN        0x0008	/* third address of reachable instruction */
+#define  CFG_SELFMOD        0x0010	/* code written by 013/033/053/073 */
+#define  CFG_RETSLOT        0x0020	/* code written by 016 */
+#define  CFG_EMPTY          0x0040	/* empty word reached by control */
+#define  CFG_LOOP           0x0080	/* loop header */
+#define  CFG_ENTRY          0x0100
+
+/* Operands of instruction */
+#define  OPND_R1            0x01	/* a1 is read */
+#define  OPND_R2            0x02	/* a2 is read */
+#define  OPND_W3            0x04	/* a3 is written */
+#define  OPND_J2            0x08	/* a2 is jump address */
+#define  OPND_RET1          0x10	/* a1 is return address (016) */
+
+#define  RRW                (OPND_R1 | OPND_R2 | OPND_W3)
+
+static const unsigned char cfg_opnd[MAX_OPCODE_VALUE+1] = {
+/* 000 */  OPND_R1|OPND_W3, RRW, RRW, RRW, RRW, RRW, OPND_R2|OPND_W3, RRW,
+/* 010 */  OPND_W3|OPND_J2, OPND_J2, OPND_J2, RRW, OPND_R2|OPND_W3, RRW, OPND_J2|OPND_RET1|OPND_W3, OPND_W3,
+/* 020 */  OPND_W3, RRW, RRW, RRW, RRW, RRW, RRW, RRW,
+/* 030 */  OPND_W3|OPND_J2, OPND_J2, OPND_J2, RRW, RRW, RRW, OPND_R1|OPND_J2|OPND_W3, OPND_W3,
+/* 040 */  OPND_W3, RRW, RRW, RRW, OPND_R1|OPND_W3, RRW, OPND_R2|OPND_W3, RRW,
+/* 050 */  0, OPND_J2, OPND_W3, RRW, OPND_R2|OPND_W3, RRW, OPND_R1|OPND_J2|OPND_W3, OPND_W3,
+/* 060 */  OPND_W3, RRW, RRW, RRW, OPND_R1|OPND_W3, RRW, RRW, OPND_R1|OPND_W3,
+/* 070 */  OPND_W3|OPND_J2, OPND_J2, OPND_R2|OPND_W3, RRW, RRW, RRW, OPND_R1|OPND_J2|OPND_W3, OPND_W3
+};
+
+/* Exit of block (last instruction) */
+enum { EXIT_FALL, EXIT_JUMP, EXIT_COND, EXIT_CALL, EXIT_RET, EXIT_IO,
+       EXIT_STOP, EXIT_ASSERT, EXIT_DYN, EXIT_END };
+
+static const char * cfg_exit_name[] = {
+    "fall", "jump", "cond", "call", "return", "i/o",
+    "stop", "assert", "dynamic", "end"
+};
+
+
+typedef  struct m20_cfg_block {
+    int        start, end;		/* first and last instruction */
+    int        exit;			/* EXIT_xxx of last instruction */
+    int        succ[2];			/* successor addresses, -1 = none */
+} M20_CFG_BLOCK;
+
+typedef  struct m20_cfg_loop {
+    int        header;			/* header block */
+    int        tail;			/* block of back edge */
+    int        blocks, instr;		/* size of loop body */
+} M20_CFG_LOOP;
+
+typedef  struct m20_cfg_write {
+    int        addr;			/* writing instruction */
+    int        target;			/* -1 = RA-modified address */
+} M20_CFG_WRITE;
+
+typedef  struct m20_cfg {
+    t_value        mem[MAX_MEM_SIZE];
+    unsigned char  used[MAX_MEM_SIZE];
+    unsigned short flags[MAX_MEM_SIZE];
+    int            block_of[MAX_MEM_SIZE];	/* block of instruction, -1 = none */
+    M20_CFG_BLOCK  blocks[MAX_MEM_SIZE];
+    int            nblocks, ninstr;
+    int            entries[CFG_MAX_ENTRIES];
+    int            nentries;
+    M20_CFG_LOOP   loops[CFG_MAX_LOOPS];
+    int            nloops;
+    M20_CFG_WRITE  selfmod[CFG_MAX_WRITES];
+    int            nselfmod;
+} M20_CFG, * PM20_CFG;
+
+
+#define  W_TAGS(w)          ((int) ((w) >> BITS_42) & MAX_ADDR_TAG_VALUE)
+#define  W_OP(w)            ((int) ((w) >> BITS_36) & MAX_OPCODE_VALUE)
+#define  W_A1(w)            ((int) ((w) >> BITS_24) & MAX_ADDR_VALUE)
+#define  W_A2(w)            ((int) ((w) >> BITS_12) & MAX_ADDR_VALUE)
+#define  W_A3(w)            ((int) ((w) >> BITS_0)  & MAX_ADDR_VALUE)
+
+
+
+/*
+ *  Exit kind and successors of instruction
+ */
+static int cfg_decode (t_value w, int addr, int *succ)
+{
+    int tags = W_TAGS (w), op = W_OP (w), a1 = W_A1 (w), a2 = W_A2 (w);
+    int next = (addr < MAX_ADDR_VALUE) ? addr + 1 : -1;
+    int dyn2 = (tags & 2) != 0;
+
+    succ[0] = succ[1] = -1;
+    switch (op) {
+    case OPCODE_STOP_017:
+    case OPCODE_STOP_037:
+    case OPCODE_STOP_057:
+    case OPCODE_STOP_077:
+        return EXIT_STOP;
+
+    case OPCODE_COMPARE_WITH_STOP:
+        succ[0] = next;
+        return EXIT_ASSERT;
+
+    case OPCODE_JUMP_WITH_RETURN:
+        if (!(tags & 4)) succ[1] = a1;		/* continues after return */
+        if (dyn2) return EXIT_DYN;
+        succ[0] = a2;
+        return EXIT_CALL;
+
+    case OPCODE_JUMP_BY_ADDR:
+        if (dyn2) return EXIT_DYN;
+        succ[0] = a2;
+        return EXIT_JUMP;
+
+    case OPCODE_COND_JUMP_BY_SIG_W_1:
+    case OPCODE_COND_JUMP_BY_SIG_W_0:
+    case OPCODE_GOTO_AFTER_CYCLE_BY_PA_012:
+    case OPCODE_GOTO_AFTER_CYCLE_BY_PA_032:
+    case OPCODE_GOTO_AFTER_CYCLE_BY_PA_SIG_W_1_011:
+    case OPCODE_GOTO_AFTER_CYCLE_BY_PA_SIG_W_1_031:
+    case OPCODE_GOTO_AFTER_CYCLE_BY_PA_SIG_W_0_051:
+    case OPCODE_GOTO_AFTER_CYCLE_BY_PA_SIG_W_0_071:
+        succ[0] = next;
+        if (dyn2) return EXIT_DYN;
+        succ[1] = a2;
+        return EXIT_COND;
+
+    case OPCODE_INPUT_CODES_FROM_PUNCH_CARDS_WITH_STOP:
+    case OPCODE_INPUT_CODES_FROM_PUNCH_CARDS:
+    case OPCODE_IO_EXT_DEV_TO_MEM_070:
+        succ[0] = next;
+        if (!dyn2 && (a2 != 0) && (a2 != next)) succ[1] = a2;
+        return EXIT_IO;
+
+    case OPCODE_IO_EXT_DEV_TO_MEM_050:
+        succ[0] = next;
+        return EXIT_IO;
+
+    default:
+        succ[0] = next;
+        return EXIT_FALL;
+    }
+}
+
+
+
+/*
+ *  Exit kind and successors of reachable word:  return slot holds jump,
+ *  written by 016 at run time, returns of calls are edges of 016 blocks
+ */
+static int cfg_kind (PM20_CFG cfg, int addr, int *succ)
+{
+    if (cfg->flags[addr] & CFG_RETSLOT) {
+        succ[0] = succ[1] = -1;
+        return EXIT_RET;
+    }
+    return cfg_decode (cfg->mem[addr], addr, succ);
+}
+
+
+
+/*
+ *  Reachable code and leaders, repeated while new return slots are found
+ */
+static int cfg_reach_pass (PM20_CFG cfg)
+{
+    static int stack[MAX_MEM_SIZE];
+    int  sp = 0, i, k, a, kind, succ[2], again = FALSE;
+    t_value w;
+
+    for (a = 0; a < MAX_MEM_SIZE; a++)
+        cfg->flags[a] &= ~(CFG_CODE | CFG_EMPTY | CFG_LEADER | CFG_ENTRY);
+    cfg->ninstr = 0;
+    for (i = 0; i < cfg->nentries; i++) {
+        a = cfg->entries[i];
+        cfg->flags[a] |= CFG_ENTRY | CFG_LEADER;
+        stack[sp++] = a;
+    }
+    while (sp > 0) {
+        a = stack[--sp];
+        if (cfg->flags[a] & (CFG_CODE | CFG_EMPTY)) continue;
+        if (!cfg->used[a] && !(cfg->flags[a] & CFG_RETSLOT)) {
+            cfg->flags[a] |= CFG_EMPTY;
+            continue;
+        }
+        cfg->flags[a] |= CFG_CODE;
+        cfg->ninstr++;
+        kind = cfg_kind (cfg, a, succ);
+        w = cfg->mem[a];
+        if ((kind == EXIT_CALL) && !(W_TAGS (w) & 1) && !(cfg->flags[W_A3 (w)] & CFG_RETSLOT)) {
+            cfg->flags[W_A3 (w)] |= CFG_RETSLOT;
+            if (cfg->flags[W_A3 (w)] & (CFG_CODE | CFG_EMPTY)) again = TRUE;
+        }
+        for (k = 1; k >= 0; k--) {
+            if (succ[k] < 0) continue;
+            if ((kind != EXIT_FALL) || (k != 0)) cfg->flags[succ[k]] |= CFG_LEADER;
+            if (!(cfg->flags[succ[k]] & (CFG_CODE | CFG_EMPTY)) && (sp < MAX_MEM_SIZE))
+                stack[sp++] = succ[k];
+        }
+    }
+    return again;
+}
+
+static void cfg_reach (PM20_CFG cfg)
+{
+    while (cfg_reach_pass (cfg)) ;
+}
+
+
+
+/*
+ *  Basic blocks
+ */
+static void cfg_blocks (PM20_CFG cfg)
+{
+    M20_CFG_BLOCK *b;
+    int  a, kind, succ[2];
+
+    for (a = 0; a < MAX_MEM_SIZE; a++) cfg->block_of[a] = -1;
+    cfg->nblocks = 0;
+    for (a = 0; a < MAX_MEM_SIZE; a++) {
+        if (!(cfg->flags[a] & CFG_CODE)) continue;
+        b = &cfg->blocks[cfg->nblocks];
+        b->start = a;
+        for (;;) {
+            cfg->block_of[a] = cfg->nblocks;
+            kind = cfg_kind (cfg, a, succ);
+            if ((kind != EXIT_FALL) || (succ[0] < 0) ||
+                !(cfg->flags[succ[0]] & CFG_CODE) || (cfg->flags[succ[0]] & CFG_LEADER)) break;
+            a = succ[0];
+        }
+        b->end = a;
+        b->exit = kind;
+        if ((kind == EXIT_FALL) && ((succ[0] < 0) || (cfg->flags[succ[0]] & CFG_EMPTY)))
+            b->exit = EXIT_END;
+        b->succ[0] = succ[0];
+        b->succ[1] = succ[1];
+        cfg->nblocks++;
+    }
+}
+
+
+
+/*
+ *  Natural loops of back edges
+ */
+static void cfg_loop_body (PM20_CFG cfg, int h, int t, unsigned char *in)
+{
+    static int stack[MAX_MEM_SIZE];
+    M20_CFG_LOOP *lp;
+    M20_CFG_BLOCK *b;
+    int  sp = 0, i, k, s, n;
+
+    memset (in, 0, cfg->nblocks);
+    in[h] = 1;
+    if (!in[t]) { in[t] = 1; stack[sp++] = t; }
+    while (sp > 0) {			/* predecessors up to header */
+        n = stack[--sp];
+        for (i = 0; i < cfg->nblocks; i++) {
+            if (in[i]) continue;
+            b = &cfg->blocks[i];
+            for (k = 0; k < 2; k++) {
+                s = (b->succ[k] >= 0) ? cfg->block_of[b->succ[k]] : -1;
+                if (s == n) {
+                    in[i] = 1;
+                    stack[sp++] = i;
+                    break;
+                }
+            }
+        }
+    }
+    if (cfg->nloops >= CFG_MAX_LOOPS) return;
+    lp = &cfg->loops[cfg->nloops++];
+    lp->header = h;
+    lp->tail = t;
+    lp->blocks = lp->instr = 0;
+    for (i = 0; i < cfg->nblocks; i++) {
+        if (!in[i]) continue;
+        lp->blocks++;
+        lp->instr += cfg->blocks[i].end - cfg->blocks[i].start + 1;
+    }
+    cfg->flags[cfg->blocks[h].start] |= CFG_LOOP;
+}
+
+static void cfg_loops (PM20_CFG cfg)
+{
+    static int stack[MAX_MEM_SIZE], edge[MAX_MEM_SIZE];
+    static unsigned char color[MAX_MEM_SIZE], in[MAX_MEM_SIZE];
+    M20_CFG_BLOCK *b;
+    int  i, sp, n, s, e, root;
+
+    memset (color, 0, sizeof (color));
+    for (i = 0; i < cfg->nentries; i++) {
+        root = cfg->block_of[cfg->entries[i]];
+        if ((root < 0) || color[root]) continue;
+        sp = 0;
+        stack[sp] = root;  edge[sp++] = 0;
+        color[root] = 1;
+        while (sp > 0) {
+            n = stack[sp-1];
+            e = edge[sp-1]++;
+            if (e >= 2) {
+                color[n] = 2;
+                sp--;
+                continue;
+            }
+            b = &cfg->blocks[n];
+            s = (b->succ[e] >= 0) ? cfg->block_of[b->succ[e]] : -1;
+            if (s < 0) continue;
+            if (color[s] == 1) cfg_loop_body (cfg, s, n, in);	/* back edge */
+            else if (color[s] == 0) {
+                color[s] = 1;
+                stack[sp] = s;  edge[sp++] = 0;
+            }
+        }
+    }
+    for (i = 1; i < cfg->nloops; i++) {		/* in order of headers */
+        M20_CFG_LOOP lp = cfg->loops[i];
+        for (n = i; (n > 0) && (cfg->loops[n-1].header > lp.header); n--)
+            cfg->loops[n] = cfg->loops[n-1];
+        cfg->loops[n] = lp;
+    }
+}
+
+
+
+/*
+ *  Operands and writes of reachable instructions
+ */
+static void cfg_data (PM20_CFG cfg)
+{
+    M20_CFG_WRITE *wp;
+    t_value w;
+    int  a, op, tags, opnd, a3;
+
+    cfg->nselfmod = 0;
+    for (a = 0; a < MAX_MEM_SIZE; a++) {
+        if (!(cfg->flags[a] & CFG_CODE)) continue;
+        w = cfg->mem[a];
+        op = W_OP (w);
+        tags = W_TAGS (w);
+        opnd = cfg_opnd[op];
+        a3 = W_A3 (w);
+        if ((op == OPCODE_IO_EXT_DEV_TO_MEM_070) && (a3 == 0)) opnd &= ~OPND_W3;
+        if (opnd & OPND_R1) cfg->flags[W_A1 (w)] |= CFG_DATA;
+        if (opnd & OPND_R2) cfg->flags[W_A2 (w)] |= CFG_DATA;
+        if (!(opnd & OPND_W3)) continue;
+        cfg->flags[a3] |= CFG_DATA;
+        if (!(tags & 1)) cfg->flags[a3] |= CFG_WRITTEN;
+        if ((op != OPCODE_ADD_CMDS) && (op != OPCODE_SUB_CMDS) &&
+            (op != OPCODE_ADD_OPCS) && (op != OPCODE_SUB_OPCS)) continue;
+        if (cfg->nselfmod >= CFG_MAX_WRITES) continue;
+        wp = &cfg->selfmod[cfg->nselfmod++];
+        wp->addr = a;
+        wp->target = (tags & 1) ? -1 : a3;
+        if (!(tags & 1) && (cfg->flags[a3] & CFG_CODE)) cfg->flags[a3] |= CFG_SELFMOD;
+    }
+}
+
+
+
+/*
+ *  Build graph
+ */
+PM20_CFG m20_cfg_build (const t_value *mem, const unsigned char *used, const int *entries, int n)
+{
+    PM20_CFG cfg;
+    int  a, i;
+
+    cfg = (PM20_CFG) calloc (1, sizeof (M20_CFG));
+    if (cfg == NULL) return NULL;
+    for (a = 0; a < MAX_MEM_SIZE; a++) {
+        cfg->mem[a] = mem[a] & WORD45;
+        cfg->used[a] = used ? used[a] : (mem[a] != 0);
+    }
+    for (i = 0; (i < n) && (cfg->nentries < CFG_MAX_ENTRIES); i++)
+        cfg->entries[cfg->nentries++] = entries[i] & MAX_ADDR_VALUE;
+
+    cfg_reach (cfg);
+    cfg_blocks (cfg);
+    cfg_loops (cfg);
+    cfg_data (cfg);
+    return cfg;
+}
+
+void m20_cfg_free (PM20_CFG cfg)
+{
+    free (cfg);
+}
+
+
+
+/*
+ *  Text report
+ */
+static void cfg_print_succ (FILE *st, int a)
+{
+    if (a < 0) fprintf (st, "  ----");
+    else fprintf (st, "  %04o", a);
+}
+
+void m20_cfg_print (FILE *st, PM20_CFG cfg)
+{
+    M20_CFG_BLOCK *b;
+    int  i, a, s, n, op;
+
+    fprintf (st, "CFG: entry");
+    for (i = 0; i < cfg->nentries; i++) fprintf (st, " %04o", cfg->entries[i]);
+    fprintf (st, ", %d blocks, %d instructions, %d loops\n", cfg->nblocks, cfg->ninstr, cfg->nloops);
+
+    fprintf (st, "Block  Start  End   Instr  Exit     Next  Jump\n");
+    for (i = 0; i < cfg->nblocks; i++) {
+        b = &cfg->blocks[i];
+        fprintf (st, "%5d  %04o   %04o  %5d  %-7s", i, b->start, b->end,
+                 b->end - b->start + 1, cfg_exit_name[b->exit]);
+        switch (b->exit) {
+        case EXIT_CALL:			/* return address, target */
+            cfg_print_succ (st, b->succ[1]);
+            cfg_print_succ (st, b->succ[0]);
+            break;
+        case EXIT_JUMP:
+            cfg_print_succ (st, -1);
+            cfg_print_succ (st, b->succ[0]);
+            break;
+        case EXIT_STOP:
+        case EXIT_RET:
+        case EXIT_END:
+            cfg_print_succ (st, -1);
+            cfg_print_succ (st, -1);
+            break;
+        default:
+            cfg_print_succ (st, b->succ[0]);
+            cfg_print_succ (st, b->succ[1]);
+            break;
+        }
+        if (cfg->flags[b->start] & CFG_LOOP) fprintf (st, "  loop");
+        fprintf (st, "\n");
+    }
+
+    if (cfg->nloops > 0) {
+        fprintf (st, "Loops:\n");
+        for (i = 0; i < cfg->nloops; i++)
+            fprintf (st, "  header %04o, back edge from %04o, %d blocks, %d instructions\n",
+                     cfg->blocks[cfg->loops[i].header].start, cfg->blocks[cfg->loops[i].tail].end,
+                     cfg->loops[i].blocks, cfg->loops[i].instr);
+    }
+
+    n = 0;
+    for (a = 0; a < MAX_MEM_SIZE; a++) {
+        if (!(cfg->flags[a] & CFG_CODE)) continue;
+        op = W_OP (cfg->mem[a]);
+        if (!OPCODE_IS_IO (op)) continue;
+        if (n++ == 0) fprintf (st, "I/O instructions:");
+        fprintf (st, " %04o(%02o)", a, op);
+    }
+    if (n) fprintf (st, "\n");
+
+    n = 0;
+    for (i = 0; i < cfg->nblocks; i++) {
+        b = &cfg->blocks[i];
+        if ((b->exit != EXIT_STOP) && (b->exit != EXIT_ASSERT)) continue;
+        if (n++ == 0) fprintf (st, "Stops:");
+        fprintf (st, " %04o(%02o)", b->end, W_OP (cfg->mem[b->end]));
+    }
+    if (n) fprintf (st, "\n");
+
+    n = 0;
+    for (i = 0; i < cfg->nblocks; i++) {
+        b = &cfg->blocks[i];
+        if (b->exit != EXIT_DYN) continue;
+        if (n++ == 0) fprintf (st, "Dynamic jumps (A2+RA):");
+        fprintf (st, " %04o(%02o)", b->end, W_OP (cfg->mem[b->end]));
+    }
+    if (n) fprintf (st, "\n");
+
+    if (cfg->nselfmod > 0) {
+        fprintf (st, "Self-modifying:\n");
+        for (i = 0; i < cfg->nselfmod; i++) {
+            a = cfg->selfmod[i].addr;
+            s = cfg->selfmod[i].target;
+            if (s < 0) fprintf (st, "  %04o(%02o) writes A3+RA\n", a, W_OP (cfg->mem[a]));
+            else fprintf (st, "  %04o(%02o) writes %04o%s\n", a, W_OP (cfg->mem[a]), s,
+                          (cfg->flags[s] & CFG_CODE) ? " (code)" : "");
+        }
+    }
+
+    n = 0;
+    for (a = 0; a < MAX_MEM_SIZE; a++) {
+        if ((cfg->flags[a] & (CFG_CODE | CFG_RETSLOT)) != (CFG_CODE | CFG_RETSLOT)) continue;
+        if (n++ == 0) fprintf (st, "Return slots:");
+        fprintf (st, " %04o", a);
+    }
+    if (n) fprintf (st, "\n");
+
+    n = 0;
+    for (a = 0; a < MAX_MEM_SIZE; a++) {
+        if ((cfg->flags[a] & (CFG_CODE | CFG_WRITTEN | CFG_SELFMOD | CFG_RETSLOT)) !=
+            (CFG_CODE | CFG_WRITTEN)) continue;
+        if (n++ == 0) fprintf (st, "Other writes to code:");
+        fprintf (st, " %04o", a);
+    }
+    if (n) fprintf (st, "\n");
+
+    n = 0;
+    for (a = 0; a < MAX_MEM_SIZE; a++) {
+        if (!(cfg->flags[a] & CFG_EMPTY)) continue;
+        if (n++ == 0) fprintf (st, "Control reaches empty words:");
+        fprintf (st, " %04o", a);
+    }
+    if (n) fprintf (st, "\n");
+
+    n = 0;
+    for (a = 1; a < MAX_MEM_SIZE; a++) {		/* word 0 is zero constant */
+        if (!cfg->used[a] || (cfg->flags[a] & (CFG_CODE | CFG_DATA))) continue;
+        for (s = a; (s < MAX_ADDR_VALUE) && cfg->used[s+1] &&
+                    !(cfg->flags[s+1] & (CFG_CODE | CFG_DATA)); s++) ;
+        if (n++ == 0) fprintf (st, "Unreferenced words:");
+        if (s == a) fprintf (st, " %04o", a);
+        else fprintf (st, " %04o-%04o", a, s);
+        a = s;
+    }
+    if (n) fprintf (st, "\n");
+}
+
+
+
+/*
+ *  Graphviz DOT
+ */
+void m20_cfg_dot (FILE *st, PM20_CFG cfg)
+{
+    M20_CFG_BLOCK *b;
+    int  i, a, k, op;
+    const char *shape, *color, *label;
+
+    fprintf (st, "digraph m20_cfg {\n");
+    fprintf (st, "  node [shape=box, fontname=\"Courier\"];\n");
+    for (i = 0; i < cfg->nentries; i++) {
+        fprintf (st, "  entry%d [shape=point];\n", i);
+        fprintf (st, "  entry%d -> b%04o;\n", i, cfg->entries[i]);
+    }
+    for (i = 0; i < cfg->nblocks; i++) {
+        b = &cfg->blocks[i];
+        op = W_OP (cfg->mem[b->end]);
+        shape = (b->exit == EXIT_STOP) ? "octagon" : (b->exit == EXIT_RET) ? "invhouse" : "box";
+        color = (b->exit == EXIT_IO) ? ", style=filled, fillcolor=lightblue" : "";
+        for (a = b->start; a <= b->end; a++)
+            if (cfg->flags[a] & CFG_SELFMOD) color = ", style=filled, fillcolor=salmon";
+        fprintf (st, "  b%04o [shape=%s%s, label=\"%04o-%04o\\n%d instr, %s %02o\"];\n",
+                 b->start, shape, color, b->start, b->end, b->end - b->start + 1,
+                 cfg_exit_name[b->exit], op);
+        for (k = 0; k < 2; k++) {
+            a = b->succ[k];
+            if ((a < 0) || (b->exit == EXIT_STOP)) continue;
+            if (cfg->flags[a] & CFG_EMPTY) {
+                fprintf (st, "  e%04o [shape=plaintext, label=\"empty %04o\"];\n", a, a);
+                fprintf (st, "  b%04o -> e%04o;\n", b->start, a);
+                continue;
+            }
+            if (cfg->block_of[a] < 0) continue;
+            label = "";
+            if ((b->exit == EXIT_CALL) && (k == 0)) label = " [label=\"call\"]";
+            else if ((b->exit == EXIT_CALL) && (k == 1)) label = " [label=\"return\", style=dashed]";
+            else if ((b->exit == EXIT_COND) && (k == 1)) label = " [label=\"jump\"]";
+            else if ((b->exit == EXIT_IO) && (k == 1)) label = " [label=\"i/o\", style=dashed]";
+            fprintf (st, "  b%04o -> b%04o%s;\n", b->start, cfg->blocks[cfg->block_of[a]].start, label);
+        }
+    }
+    fprintf (st, "}\n");
+}
@@ -47,6 +47,26 @@
  *  09-Mar-2015  DVS  Some fixes and corrections for some instructions
  *                    But problems with arithmetic are remained, wee see these on complex tests
  *  14-Mar-2015  DVS  Cleanup code, removed numeric constants, added memory breakpoints
+ *  19-Oct-2026  DVS  Added instruction counter and checkpoints for reverse execution
+ *  19-Oct-2026  DVS  Added call-graph profiler hook
+ *  19-Oct-2026  DVS  Added loop profiler hook
+ *  19-Oct-2026  DVS  Added symbolic addresses (symbol map) for trace and commands
+ *  19-Oct-2026  DVS  Added run limits (RUN -I/-T/-W) and run summary
+ *  19-Oct-2026  DVS  Added idle loop detection and fast-forward
+ *  19-Oct-2026  DVS  Added real time pacing by emulated time (REALTIME)
+ *  19-Oct-2026  DVS  Added run and i/o statistics (SHOW STATS, RESET STATS)
+ *  19-Oct-2026  DVS  Integer emulated timebase (TIME_UNITS_PER_US) for delays
+ *  19-Oct-2026  DVS  Added burst execution to the next event or limit (BURST)
+ *  19-Oct-2026  DVS  Added control-flow graph of MOSU (SHOW CPU CFG)
+ *  19-Oct-2026  DVS  Added self-modifying code monitor (SMC_PROFILE)
+ *  19-Oct-2026  DVS  Added data access heatmap (HEATMAP, SHOW MEMORY HEATMAP)
+ *  19-Oct-2026  DVS  Trace control by filters and triggers (TRACE) instead of
+ *                    fixed DISABLE_IS2_TRACE test
+ *  19-Oct-2026  DVS  Added host performance counters by opcodes (HPC_SAMPLE)
+ *  19-Oct-2026  DVS  Bursts also with PRINT_SYS_STAT, inline execution in bursts
+ *  19-Oct-2026  DVS  Idle loop fast-forward off by default (IDLE 0), skipped
+ *                    instructions are not counted in run summary MIPS
+ *  19-Oct-2026  DVS  Base instruction times in table by opcodes (cpu_op_time)
  *
  */
 
@@ -84,7 +104,67 @@ t_value cr_io_addr_3;
 
 
 /* internal counters */
-double delay;
+t_int64 delay;				/* instruction delay, TIME_UNITS_PER_US of usec */
+t_uint64 cpu_instr_count = 0;		/* executed instructions (reverse execution) */
+t_uint64 cpu_tick_count = 0;		/* emulated time of executed instructions, usec */
+
+/* run limits (RUN -I/-T/-W, 0 = no limit) */
+t_uint64 run_instr_limit = 0;		/* instructions per run */
+t_uint64 run_time_limit = 0;		/* emulated time per run, usec */
+int32    run_watchdog = 0;		/* host time per run, sec */
+
+static int      run_limit_on = 0;
+static t_uint64 run_instr_stop;
+static t_uint64 run_time_stop;
+static int      run_host_check;
+static uint32   run_host_stop;
+static char     run_summary[CBUFSIZE] = "";
+
+/*
+ * idle loop detection (0 = off, 1 = fast-forward, 2 = fast-forward in real time),
+ * off by default: skipped loop passes are not executed.  M-20 has no clock
+ * device for SIMH idling, so waits in real time sleep on host directly.
+ */
+int32    idle_mode = 0;
+t_uint64 idle_skip_count = 0;		/* instructions skipped by fast-forward */
+
+#define  IDLE_MAX_BODY   64		/* max. instructions in idle loop */
+#define  IDLE_SLEEP_MS   10		/* host sleep and max. skip without events */
+
+typedef  struct idle_inst {
+    int     op;
+    t_int64 time;
+} IDLE_INST;
+
+static int        idle_head = -1;	/* loop head address (armed) */
+static int        idle_dirty;		/* MOSU changed since loop head */
+static int        idle_n;		/* instructions since loop head */
+static int32      idle_ticks;		/* ticks since loop head */
+static IDLE_INST  idle_body[IDLE_MAX_BODY];
+static uint16     idle_RA, idle_SMA;
+static int        idle_SW, idle_ROP;
+static t_value    idle_RK, idle_RR, idle_P1, idle_P2;
+static t_int64     idle_delay;
+
+/* real time pacing by emulated time (0 = off, else percent of M-20 speed) */
+int32    rt_speed = 0;
+int32    rt_slice = 10;			/* pacing interval, msec of host time */
+
+#define  RT_RESYNC_SEC    0.5		/* host is late more: restart schedule */
+#define  RT_MAX_SLEEP_MS  100		/* sleep in chunks for operator stop */
+
+static int      rt_on = 0;
+static double   rt_host_base;		/* host time of schedule base, sec */
+static t_uint64 rt_tick_base;		/* emulated time of schedule base, usec */
+static t_uint64 rt_next;		/* emulated time of next pacing point */
+static double   rt_drift;		/* host time - schedule at last point, sec */
+
+/* pacing statistics */
+static t_uint64 rt_points, rt_sleeps, rt_late, rt_resyncs;
+static double   rt_sleep_sum, rt_jitter_sum, rt_jitter_sq, rt_jitter_max;
+
+/* burst execution without per-instruction checks (0 = off, 1 = on) */
+int32    burst_mode = 1;
 
 /* special variable */
 
@@ -127,6 +207,65 @@ extern t_stat mt_format_tape (t_value *sum, int * ocodes, int user_first, int us
 extern t_stat mt_tape_io(t_value *sum, int * ocodes);
 
 
+/* reverse execution */
+extern int  rev_enable;
+extern int  rev_interval;
+extern int  rev_depth;
+extern void rev_after_inst (int op);
+extern void rev_run_start (void);
+extern void rev_run_stop (void);
+extern t_stat rev_show_history (FILE *st, UNIT *uptr, int32 val, CONST void *desc);
+
+/* symbol map */
+extern const char * m20_sym_name (int addr);
+extern t_stat m20_sym_show (FILE *st, UNIT *uptr, int32 val, CONST void *desc);
+extern t_addr m20_parse_addr (DEVICE *dptr, CONST char *cptr, CONST char **tptr);
+extern void m20_fprint_vm_addr (FILE *st, DEVICE *dptr, t_addr addr);
+
+/* control-flow graph */
+struct m20_cfg;
+extern struct m20_cfg * m20_cfg_build (const t_value *mem, const unsigned char *used,
+                                       const int *entries, int n);
+extern void m20_cfg_print (FILE *st, struct m20_cfg *cfg);
+extern void m20_cfg_dot (FILE *st, struct m20_cfg *cfg);
+extern void m20_cfg_free (struct m20_cfg *cfg);
+t_stat cpu_show_cfg (FILE *st, UNIT *uptr, int32 val, CONST void *desc);
+
+/* guest program profilers */
+extern void   m20_stat_io (int dev, int words, double emul_us);
+extern void   m20_stat_reset (void);
+extern void   m20_stat_check (void);
+extern void   m20_stat_run_start (void);
+extern void   m20_stat_run_stop (void);
+extern t_stat m20_stat_show (FILE *st);
+extern t_uint64 stat_file_check;
+
+extern int  call_profile;
+extern void call_prof_inst (int pc, int op, double time);
+extern int  loop_profile;
+extern void loop_prof_inst (int pc, int op, int ra, double time);
+extern int  smc_profile;
+extern void smc_prof_fetch (int pc, int op);
+extern void smc_prof_write (int addr);
+
+extern int    heatmap_on;
+extern void   m20_heat_exec (int addr);
+extern void   m20_heat_read (int addr);
+extern void   m20_heat_write (int addr);
+extern void   m20_heat_reset (void);
+extern t_stat m20_heat_show (FILE *st);
+
+extern int    hpc_sample;
+extern int    hpc_countdown;
+extern void   m20_hpc_run_start (void);
+extern void   m20_hpc_begin (void);
+extern void   m20_hpc_end (int pc, int op);
+
+extern void   m20_trace_compile (void);
+extern int    m20_trace_inst (int pc, int op);
+extern void   m20_trace_run_stop (t_stat r);
+
+
 /* SYS module references */
 
 extern t_value ieee_to_m20 (double d);
@@ -134,6 +273,8 @@ extern t_value ieee_to_m20 (double d);
 extern const char *m20_opname [M20_SYM_OPCODE_TABLE_SIZE];
 extern const char *m20_short_opname [M20_SYM_OPCODE_TABLE_SIZE];
 
+extern CTAB m20_cmd[];
+
 
 t_value  cdr_csum;
 t_value  cdr_rsum;
@@ -248,6 +389,22 @@ REG cpu_reg[] = {
         { DRDATA (USE_NEW_DIV, new_div, 8), PV_LEFT },
         { DRDATA (USE_NEW_SQRT, new_sqrt, 8), PV_LEFT },
         { DRDATA (USE_ADD_SBST, use_add_sbst, 8), PV_LEFT },
+        { DRDATA (REV_ENABLE, rev_enable, 8), PV_LEFT },
+        { DRDATA (REV_INTERVAL, rev_interval, 32), PV_LEFT },
+        { DRDATA (REV_DEPTH, rev_depth, 32), PV_LEFT },
+        { DRDATA (CALL_PROFILE, call_profile, 8), PV_LEFT },
+        { DRDATA (LOOP_PROFILE, loop_profile, 8), PV_LEFT },
+        { DRDATA (SMC_PROFILE, smc_profile, 8), PV_LEFT },
+        { DRDATA (HEATMAP, heatmap_on, 8), PV_LEFT },
+        { DRDATA (HPC_SAMPLE, hpc_sample, 32), PV_LEFT },
+        { DRDATA (INSTR_LIMIT, run_instr_limit, 64), PV_LEFT },
+        { DRDATA (TIME_LIMIT, run_time_limit, 64), PV_LEFT },
+        { DRDATA (WATCHDOG, run_watchdog, 32), PV_LEFT },
+        { DRDATA (IDLE, idle_mode, 8), PV_LEFT },
+        { DRDATA (IDLE_SKIP, idle_skip_count, 64), PV_LEFT },
+        { DRDATA (REALTIME, rt_speed, 32), PV_LEFT },
+        { DRDATA (REALTIME_SLICE, rt_slice, 32), PV_LEFT },
+        { DRDATA (BURST, burst_mode, 8), PV_LEFT },
 	{ 0 }
 };
 
@@ -256,6 +413,9 @@ REG cpu_reg[] = {
 MTAB cpu_mod[] = {
     { SHORT_SYM_OP, SHORT_SYM_OP, "short symbolic instruction name", "SHORT_SYM_OPCODE", NULL },
     { SHORT_SYM_OP, 0,            "long  symbolic instruction name", "LONG_SYM_OPCODE", NULL },
+    { MTAB_XTD|MTAB_VDV|MTAB_NMO, 0, "REVERSE", NULL, NULL, &rev_show_history, NULL, "execution history for BSTEP/BRUN" },
+    { MTAB_XTD|MTAB_VDV|MTAB_NMO, 0, "SYMBOLS", NULL, NULL, &m20_sym_show, NULL, "symbol map loaded by LOAD -S" },
+    { MTAB_XTD|MTAB_VDV|MTAB_NMO|MTAB_SHP, 0, "CFG", NULL, NULL, &cpu_show_cfg, NULL, "control-flow graph of MOSU from KRA (CFG=DOT for Graphviz)" },
     { 0 }
 };
 
@@ -272,7 +432,7 @@ DEVICE cpu_dev = {
 typedef  struct command_profile_stat {
     int      op_code;
     double   us_count;
-    double   us_time;
+    t_int64  us_time;				/* TIME_UNITS_PER_US of usec */
 } COMMAND_PROFILE_STAT, * PCOMMAND_PROFILE_STAT;
 
 
@@ -461,6 +621,11 @@ t_stat cpu_reset (DEVICE *dptr)
     sim_brk_types = (SWMASK('E')|SWMASK ('R')|SWMASK('W'));
     sim_brk_dflt = (SWMASK ('E'));
 
+    /* simulator specific commands (sim_vm_init is not called) */
+    sim_vm_cmd = m20_cmd;
+    sim_vm_parse_addr = m20_parse_addr;
+    sim_vm_fprint_addr = m20_fprint_vm_addr;
+
     //memset( MOSU, 0, sizeof(MOSU) );
 
     return SCPE_OK;
@@ -470,9 +635,9 @@ t_stat cpu_reset (DEVICE *dptr)
 
 
 /*
- * Get codeword from memory core.
+ * Get codeword from memory core (not counted in heatmap).
  */
-t_value mosu_load (int addr)
+static t_value mosu_peek (int addr)
 {
     t_value val;
     //uint32  res32;
@@ -498,6 +663,18 @@ t_value mosu_load (int addr)
 
 
 
+/*
+ * Get codeword from memory core.
+ */
+t_value mosu_load (int addr)
+{
+    addr &= MAX_ADDR_VALUE;
+    if (heatmap_on && sim_is_running) m20_heat_read (addr);
+    return mosu_peek (addr);
+}
+
+
+
 /*
  * Put codeword into memory core
  */
@@ -517,6 +694,9 @@ void mosu_store (int addr, t_value val)
       if (addr == MOSU_MODE_II_SPEC_BASE_ADDR+7) { val = 0;     }
     }
 
+    if (MOSU[addr] != val) idle_dirty = 1;
+    if (smc_profile && sim_is_running) smc_prof_write (addr);
+    if (heatmap_on && sim_is_running) m20_heat_write (addr);
     MOSU[addr] = val;
 }
 
@@ -2245,6 +2425,7 @@ t_stat ext_io_operation (int a1, t_value * sum)
 {
     t_stat err;
     int  codes_num;
+    t_int64 io_time;
 
     ext_io_ram_start = a1;        
     *sum = 0;
@@ -2265,7 +2446,9 @@ t_stat ext_io_operation (int a1, t_value * sum)
                            disable_mem_access, disable_checksum, &codes_num, sum );
         if (sim_deb && cpu_dev.dctrl)
 	    fprintf (sim_deb, "cpu: err=%d, codes_num=%04o\n", err,codes_num);
-         delay += (100000*codes_num);
+         io_time = TIME_US(100000) * codes_num;
+         delay += io_time;
+         m20_stat_io (STAT_IO_PUNCH, codes_num, TIME_TO_US (io_time));
          return err;
 	 /* Output to punch cards is NOT supported */
 	 //return STOP_PUNCHUNSUPP;
@@ -2298,7 +2481,9 @@ t_stat ext_io_operation (int a1, t_value * sum)
                                    &codes_num );
         if (sim_deb && cpu_dev.dctrl)
 	    fprintf (sim_deb, "cpu: err=%d, codes_num=%04o\n", err,codes_num);
-         delay += (50000*codes_num);
+         io_time = TIME_US(50000) * codes_num;
+         delay += io_time;
+         m20_stat_io (STAT_IO_PRINTER, codes_num, TIME_TO_US (io_time));
          return err;
 	 /* Output to printer is NOT supported */
 	 //return STOP_PRINTUNSUPP;
@@ -2310,7 +2495,9 @@ t_stat ext_io_operation (int a1, t_value * sum)
 	err = drum_io (sum,&codes_num);
         if (sim_deb && cpu_dev.dctrl)
 	    fprintf (sim_deb, "cpu: err=%d, codes_num=%04o sum=%015llo\n", err,codes_num,*sum);
-        delay += (40000+((double)codes_num)/6400);
+        io_time = TIME_US(40000) + (TIME_UNITS_PER_US/6400) * codes_num;
+        delay += io_time;
+        m20_stat_io (STAT_IO_DRUM, codes_num, TIME_TO_US (io_time));
 	return err;
         /* Magnetic drum storage device is NOT supported */
         //return STOP_DRUMUNSUPP;
@@ -2322,7 +2509,9 @@ t_stat ext_io_operation (int a1, t_value * sum)
 	err = mt_tape_io (sum,&codes_num);
         if (sim_deb && cpu_dev.dctrl)
 	    fprintf (sim_deb, "cpu: err=%d, codes_num=%04o sum=%015llo\n", err,codes_num,*sum);
-	delay += (75000+((double)codes_num/2500)); 
+	io_time = TIME_US(75000) + (TIME_UNITS_PER_US/2500) * codes_num;
+	delay += io_time;
+	m20_stat_io (STAT_IO_TAPE, codes_num, TIME_TO_US (io_time));
 	return err;
        /* Magnetic tape storage device is NOT supported */
        //return STOP_TAPEUNSUPP;
@@ -2333,7 +2522,9 @@ t_stat ext_io_operation (int a1, t_value * sum)
 	err = mt_format_tape (sum,&codes_num,ext_io_ram_start,ext_io_ram_end);
         if (sim_deb && cpu_dev.dctrl)
 	    fprintf (sim_deb, "cpu: err=%d codes_num=%04o\n", err, codes_num );
-	delay += (75000+((double)codes_num/2500)); 
+	io_time = TIME_US(75000) + (TIME_UNITS_PER_US/2500) * codes_num;
+	delay += io_time;
+	m20_stat_io (STAT_IO_TAPE, codes_num, TIME_TO_US (io_time));
 	return err;
         /* Tape formatting is NOT supported */
         //return STOP_TAPEFMTUNSUPP;
@@ -2346,10 +2537,28 @@ t_stat ext_io_operation (int a1, t_value * sum)
 
 
 
+/*
+ * Base execution time of every opcode (M-20 technical description).  Terms
+ * depending on operands (shift count, codes of card input) are added at
+ * the opcode; i/o transfer times are counted by devices.
+ */
+const t_int64 cpu_op_time[MAX_OPCODE_VALUE+1] = {
+    TIME_US(24.0), TIME_US(28.5), TIME_US(28.5), TIME_US(28.5), TIME_US(136.5), TIME_US(69.5), TIME_US(61.5), TIME_US(24.0),	/* 00-07 */
+    TIME_US(0.0), TIME_US(24.0), TIME_US(24.0), TIME_US(24.0), TIME_US(61.5), TIME_US(24.0), TIME_US(24.0), TIME_US(24.0),	/* 10-17 */
+    TIME_US(24.0), TIME_US(28.5), TIME_US(28.5), TIME_US(28.5), TIME_US(136.5), TIME_US(69.5), TIME_US(24.0), TIME_US(24.0),	/* 20-27 */
+    TIME_US(0.0), TIME_US(24.0), TIME_US(24.0), TIME_US(24.0), TIME_US(24.0), TIME_US(24.0), TIME_US(24.0), TIME_US(24.0),	/* 30-37 */
+    TIME_US(24.0), TIME_US(28.5), TIME_US(28.5), TIME_US(28.5), TIME_US(275.0), TIME_US(69.5), TIME_US(61.5), TIME_US(24.0),	/* 40-47 */
+    TIME_US(24.0), TIME_US(24.0), TIME_US(28.5), TIME_US(24.0), TIME_US(61.5), TIME_US(24.0), TIME_US(24.0), TIME_US(24.0),	/* 50-57 */
+    TIME_US(24.0), TIME_US(28.5), TIME_US(28.5), TIME_US(28.5), TIME_US(275.0), TIME_US(69.5), TIME_US(24.0), TIME_US(24.0),	/* 60-67 */
+    TIME_US(24.0), TIME_US(24.0), TIME_US(28.5), TIME_US(24.0), TIME_US(24.0), TIME_US(24.0), TIME_US(24.0), TIME_US(24.0) 	/* 70-77 */
+};
+
+
+
 /*
  * Execute one instruction, contained in register RK.
  */
-t_stat cpu_one_inst ()
+static t_stat cpu_one_inst (void)
 {
 	int addr_tags, op, a1, a2, a3, n = 0;
 	t_value x, y, t, xm, ym, xe, ye;
@@ -2373,21 +2582,21 @@ t_stat cpu_one_inst ()
 
 	/* test for memory contents overflow */
         if (memory_45_checking) {
-	  t = mosu_load(a1);
+	  t = mosu_peek(a1);
 	  if (t & ~WORD45) {
             if (sim_deb && cpu_dev.dctrl)
 	      fprintf (sim_deb, "cpu: OVERFLOW BEFORE: a1: t[%04o]=%018llo, t=%018llo\n", a1, t, t & ~WORD45 );
             ret_code = STOP_MEMORY_GARBAGE_DETECTED;
             goto done;
           }
-	  t = mosu_load(a2);
+	  t = mosu_peek(a2);
 	  if (t & ~WORD45) {
             if (sim_deb && cpu_dev.dctrl)
 	      fprintf (sim_deb, "cpu: OVERFLOW BEFORE: a2: t[%04o]=%018llo, t=%018llo\n", a2, t, t & ~WORD45  );
             ret_code = STOP_MEMORY_GARBAGE_DETECTED;
             goto done;
           }
-	  t = mosu_load(a3);
+	  t = mosu_peek(a3);
 	  if (t & ~WORD45) {
             if (sim_deb && cpu_dev.dctrl)
 	      fprintf (sim_deb, "cpu: OVERFLOW BEFORE: a3: t[%04o]=%018llo, t=%018llo\n", a3, t, t & ~WORD45  );
@@ -2419,7 +2628,7 @@ t_stat cpu_one_inst ()
 
 	switch (op) {
 	default:
-	        delay += 24.0;
+	        delay += cpu_op_time[op];
 		ret_code = STOP_BADCMD;
 		goto done;
 
@@ -2445,7 +2654,7 @@ add2:
 		if (err) { ret_code = err; goto done; }
 		mosu_store (a3, regRR);
 		trgSW = (regRR & SIGN) != 0;
-		delay += 28.5;
+		delay += cpu_op_time[op];
 		break;
 
 
@@ -2496,7 +2705,7 @@ add2:
 		if (err) { ret_code = err; goto done; }
 		mosu_store (a3, regRR);
 		trgSW = (int) (regRR >> BITS_36 & EXPONENT_VALUE_MASK) > EXP_OVF_VALUE;
-		delay += 69.5;
+		delay += cpu_op_time[op];
 		break;
 
 
@@ -2509,7 +2718,7 @@ add2:
 		if (err) { ret_code = err; goto done; }
 		mosu_store (a3, regRR);
 		trgSW = (int) (regRR >> BITS_36 & EXPONENT_VALUE_MASK) > EXP_OVF_VALUE;
-		delay += 136.5;
+		delay += cpu_op_time[op];
 		break;
 
 
@@ -2521,7 +2730,7 @@ add2:
 		if (err) { ret_code = err; goto done; }
 		mosu_store (a3, regRR);
 		trgSW = (int) (regRR >> BITS_36 & EXPONENT_VALUE_MASK) > EXP_OVF_VALUE;
-		delay += 275.0;
+		delay += cpu_op_time[op];
 		break;
 
 
@@ -2549,14 +2758,14 @@ add2:
 		//if (trgSW) goto sw1;
 		//if (!trgSW) trgSW = (int) (regRR >> BITS_36 & EXPONENT_VALUE_MASK) > EXP_OVF_VALUE;
              //sw1:
-		delay += 24.0;
+		delay += cpu_op_time[op];
 		break;
 
 
 	case OPCODE_ADD_ADDR_TO_EXP:        /* 006 = addition exponent and address  */
 		n = (a1 & EXPONENT_VALUE_MASK) - M20_MANTISSA_SHIFT;
 		y = mosu_load (a2);
-		delay += 61.5;
+		delay += cpu_op_time[op];
 add_exp:		
                 err = add_exponent (&regRR, y, n, op);
 		if (err) { ret_code = err; goto done; }
@@ -2565,20 +2774,20 @@ add_exp:
 		break;
 
 	case OPCODE_ADD_EXP_TO_EXP:         /* 026 = addition of exponents */
-		delay += 24.0;
+		delay += cpu_op_time[op];
                 x = mosu_load (a1);
 		n = (int) (x >> BITS_36 & EXPONENT_VALUE_MASK) - M20_MANTISSA_SHIFT; 
                 y = mosu_load (a2);
 		goto add_exp;
 
 	case OPCODE_SUB_ADDR_FROM_EXP:      /* 046 = subtraction address from exponent */
-		delay += 61.5;
+		delay += cpu_op_time[op];
 		n = M20_MANTISSA_SHIFT - (a1 & EXPONENT_VALUE_MASK);
 		y = mosu_load (a2);
 		goto add_exp;
 
 	case OPCODE_SUB_EXP_FROM_EXP:       /* 066 = subtraction of exponents */
-		delay += 24.0;
+		delay += cpu_op_time[op];
                 x = mosu_load (a1);
 		n = M20_MANTISSA_SHIFT - (int) (x >> BITS_36 & EXPONENT_VALUE_MASK);
                 y = mosu_load (a2);
@@ -2593,7 +2802,7 @@ add_exp:
 	    regRR = mosu_load (a1);  
 	    mosu_store (a3, regRR);
 	    /* w NOT changed and no AUTO-STOP */
-	    delay += 24.0;
+	    delay += cpu_op_time[op];
 	    break;
 
 
@@ -2611,14 +2820,14 @@ add_exp:
 		}
 		mosu_store (a3, regRR);
 		/* w NOT changed */
-		delay += 24.0;
+		delay += cpu_op_time[op];
 		break;
 
 
 	case OPCODE_BLANKING_040:           /* 040 = blank */
 #if 1
                 if (enable_opcode_040_hack) {
-		  delay += 24.0;
+		  delay += cpu_op_time[op];
                   x = mosu_load (a1);
                   n = (x >> BITS_12) & MAX_ADDR_VALUE;
 		  if (regRA < n) regKRA = a2;
@@ -2629,14 +2838,14 @@ add_exp:
 	        regRR = 0;
 	        mosu_store( a3, regRR );
 		/* w NOT changed */
-                delay += 24.0;
+                delay += cpu_op_time[op];
 		break;
 
 	case OPCODE_BLANKING_060:           /* 060 = blank */
 	        regRR = 0;
 	        mosu_store( a3, regRR );
 		/* w NOT changed */
-		delay += 24.0;
+		delay += cpu_op_time[op];
 		break;
 
 
@@ -2645,7 +2854,7 @@ add_exp:
 		regRR = mosu_load (a1) ^ mosu_load (a2);
 log_comp:		
 		trgSW = (regRR == 0);
-		delay += 24.0;
+		delay += cpu_op_time[op];
 		if ((op == OPCODE_COMPARE_WITH_STOP) && !trgSW)  {
                     ret_code = STOP_ASSERT; /* STOP on miscompare */
                     goto done;
@@ -2672,7 +2881,7 @@ add_mant:
                 trgSW = (y & BIT37) != 0;
 		//if (op == 013) trgSW = (y & BIT37) != 0;
                 //if (op == 033) trgSW = (regRR & SIGN) != 0; //?
-		delay += 24.0;
+		delay += cpu_op_time[op];
 		break;
 
 	case OPCODE_SUB_CMDS:       /* 033 = subtraction of commands */
@@ -2692,7 +2901,7 @@ add_opc:
                 trgSW = (y & BIT46) != 0;
 		//if (op == 053) trgSW = (y & BIT46) != 0;
                 //if (op == 073) trgSW = (regRR & SIGN) != 0; 
-		delay += 24.0;
+		delay += cpu_op_time[op];
 		break;
 
 	case OPCODE_SUB_OPCS:      /* 073 = subtraction of operaion codes */
@@ -2704,7 +2913,7 @@ add_opc:
 
 	case OPCODE_SHIFT_MANTISSA_BY_ADDR:      /* 014 = shift mantissa by address */
 		n = (a1 & EXPONENT_VALUE_MASK) - M20_MANTISSA_SHIFT;
-		delay += 61.5 + 1.5 * (n>0 ? n : -n);
+		delay += cpu_op_time[op] + TIME_US(1.5) * (n>0 ? n : -n);
 sh_mant:		
                 y = mosu_load (a2);
 		regRR = (y & ~MANTISSA);
@@ -2718,13 +2927,13 @@ sh_mant:
 
 	case OPCODE_SHIFT_MANTISSA_BY_EXP:    /* 034 = shift mantissa by exponent of number */
 		n = (int) (mosu_load (a1) >> BITS_36 & EXPONENT_VALUE_MASK) - M20_MANTISSA_SHIFT;
-		delay += 24.0 + 1.5 * (n>0 ? n : -n);
+		delay += cpu_op_time[op] + TIME_US(1.5) * (n>0 ? n : -n);
 		goto sh_mant;
 
 
 	case OPCODE_SHIFT_CODE_BY_ADDR:       /* 054 = shift by address */
 		n = (a1 & EXPONENT_VALUE_MASK) - M20_MANTISSA_SHIFT;
-		delay += 61.5 + 1.5 * (n>0 ? n : -n);
+		delay += cpu_op_time[op] + TIME_US(1.5) * (n>0 ? n : -n);
 shift_code:		
                 regRR = mosu_load (a2);
 		if (n > 0) regRR = (regRR << n); 
@@ -2736,7 +2945,7 @@ shift_code:
 
 	case OPCODE_SHIFT_CODE_BY_EXP:        /* 074 = shift by exponet of number */
 		n = (int) (mosu_load (a1) >> BITS_36 & EXPONENT_VALUE_MASK) - M20_MANTISSA_SHIFT;
-		delay += 24 + 1.5 * (n>0 ? n : -n);
+		delay += cpu_op_time[op] + TIME_US(1.5) * (n>0 ? n : -n);
 		goto shift_code;
 
 	case OPCODE_ADD_CYCLIC:        /* 007 = cyclic addition */
@@ -2758,7 +2967,7 @@ shift_code:
 		//regRR &= WORD45;
 		regRR |= (t & MANTISSA);
 		mosu_store (a3, regRR);
-		delay += 24.0;
+		delay += cpu_op_time[op];
 		break;
 
 	case OPCODE_SUB_CYCLIC:        /* 027 = cyclic subtraction */
@@ -2794,7 +3003,7 @@ shift_code:
 		regRR &= WORD45;
                 fprintf( stderr, "regRR=%015llo\n", regRR );
 		mosu_store (a3, regRR);
-		delay += 24.0;
+		delay += cpu_op_time[op];
 		break;
 
 	case OPCODE_SHIFT_CYCLIC:      /* 067 = cyclic shift */
@@ -2804,8 +3013,8 @@ shift_code:
 		mosu_store (a3, regRR);
                 trgSW = (a3 == 0);
 		/* w not chaned (wrong!). */
-		//delay += 60.0;
-                delay += 24.0;
+		//delay += TIME_US(60.0);
+                delay += cpu_op_time[op];
 		break;
 
 
@@ -2818,7 +3027,7 @@ shift_code:
         case OPCODE_STOP_037:    /* 037 = machine stop */
         case OPCODE_STOP_057:    /* 057 = machine stop */
 	case OPCODE_STOP_077:    /* 077 = machine stop */
-		delay += 24.0;
+		delay += cpu_op_time[op];
 		regRR = 0;
 		mosu_store (a3, regRR);
 		/* If addresses is equal 0, then assume that is normal condition (goo stop). (!) */
@@ -2830,16 +3039,16 @@ shift_code:
 		regRR = ((t_value)OPCODE_CHANGE_RA_BY_ADDR<<BITS_36) | (a1 << BITS_12);
 		mosu_store (a3, regRR);
 		regRA = a2;
-		//delay += 24.0;
-                delay += 28.5;
+		//delay += TIME_US(24.0);
+                delay += cpu_op_time[op];
 		break;
 
 	case OPCODE_CHANGE_RA_BY_CODE :     /* 072 = change address register by address codeword */
 		regRR = ((t_value)OPCODE_CHANGE_RA_BY_ADDR<<BITS_36) | (a1 << BITS_12);
 		mosu_store (a3, regRR);
 		regRA = mosu_load (a2) >> BITS_12 & MAX_ADDR_VALUE;
-		//delay += 24.0;
-                delay += 28.5;
+		//delay += TIME_US(24.0);
+                delay += cpu_op_time[op];
 		break;
 
 
@@ -2847,66 +3056,66 @@ shift_code:
 		regRR = ((t_value)OPCODE_JUMP_WITH_RETURN<<BITS_36) | (a1 << BITS_12);
 		mosu_store (a3, regRR);
 		regKRA = a2;
-		delay += 24.0;
+		delay += cpu_op_time[op];
 		break;
 
 	case OPCODE_COND_JUMP_BY_SIG_W_1:   /* 036 = transfer control by condition w=1 */
 		regRR = mosu_load (a1);
 		mosu_store (a3, regRR);
 		if (trgSW) regKRA = a2;
-		delay += 24.0;
+		delay += cpu_op_time[op];
 		break;
 
 	case OPCODE_JUMP_BY_ADDR:           /* 056 = unconditional transfer control */
 		regRR = mosu_load (a1);
 		mosu_store (a3, regRR);
 		regKRA = a2;
-		delay += 24.0;
+		delay += cpu_op_time[op];
 		break;
 
 	case OPCODE_COND_JUMP_BY_SIG_W_0:   /* 076 = transfer control by condition w=0 */
 		regRR = mosu_load (a1);
 		mosu_store (a3, regRR);
 		if (!trgSW) regKRA = a2;
-		delay += 24.0;
+		delay += cpu_op_time[op];
 		break;
 
 
 	case OPCODE_GOTO_AFTER_CYCLE_BY_PA_012:   /* 012 = transfer control by condition < */
 		if (regRA < (unsigned)a1) regKRA = a2;
 		regRA = a3;
-		delay += 24.0;
+		delay += cpu_op_time[op];
 		break;
 
 	case OPCODE_GOTO_AFTER_CYCLE_BY_PA_032:   /* 032 = transfer control by condition >= */
                 if (regRA >= (unsigned)a1) regKRA = a2;
 		regRA = a3;
-		delay += 24.0;
+		delay += cpu_op_time[op];
 		break;
 
 
 	case OPCODE_GOTO_AFTER_CYCLE_BY_PA_SIG_W_1_011:    /* 011 = transfer control by condition < and w=1 */
                 if (regRA < (unsigned)a1 && trgSW) regKRA = a2;
 		regRA = a3;
-		delay += 24.0;
+		delay += cpu_op_time[op];
 		break;
 
 	case OPCODE_GOTO_AFTER_CYCLE_BY_PA_SIG_W_1_031:    /* 031 = transfer control by condition >= and w=1 */
 		if (regRA >= (unsigned)a1 && trgSW) regKRA = a2;
 		regRA = a3;
-		delay += 24.0;
+		delay += cpu_op_time[op];
 		break;
 
 	case OPCODE_GOTO_AFTER_CYCLE_BY_PA_SIG_W_0_051:    /* 051 = transfer control by condition < and w=0 */
                 if (regRA < (unsigned)a1 && !trgSW) regKRA = a2;
 		regRA = a3;
-		delay += 24.0;
+		delay += cpu_op_time[op];
 		break;
 
 	case OPCODE_GOTO_AFTER_CYCLE_BY_PA_SIG_W_0_071:    /* 071 = transfer control by condition >= and w=0 */
 		if (regRA >= (unsigned)a1 && !trgSW) regKRA = a2;
 		regRA = a3;
-		delay += 24.0;
+		delay += cpu_op_time[op];
 		break;
 
 
@@ -2940,7 +3149,8 @@ shift_code:
                     ret_code = err;
                     goto done;
                 }
-		delay += (50000*cdr_rcodes);
+		delay += TIME_US(50000) * cdr_rcodes;
+		m20_stat_io (STAT_IO_CARD, cdr_rcodes, 50000.0*cdr_rcodes);
 		if (cdr_control_blocking) goto store_chksum;
 		if (cdr_stop_blocking) {
                   regKRA = a2;
@@ -2968,7 +3178,8 @@ shift_code:
 	            fprintf (sim_deb, "cpu: opcode=30: regKRA=%d,a1=%d,a2=%d,a3=%d\n", regKRA,a1,a2,a3);
                 err = read_card(&cdr_csum,&cdr_rsum,&cdr_rcodes,&cdr_stop_blocking,&cdr_control_blocking);
 		if (err) { ret_code = err; goto done; }
-		delay += (50000*cdr_rcodes);
+		delay += TIME_US(50000) * cdr_rcodes;
+		m20_stat_io (STAT_IO_CARD, cdr_rcodes, 50000.0*cdr_rcodes);
 		if (cdr_control_blocking) goto store_chksum_30;
 		if (cdr_csum != cdr_rsum) {
 		  regKRA = a2;
@@ -2981,7 +3192,7 @@ shift_code:
 	case OPCODE_IO_EXT_DEV_TO_MEM_050:  /* 050 = external device i/o setup */
 		err = ext_io_setup (a1, a2, a3);
 		if (err) { ret_code = err; goto done; }
-		delay += 24.0;
+		delay += cpu_op_time[op];
 		break;
 
 	case OPCODE_IO_EXT_DEV_TO_MEM_070:  /* 070 = external device i/o exec */
@@ -3006,28 +3217,28 @@ shift_code:
 		   if (a2) regKRA = a2;
 		  skip_done: ;
 		}
-		delay += 24.0; 
+		delay += cpu_op_time[op]; 
 		break;
 	}
 
 
 	/* test for memory contents overflow */
 	if (memory_45_checking) {
-	  t = mosu_load(a1);
+	  t = mosu_peek(a1);
 	  if (t & ~WORD45) {
             if (sim_deb && cpu_dev.dctrl)
 	      fprintf (sim_deb, "cpu: OVERFLOW AFTER: a1: t[%04o]=%018llo, t=%018llo\n", a1, t, t & ~WORD45 );
             ret_code = STOP_MEMORY_GARBAGE_DETECTED;
             goto done;
           }
-	  t = mosu_load(a2);
+	  t = mosu_peek(a2);
 	  if (t & ~WORD45) {
             if (sim_deb && cpu_dev.dctrl)
 	      fprintf (sim_deb, "cpu: OVERFLOW AFTER: a2: t[%04o]=%018llo, t=%018llo\n", a2, t, t & ~WORD45  );
             ret_code = STOP_MEMORY_GARBAGE_DETECTED;
             goto done;
           }
-	  t = mosu_load(a3);
+	  t = mosu_peek(a3);
 	  if (t & ~WORD45) {
             if (sim_deb && cpu_dev.dctrl)
 	      fprintf (sim_deb, "cpu: OVERFLOW AFTER: a3: t[%04o]=%018llo, t=%018llo\n", a3, t, t & ~WORD45  );
@@ -3062,49 +3273,404 @@ done:
 void print_commad_run_profile_stat(void)
 {
    int i, op;
-   double sum_time, sum_count;
+   double sum_count;
+   t_int64 sum_time;
 
    printf("\n*** Command time profile stat ***\n");
-   sum_time = sum_count = 0;
+   sum_time = 0;
+   sum_count = 0;
    for( i=0; i<M20_SYM_OPCODE_TABLE_SIZE; i++ ) {
        op = cmd_profile_table[i].op_code;
        if (cmd_profile_table[i].us_count > 0) {
          sum_time += cmd_profile_table[i].us_time;
          sum_count += cmd_profile_table[i].us_count;
          printf("opcode=%02o   count=%-9.0f  times=%-15.2f  avg_time=%-15.2f   (%s)\n",
-                 op, cmd_profile_table[i].us_count, cmd_profile_table[i].us_time, 
-                 cmd_profile_table[i].us_time/cmd_profile_table[i].us_count, m20_opname[i] );
+                 op, cmd_profile_table[i].us_count, TIME_TO_US(cmd_profile_table[i].us_time), 
+                 TIME_TO_US(cmd_profile_table[i].us_time)/cmd_profile_table[i].us_count, m20_opname[i] );
        }
    }
-   printf("Summary:  times=%.2f  count=%.0f  avg_time=%.2f\n", sum_time, sum_count, sum_time/sum_count );
+   printf("Summary:  times=%.2f  count=%.0f  avg_time=%.2f\n", TIME_TO_US(sum_time), sum_count, 
+          TIME_TO_US(sum_time)/sum_count );
    printf("**********\n\n");
 }
 
 
 
 
+/*
+ * Execute one fetched instruction (regRK) and count it.  Inline copy
+ * is used by burst loop of cpu_run(), cpu_exec_inst() by others.
+ */
+static SIM_INLINE t_stat cpu_exec_fetched (void)
+{
+    t_stat r;
+
+	regKRA += 1;				/* increment RVK */
+
+	if (0) fprintf( stderr, "regKRA=%04o\n", regKRA );
+	r = cpu_one_inst ();
+	//if (r) return r;			/* one instr; error? */
+	if (0) fprintf( stderr, "regKRA=%04o\n", regKRA );
+
+	// save some state
+        old_opcode = (int) (regRK >> BITS_36) & MAX_OPCODE_VALUE;
+
+	// memory breakpoint stops before execution
+	if (r != STOP_MEM) cpu_instr_count++;
+
+	// special check for stop codes
+        if ((r == STOP_NEGSQRT) || (r==STOP_CRBADSUM) || (r==STOP_READERR) || (r==STOP_STOP) || 
+            (r==STOP_TAPEREADERR)) {
+            if (regKRA > 0001) regKRA -= 1;	/* decrement RVK */
+            regRK = MOSU[regKRA];
+        }
+        if ((r==STOP_ASSERT) || (r==STOP_NOCD) || (r == STOP_DIVMOVF) || (r==STOP_DIVZERO)) {
+            //regKRA -= 1;	/* decrement RVK */
+            regRK = MOSU[regKRA-1];
+        }
+
+	return r;
+}
+
+
+t_stat cpu_exec_inst (void)
+{
+    return cpu_exec_fetched ();
+}
+
+
+
+/*
+ * Idle loop detection:  a loop is armed on backward jump, and when
+ * the next pass comes back to the same head without MOSU changes and
+ * with the same registers, it is state invariant and can't end until
+ * the next SCP event, step count or run limit.  The passes up to this
+ * point are skipped by counters only.  If the fraction of instruction
+ * time (delay) differs, some passes are counted together, until the
+ * timing repeats too.
+ */
+static void idle_arm (int head)
+{
+    idle_head = head;
+    idle_dirty = 0;
+    idle_n = 0;
+    idle_ticks = 0;
+    idle_RA = regRA;   idle_SMA = regSMA;
+    idle_SW = trgSW;   idle_ROP = regROP;
+    idle_RK = regRK;   idle_RR = regRR;   idle_P1 = regP1;   idle_P2 = regP2;
+    idle_delay = delay;
+}
+
+static int idle_same_state (void)
+{
+    return (idle_RA == regRA) && (idle_SMA == regSMA) &&
+           (idle_SW == trgSW) && (idle_ROP == regROP) &&
+           (idle_RK == regRK) && (idle_RR == regRR) &&
+           (idle_P1 == regP1) && (idle_P2 == regP2);
+}
+
+static int idle_dev_pending (void)
+{
+    UNIT   *uptr;
+    DEVICE *dptr;
+    int     i;
+
+    for (uptr = sim_clock_queue; uptr != QUEUE_LIST_END; uptr = uptr->next) {
+        for (i = 0; (dptr = sim_devices[i]) != NULL; i++) {
+            if ((uptr >= dptr->units) && (uptr < dptr->units + dptr->numunits))
+                return TRUE;			/* M-20 device, not SCP timer */
+        }
+    }
+    return FALSE;
+}
+
+static t_stat idle_fast_forward (void)
+{
+    t_uint64 k, max_k, num, t;
+    int      i, j, real_time;
+
+    if ((idle_n == 0) || (idle_ticks <= 0) || (sim_interval <= 1)) return SCPE_OK;
+
+    /* without device events and limits only operator can stop the loop */
+    real_time = (idle_mode == 2) ||
+                (!idle_dev_pending () && !sim_step &&
+                 !(run_limit_on && (run_instr_stop || run_time_stop)));
+
+    k = (t_uint64) (sim_interval - 1) / idle_ticks;	/* stay before next event */
+    if (real_time) {
+        max_k = (IDLE_SLEEP_MS * 1000) / idle_ticks;
+        if (k > max_k) k = max_k;
+    }
+    if (sim_step) {
+        max_k = (t_uint64) (sim_step - 1) / idle_n;
+        if (k > max_k) k = max_k;
+    }
+    if (run_limit_on && run_instr_stop) {
+        max_k = (run_instr_stop - cpu_instr_count - 1) / idle_n;
+        if (k > max_k) k = max_k;
+    }
+    if (run_limit_on && run_time_stop) {
+        max_k = (run_time_stop - cpu_tick_count - 1) / idle_ticks;
+        if (k > max_k) k = max_k;
+    }
+    if (k == 0) return SCPE_OK;
+
+    num = k * idle_n;
+    t   = k * idle_ticks;
+    if (real_time && (t >= 1000) && !rt_on)	/* REALTIME sleeps itself */
+        sim_os_ms_sleep ((unsigned int) (t / 1000));
+
+    sim_interval    -= (int32) t;
+    cpu_tick_count  += t;
+    cpu_instr_count += num;
+    idle_skip_count += num;
+    if (sim_step) sim_step -= (int32) num;
+
+    if (print_sys_stat) {
+        for( j=0; j<idle_n; j++ ) {
+            if (idle_body[j].time <= 0) continue;
+            for( i=0; i<M20_SYM_OPCODE_TABLE_SIZE; i++ ) {
+                if (cmd_profile_table[i].op_code == idle_body[j].op) {
+                    cmd_profile_table[i].us_count += k;
+                    cmd_profile_table[i].us_time  += k * idle_body[j].time;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (stop_cpu) sim_interval = 0;		/* operator stop while sleeping */
+    if (run_limit_on && run_host_check && ((int32) (sim_os_msec () - run_host_stop) >= 0))
+        return STOP_WATCHDOG;
+
+    return SCPE_OK;
+}
+
+static int idle_after_inst (int pc, int op, int ticks, t_int64 time)
+{
+    switch (op) {
+      case OPCODE_INPUT_CODES_FROM_PUNCH_CARDS_WITH_STOP:
+      case OPCODE_INPUT_CODES_FROM_PUNCH_CARDS:
+      case OPCODE_IO_EXT_DEV_TO_MEM_050:
+      case OPCODE_IO_EXT_DEV_TO_MEM_070:
+        idle_head = -1;				/* external devices */
+        return FALSE;
+      default:
+        break;
+    }
+
+    if (idle_head >= 0) {
+        if (idle_n < IDLE_MAX_BODY) {
+            idle_body[idle_n].op   = op;
+            idle_body[idle_n].time = time;
+        }
+        idle_n++;
+        idle_ticks += ticks;
+    }
+
+    if (regKRA > pc) {				/* no backward jump */
+        if (idle_n > IDLE_MAX_BODY) idle_head = -1;
+        return FALSE;
+    }
+
+    if ((regKRA == idle_head) && !idle_dirty && (idle_n <= IDLE_MAX_BODY) && idle_same_state ()) {
+        if (idle_delay != delay) return FALSE;	/* other timing phase */
+        return TRUE;				/* idle, skip in idle_skip */
+    }
+    idle_arm (regKRA);
+
+    return FALSE;
+}
+
+static t_stat idle_skip (void)
+{
+    t_stat r;
+
+    r = idle_fast_forward ();
+    idle_arm (regKRA);
+    return r;
+}
+
+
+
+/*
+ * Real time pacing:  host time is scheduled by emulated time (ticks of
+ * instructions delays), not by instruction count.  Every REALTIME_SLICE
+ * msec the host sleeps until the schedule, so oversleep of one sleep is
+ * corrected by the next one.  If host is too slow, the schedule restarts.
+ */
+static t_uint64 rt_slice_ticks (void)
+{
+    t_uint64 t;
+
+    t = (t_uint64) (rt_slice > 0 ? rt_slice : 1) * 10 * rt_speed;	/* usec */
+    return (t > 0) ? t : 1;
+}
+
+static void rt_start (void)
+{
+    rt_on = (rt_speed > 0);
+    if (!rt_on) return;
+
+    rt_host_base = sim_timenow_double ();
+    rt_tick_base = cpu_tick_count;
+    rt_next = cpu_tick_count + rt_slice_ticks ();
+}
+
+static void rt_pace (void)
+{
+    double   target, now, ahead, jitter;
+    unsigned ms;
+
+    target = rt_host_base + (double) (cpu_tick_count - rt_tick_base) / (rt_speed * 10000.0);
+    now = sim_timenow_double ();
+    ahead = target - now;
+    rt_points++;
+
+    if (ahead > 0) {
+        rt_sleeps++;
+        rt_sleep_sum += ahead;
+        while ((ahead > 0) && !stop_cpu) {
+            ms = (unsigned) (ahead * 1000.0 + 0.5);
+            if (ms == 0) break;
+            if (ms > RT_MAX_SLEEP_MS) ms = RT_MAX_SLEEP_MS;
+            sim_os_ms_sleep (ms);
+            ahead = target - sim_timenow_double ();
+        }
+        if (stop_cpu) sim_interval = 0;		/* operator stop while sleeping */
+        jitter = (ahead < 0) ? -ahead : ahead;
+        rt_jitter_sum += jitter;
+        rt_jitter_sq  += jitter * jitter;
+        if (jitter > rt_jitter_max) rt_jitter_max = jitter;
+        rt_drift = -ahead;
+    }
+    else {
+        rt_late++;
+        rt_drift = -ahead;
+        if (rt_drift > RT_RESYNC_SEC) {		/* can't catch up */
+            rt_resyncs++;
+            rt_host_base = now;
+            rt_tick_base = cpu_tick_count;
+            rt_drift = 0;
+        }
+    }
+
+    rt_next = cpu_tick_count + rt_slice_ticks ();
+}
+
+static void rt_show (FILE *st)
+{
+    double avg, dev;
+
+    if (rt_speed > 0)
+        fprintf (st, "M-20 real time: %d%% of M-20 speed, slice %d ms\n", rt_speed, rt_slice);
+    else
+        fprintf (st, "M-20 real time: disabled (DEPOSIT REALTIME 100)\n");
+    if (rt_points == 0) return;
+
+    avg = dev = 0;
+    if (rt_sleeps) {
+        avg = rt_jitter_sum / rt_sleeps;
+        dev = rt_jitter_sq / rt_sleeps - avg * avg;
+        dev = (dev > 0) ? sqrt (dev) : 0;
+    }
+    fprintf (st, "  pacing points: %llu, sleeps: %llu, late: %llu, resyncs: %llu\n",
+             rt_points, rt_sleeps, rt_late, rt_resyncs);
+    fprintf (st, "  sleep time:    %.3f s\n", rt_sleep_sum);
+    fprintf (st, "  jitter:        avg %.3f ms, stddev %.3f ms, max %.3f ms\n",
+             avg * 1000.0, dev * 1000.0, rt_jitter_max * 1000.0);
+    fprintf (st, "  drift:         %.3f ms\n", rt_drift * 1000.0);
+}
+
+
+
+/*
+ * Burst execution:  devices complete synchronously and the event queue
+ * is usually empty, so instructions are run in bursts up to the next
+ * SCP event, step count or run limit.  Inside a burst there are no
+ * event, breakpoint, trace and call/loop profile checks (PRINT_SYS_STAT
+ * command profile is counted), and sim_interval and the tick counter are
+ * reconciled once per burst.  A burst ends before and after i/o
+ * instructions, which may schedule device events.
+ */
+static int32 burst_ticks (void)		/* emulated time to next stop */
+{
+    int32 t = sim_interval;
+
+    if (rt_on && ((t_int64) (rt_next - cpu_tick_count) < t))
+        t = (int32) (rt_next - cpu_tick_count);
+    if (run_limit_on && run_time_stop && ((t_int64) (run_time_stop - cpu_tick_count) < t))
+        t = (int32) (run_time_stop - cpu_tick_count);
+    return t;
+}
+
+static t_uint64 burst_count (void)	/* instruction count of next stop */
+{
+    t_uint64 n = ~((t_uint64) 0);
+
+    if (sim_step)
+        n = cpu_instr_count + sim_step;
+    if (run_limit_on && run_instr_stop && (run_instr_stop < n))
+        n = run_instr_stop;
+    if (run_limit_on && run_host_check && (((cpu_instr_count | 07777) + 1) < n))
+        n = (cpu_instr_count | 07777) + 1;	/* watchdog check */
+    if (stat_file_check && (stat_file_check < n))
+        n = stat_file_check;
+    return n;
+}
+
+static SIM_INLINE void cpu_prof_count (int op, t_int64 time)
+{
+    /* PRINT_SYS_STAT, cmd_profile_table is in order of opcodes */
+    if (time > 0) {
+        cmd_profile_table[op].us_count += 1;
+        cmd_profile_table[op].us_time  += time;
+    }
+}
+
+static int cpu_delay_ticks (void)		/* count down delay to next instr */
+{
+    int ticks = 1;
+
+    if (delay > 0) {
+        /* as (int)(delay - DBL_EPSILON) of double usec delay */
+        ticks += (int)(delay / TIME_UNITS_PER_US);
+        if ((delay <= TIME_US(2)) && ((delay % TIME_UNITS_PER_US) == 0)) ticks--;
+    }
+    delay -= TIME_US(ticks);
+    return ticks;
+}
+
+
+
 /*
  * Main instruction fetch/decode loop
  */
-t_stat sim_instr (void)
+static t_stat cpu_run (void)
 {
     t_stat r;
     int ticks;
-    int addr_tags, a1, a2, a3, t_sw, op, i;
+    int addr_tags, a1, a2, a3, t_sw, op, pc, ra, i;
     t_value m1,m2,m3, t_ra, t_rr;
     char c1,c2,c3;
-    double old_delay, instr_time;
+    t_int64 old_delay, instr_time;
+    int32 budget, left, n;
+    t_uint64 start_count, max_count, done;
+    int idle_ff, traced, heat, idle, prof;
 
     /* Restore register state */
     regKRA = regKRA & MAX_ADDR_VALUE;	        /* mask KRA */
     sim_cancel_step ();				/* defang SCP step */
     delay = 0;
+    idle_head = -1;
+    rt_start ();
 
     /* Main instruction fetch/decode loop */
     for (;;) {
 	if (sim_interval <= 0) {		/* check clock queue */
   	  r = sim_process_event ();
 	 if (r) return r;
+	  idle_head = -1;			/* devices may change state */
 	}
 
 	if (regKRA >= MAX_MEM_SIZE) {		/*     */
@@ -3117,18 +3683,50 @@ t_stat sim_instr (void)
 	    return STOP_IBKPT;			/* stop simulation */
 	}
 
+	idle_ff = FALSE;
+	if (burst_mode && !(sim_deb && cpu_dev.dctrl) && !sim_brk_summ && !rev_enable &&
+	    !call_profile && !loop_profile && !smc_profile && !hpc_sample) {
+	    budget = left = burst_ticks ();	/* loop state is kept in locals */
+	    start_count = cpu_instr_count;
+	    max_count = burst_count () - start_count;
+	    heat = heatmap_on;
+	    idle = idle_mode && !heatmap_on;
+	    prof = print_sys_stat;
+	    done = 0;
+	    for (;;) {				/* burst to next event or limit */
+		pc = regKRA;
+		regRK = MOSU[pc];
+		op = regRK >> BITS_36 & MAX_OPCODE_VALUE;
+		if (heat) m20_heat_exec (pc);
+		old_delay = delay;
+		r = cpu_exec_fetched ();
+		instr_time = delay - old_delay;
+		if (prof) cpu_prof_count (op, instr_time);
+		ticks = cpu_delay_ticks ();
+		left -= ticks;
+		if (r || (left <= 0) || (++done >= max_count) ||
+		    OPCODE_IS_IO (op) || (regKRA >= MAX_MEM_SIZE) ||
+		    OPCODE_IS_IO (MOSU[regKRA] >> BITS_36 & MAX_OPCODE_VALUE))
+		    break;
+		if (idle && (idle_ff = idle_after_inst (pc, op, ticks, instr_time)))
+		    break;			/* fast-forward below */
+	    }
+	    n = (int32) (cpu_instr_count - start_count);
+	    sim_interval -= budget - left;	/* reconcile */
+	    cpu_tick_count += budget - left;
+	    if (r && prof) print_commad_run_profile_stat();
+	    goto inst_done;
+	}
+
 	regRK = MOSU[regKRA];				/* get instruction */
 
-	op = -1;
-	if (print_sys_stat) {
-          old_delay = delay;
-          op = regRK >> BITS_36 & MAX_OPCODE_VALUE;
-	}
+	pc = regKRA;
+	ra = regRA;
+	old_delay = delay;
+	op = regRK >> BITS_36 & MAX_OPCODE_VALUE;
 
-	if (sim_deb && cpu_dev.dctrl) {
-	    if (disable_is2_trace) {
-	      if ((regKRA >= IS2_START_ADDRESS) && (regKRA <= IS2_END_ADDRESS)) goto trace_before_done;
-	    }
+	traced = (sim_deb && cpu_dev.dctrl) && m20_trace_inst (pc, op);
+	if (traced) {
 	    addr_tags = regRK >> BITS_42 & MAX_ADDR_TAG_VALUE;
 	    a1 = regRK >> BITS_24 & MAX_ADDR_VALUE;
 	    a2 = regRK >> BITS_12 & MAX_ADDR_VALUE;
@@ -3142,7 +3740,8 @@ t_stat sim_instr (void)
                 for( i=0; i<100; i++ ) fprintf (sim_deb, "-"); 
                 fprintf (sim_deb, "\n"); 
              }
-	    fprintf (sim_deb, "cpu: %04o: ", regKRA);
+	    if (m20_sym_name (regKRA)) fprintf (sim_deb, "cpu: %04o <%s>: ", regKRA, m20_sym_name (regKRA));
+	    else fprintf (sim_deb, "cpu: %04o: ", regKRA);
 	    fprint_sym (sim_deb, regKRA, &regRK, 0, SWMASK ('M'));
 	    fprintf (sim_deb, "\n");
 	    if (debug_dump_regs) {
@@ -3159,51 +3758,30 @@ t_stat sim_instr (void)
               }
 	    }
             if (debug_dump_regs || debug_dump_mem) fprintf (sim_deb, "\n");
-          trace_before_done: {};
 	}
 
-	regKRA += 1;				/* increment RVK */
-
-	if (0) fprintf( stderr, "regKRA=%04o\n", regKRA );
-	r = cpu_one_inst ();
-	//if (r) return r;			/* one instr; error? */
-	if (0) fprintf( stderr, "regKRA=%04o\n", regKRA );
-
-	// save some state
-        old_opcode = (int) (regRK >> BITS_36) & MAX_OPCODE_VALUE;
-
-	// special check for stop codes
-        if ((r == STOP_NEGSQRT) || (r==STOP_CRBADSUM) || (r==STOP_READERR) || (r==STOP_STOP) || 
-            (r==STOP_TAPEREADERR)) {
-            if (regKRA > 0001) regKRA -= 1;	/* decrement RVK */
-            regRK = MOSU[regKRA];
-        }
-        if ((r==STOP_ASSERT) || (r==STOP_NOCD) || (r == STOP_DIVMOVF) || (r==STOP_DIVZERO)) {
-            //regKRA -= 1;	/* decrement RVK */
-            regRK = MOSU[regKRA-1];
-        }
+	if (smc_profile) smc_prof_fetch (pc, op);
+	if (heatmap_on) m20_heat_exec (pc);
+	if (hpc_sample && (--hpc_countdown <= 0)) {
+	    m20_hpc_begin ();
+	    r = cpu_exec_inst ();
+	    m20_hpc_end (pc, op);
+	}
+	else r = cpu_exec_inst ();
+	if (rev_enable && (r != STOP_MEM)) rev_after_inst (old_opcode);
+	if (call_profile && (r != STOP_MEM)) call_prof_inst (pc, op, TIME_TO_US(delay - old_delay));
+	if (loop_profile && (r != STOP_MEM)) loop_prof_inst (pc, op, ra, TIME_TO_US(delay - old_delay));
 
 
+	instr_time = delay - old_delay;
 	if (print_sys_stat) {
-          instr_time = delay - old_delay;
-          if (instr_time > 0) {
-            for( i=0; i<M20_SYM_OPCODE_TABLE_SIZE; i++ ) {
-              if (cmd_profile_table[i].op_code == op) {
-                  cmd_profile_table[i].us_count += 1;
-                  cmd_profile_table[i].us_time  += instr_time;
-                  break;
-              }
-            }
-          }
+          cpu_prof_count (op, instr_time);
           if (r) {
             print_commad_run_profile_stat();
           }
 	}
 
-        if (sim_deb && cpu_dev.dctrl) {
-	    if (disable_is2_trace) {
-	      if ((regKRA >= IS2_START_ADDRESS) && (regKRA <= IS2_END_ADDRESS)) goto trace_after_done;
-	    }
+        if (traced) {
 	           if (debug_dump_regs) {
 	             c1='-'; c2='-'; c3='-';
 	             if (t_ra != regRA) c1 = '*';
@@ -3225,24 +3803,277 @@ t_stat sim_instr (void)
                      }
 	           }
 	           if (debug_dump_regs || debug_dump_mem) fprintf (sim_deb, "\n");
-          trace_after_done: {};
 	}
 
 	//getchar(); 
 
-	ticks = 1;
-
-	if (delay > 0)				/* delay to next instr */
-	    //ticks += delay - DBL_EPSILON;
-	    ticks += (int)(delay - DBL_EPSILON);
-
-	delay -= ticks;				/* count down delay */
+	ticks = cpu_delay_ticks ();		/* delay to next instr */
+	n = 1;
 	sim_interval -= ticks;
+	cpu_tick_count += ticks;
 
+      inst_done:
         if (r) return r;			/* one instr; error? */
 
-	if (sim_step && (--sim_step <= 0))	/* do step count */
+	if (sim_step && ((sim_step -= n) <= 0))	/* do step count */
 	   return SCPE_STOP;
+
+	if (run_limit_on) {			/* RUN -I/-T/-W */
+	    if (run_instr_stop && (cpu_instr_count >= run_instr_stop))
+		return STOP_INSTRLIMIT;
+	    if (run_time_stop && (cpu_tick_count >= run_time_stop))
+		return STOP_TIMELIMIT;
+	    if (run_host_check && ((cpu_instr_count & 07777) == 0) &&
+		((int32) (sim_os_msec () - run_host_stop) >= 0))
+		return STOP_WATCHDOG;
+	}
+
+	if (idle_mode) {			/* idle loop fast-forward */
+	    if ((sim_deb && cpu_dev.dctrl) || sim_brk_summ || call_profile || loop_profile ||
+		smc_profile || heatmap_on)
+		idle_head = -1;
+	    else if ((idle_ff || idle_after_inst (pc, op, ticks, instr_time)) &&
+		     ((r = idle_skip ()) != SCPE_OK))
+		return r;
+	}
+
+	if (rt_on && (cpu_tick_count >= rt_next))	/* REALTIME pacing */
+	    rt_pace ();
+
+	if (stat_file_check && (cpu_instr_count >= stat_file_check))
+	    m20_stat_check ();			/* STATS FILE */
     }
 
 }
+
+
+
+/*
+ * Simulation start and stop (checkpoints for reverse execution)
+ */
+t_stat sim_instr (void)
+{
+    t_stat r;
+
+    rev_run_start ();
+    m20_stat_run_start ();
+    m20_trace_compile ();
+    m20_hpc_run_start ();
+    r = cpu_run ();
+    m20_trace_run_stop (r);
+    m20_stat_run_stop ();
+    rev_run_stop ();
+
+    return r;
+}
+
+
+
+/*
+ * Time value for RUN -T/-W:  number with suffix US, MS, S (default), M, H
+ */
+static t_stat cpu_parse_time (const char *cptr, double *usec)
+{
+    char   *tptr;
+    double  v;
+
+    v = strtod (cptr, &tptr);
+    if ((tptr == cptr) || (v < 0)) return SCPE_ARG;
+
+    if      (strcasecmp (tptr, "US") == 0) v *= 1.0;
+    else if (strcasecmp (tptr, "MS") == 0) v *= 1000.0;
+    else if ((*tptr == 0) || (strcasecmp (tptr, "S") == 0)) v *= 1000000.0;
+    else if (strcasecmp (tptr, "M") == 0)  v *= 60000000.0;
+    else if (strcasecmp (tptr, "H") == 0)  v *= 3600000000.0;
+    else return SCPE_ARG;
+
+    *usec = v;
+    return SCPE_OK;
+}
+
+
+
+/*
+ * RUN, GO, CONTINUE, BOOT with run limits:
+ *
+ *   RUN -I n      stop after n instructions (5e9 allowed)
+ *   RUN -T time   stop after emulated M-20 time
+ *   RUN -W time   stop after host wall-clock time (watchdog)
+ *
+ * Defaults are INSTR_LIMIT, TIME_LIMIT (usec) and WATCHDOG (sec)
+ * registers.  Other switches and arguments are passed to SCP.
+ * Summary line is printed after stop message (cpu_run_cmd_message).
+ */
+t_stat cpu_run_cmd (int32 flag, CONST char *cptr)
+{
+    char      gbuf[CBUFSIZE], sw[CBUFSIZE], *tptr;
+    double    instr, emul_time, watchdog, v;
+    double    emul_sec, host_sec;
+    t_uint64  start_count, start_ticks, start_skip, count, skip;
+    uint32    start_msec;
+    t_stat    r;
+
+    instr     = (double) run_instr_limit;
+    emul_time = (double) run_time_limit;
+    watchdog  = (double) run_watchdog * 1000000.0;
+
+    sw[0] = 0;
+    while (*cptr == '-') {
+        cptr = get_glyph (cptr, gbuf, 0);
+        if ((strcmp (gbuf, "-I") == 0) || (strcmp (gbuf, "-T") == 0) ||
+            (strcmp (gbuf, "-W") == 0)) {
+            if (*cptr == 0) return SCPE_2FARG;
+            cptr = get_glyph (cptr, gbuf + 2, 0);
+            if (gbuf[1] == 'I') {
+                v = strtod (gbuf + 2, &tptr);
+                if ((tptr == gbuf + 2) || (*tptr != 0) || (v < 0)) return SCPE_ARG;
+                instr = v;
+            }
+            else {
+                if (cpu_parse_time (gbuf + 2, &v) != SCPE_OK) return SCPE_ARG;
+                if (gbuf[1] == 'T') emul_time = v;
+                else watchdog = v;
+            }
+        }
+        else {
+            strlcat (sw, gbuf, sizeof (sw));
+            strlcat (sw, " ", sizeof (sw));
+        }
+    }
+    strlcat (sw, cptr, sizeof (sw));
+
+    start_count = cpu_instr_count;
+    start_ticks = cpu_tick_count;
+    start_skip  = idle_skip_count;
+    start_msec  = sim_os_msec ();
+
+    run_instr_stop = (instr > 0) ? start_count + (t_uint64) instr : 0;
+    run_time_stop  = (emul_time > 0) ? start_ticks + (t_uint64) emul_time : 0;
+    run_host_check = (watchdog > 0);
+    run_host_stop  = start_msec + (uint32) (watchdog / 1000.0);
+    run_limit_on   = run_instr_stop || run_time_stop || run_host_check;
+
+    r = run_cmd (flag, sw);
+
+    if (run_limit_on) {
+        skip     = idle_skip_count - start_skip;	/* not executed, not in MIPS */
+        count    = cpu_instr_count - start_count - skip;
+        emul_sec = (double) (cpu_tick_count - start_ticks) / 1000000.0;
+        host_sec = (sim_os_msec () - start_msec) / 1000.0;
+        if (skip > 0)
+            snprintf (run_summary, sizeof (run_summary),
+                      "Run summary: %.0f instructions (%.0f skipped by idle fast-forward), "
+                      "emulated time %.6f s, host time %.3f s, %.3f MIPS\n",
+                      (double) count, (double) skip, emul_sec, host_sec,
+                      (host_sec > 0) ? (double) count / host_sec / 1000000.0 : 0.0);
+        else
+            snprintf (run_summary, sizeof (run_summary),
+                      "Run summary: %.0f instructions, emulated time %.6f s, host time %.3f s, %.3f MIPS\n",
+                      (double) count, emul_sec, host_sec,
+                      (host_sec > 0) ? (double) count / host_sec / 1000000.0 : 0.0);
+        run_limit_on = 0;
+    }
+
+    return r;
+}
+
+
+void cpu_run_cmd_message (const char *unechoed_cmdline, t_stat r)
+{
+    run_cmd_message (unechoed_cmdline, r);
+
+    if (run_summary[0]) {
+        printf ("%s", run_summary);
+        if (sim_log && (sim_log != stdout)) fprintf (sim_log, "%s", run_summary);
+        run_summary[0] = 0;
+    }
+}
+
+
+
+/*
+ * SHOW CPU CFG:  static control-flow graph of MOSU from KRA (m20_cfg.c),
+ * SHOW CPU CFG=DOT writes it in Graphviz DOT format.
+ */
+t_stat cpu_show_cfg (FILE *st, UNIT *uptr, int32 val, CONST void *desc)
+{
+    struct m20_cfg *cfg;
+    int    entry = regKRA & MAX_ADDR_VALUE;
+
+    if (desc && strcmp ((const char *) desc, "DOT") != 0) return SCPE_ARG;
+    cfg = m20_cfg_build (MOSU, NULL, &entry, 1);
+    if (cfg == NULL) return SCPE_MEM;
+    if (desc) m20_cfg_dot (st, cfg);
+    else m20_cfg_print (st, cfg);
+    m20_cfg_free (cfg);
+    return SCPE_OK;
+}
+
+
+
+/*
+ * Test of MEMORY HEATMAP argument of SHOW and RESET
+ */
+static int cpu_memory_heatmap (CONST char *cptr)
+{
+    char  gbuf[CBUFSIZE];
+
+    cptr = get_glyph (cptr, gbuf, 0);
+    if (strcmp (gbuf, "MEMORY") != 0) return FALSE;
+    cptr = get_glyph (cptr, gbuf, 0);
+    return (*cptr == 0) && (strcmp (gbuf, "HEATMAP") == 0);
+}
+
+
+
+/*
+ * SHOW command:  SHOW THROTTLE adds M-20 real time pacing statistics,
+ * SHOW STATS prints run statistics, SHOW MEMORY HEATMAP prints data access
+ * heatmap, other SHOW commands are passed to SCP.
+ */
+t_stat cpu_show_cmd (int32 flag, CONST char *cptr)
+{
+    char  gbuf[CBUFSIZE];
+    t_stat r;
+
+    if (*get_glyph (cptr, gbuf, 0) == 0 && (strcmp (gbuf, "STATS") == 0)) {
+        m20_stat_show (stdout);
+        if (sim_log && (sim_log != stdout)) m20_stat_show (sim_log);
+        return SCPE_OK;
+    }
+    if (cpu_memory_heatmap (cptr)) {
+        m20_heat_show (stdout);
+        if (sim_log && (sim_log != stdout)) m20_heat_show (sim_log);
+        return SCPE_OK;
+    }
+    r = show_cmd (flag, cptr);
+    if ((r == SCPE_OK) && (strlen (gbuf) >= 2) && (MATCH_CMD (gbuf, "THROTTLE") == 0)) {
+        rt_show (stdout);
+        if (sim_log && (sim_log != stdout)) rt_show (sim_log);
+    }
+    return r;
+}
+
+
+
+/*
+ * RESET command:  RESET STATS clears run and real time pacing statistics,
+ * RESET MEMORY HEATMAP clears heatmap, other RESET commands are passed to SCP.
+ */
+t_stat cpu_reset_cmd (int32 flag, CONST char *cptr)
+{
+    char  gbuf[CBUFSIZE];
+
+    if (*get_glyph (cptr, gbuf, 0) == 0 && (strcmp (gbuf, "STATS") == 0)) {
+        m20_stat_reset ();
+        rt_points = rt_sleeps = rt_late = rt_resyncs = 0;
+        rt_sleep_sum = rt_jitter_sum = rt_jitter_sq = rt_jitter_max = 0;
+        rt_drift = 0;
+        return SCPE_OK;
+    }
+    if (cpu_memory_heatmap (cptr)) {
+        m20_heat_reset ();
+        return SCPE_OK;
+    }
+    return reset_cmd (flag, cptr);
+}
@@ -14,6 +14,14 @@
  *  12-Jan-2015  DVS  Minor update
  *  16-Jan-2015  DVS  Updated tape and drum definitions
  *  13-Mar-2015  DVS  Cleanup code
+ *  19-Oct-2026  DVS  Added binary object format definitions
+ *  19-Oct-2026  DVS  Added run limit stop codes
+ *  19-Oct-2026  DVS  Added i/o statistics device numbers
+ *  19-Oct-2026  DVS  Added sparse drum image format
+ *  19-Oct-2026  DVS  Added compressed tape container format
+ *  19-Oct-2026  DVS  Added emulated time units (TIME_UNITS_PER_US)
+ *  19-Oct-2026  DVS  Added i/o instruction test (OPCODE_IS_IO)
+ *  19-Oct-2026  DVS  Added heatmap file format
  *
  */
 
@@ -33,10 +41,38 @@
 
 
 
+/*
+ * Emulated time unit of instruction and i/o delays:  1/160000 usec.
+ * Every M-20 time (0.5 usec steps of instructions, 1/2500 and 1/6400 usec
+ * per code of tape and drum) is whole number of units, so delays are
+ * accumulated by integer adds without rounding.
+ */
+#define TIME_UNITS_PER_US       160000
+#define TIME_US(us)             ((t_int64)((us) * (t_int64)TIME_UNITS_PER_US))
+#define TIME_TO_US(t)           ((double)(t) / TIME_UNITS_PER_US)
+
+
 /* Memory and devices */
 
 #define MAX_MEM_SIZE      4096        /* max memory size per M-20 (12-bit address) */
 #define DRUM_SIZE	  4096	      /* magnetic drum size (040000) */
+
+/*
+ * Sparse drum image (ATTACH -S, dump_drm -s):
+ *   8 bytes magic, header words (version, drum size, block size, reserved),
+ *   bitmap of initialized words, table of block file offsets (0 = absent),
+ *   data blocks in order of first write.  All fields are 64-bit words.
+ */
+#define DRUM_SPARSE_MAGIC       "M20DRUMS"
+#define DRUM_SPARSE_VERSION     1
+#define DRUM_SPARSE_BLOCK       256                         /* words per block */
+#define DRUM_SPARSE_HDR_WORDS   8                           /* magic + 7 words */
+#define DRUM_SPARSE_MAP_WORDS   (DRUM_SIZE/64)
+#define DRUM_SPARSE_BLOCKS      (DRUM_SIZE/DRUM_SPARSE_BLOCK)
+#define DRUM_SPARSE_MAP_POS     (DRUM_SPARSE_HDR_WORDS*8)
+#define DRUM_SPARSE_TAB_POS     (DRUM_SPARSE_MAP_POS+DRUM_SPARSE_MAP_WORDS*8)
+#define DRUM_SPARSE_DATA_POS    (DRUM_SPARSE_TAB_POS+DRUM_SPARSE_BLOCKS*8)
+
 #define MAX_TAPE_SIZE     75000       /* magnetic tape size = N codes */
 
 #define MIN_TAPE_ZONE_SIZE         1
@@ -45,6 +81,24 @@
 #define MIN_TAPE_ZONE_NUM          0  /* 1 */
 #define MAX_TAPE_ZONE_NUM        255  /* 256 */
 
+/*
+ * Compressed tape container (ATTACH -C, dump_mt -c):
+ *   8 bytes magic, header words (version, tape words, directory entries,
+ *   directory offset, container length, reserved), run-length coded zones,
+ *   zone directory at end.  Runs are control word (kind<<32 | count) and
+ *   count words (literal) or one word (repeat).  Directory entry is zone
+ *   header word (MT_CONT_TAIL for data after last regular zone), tape word
+ *   position, word count, file offset of runs.  All fields are 64-bit words.
+ */
+#define MT_CONT_MAGIC           "M20TAPEZ"
+#define MT_CONT_VERSION         1
+#define MT_CONT_HDR_WORDS       8                           /* magic + 7 words */
+#define MT_CONT_DIR_WORDS       4                           /* words per directory entry */
+#define MT_CONT_LITERAL         1
+#define MT_CONT_REPEAT          2
+#define MT_CONT_MIN_REPEAT      3                           /* shortest repeat run */
+#define MT_CONT_TAIL            (~(t_value)0)
+
 #define TAPE_READ_MODE         1
 #define TAPE_WRITE_MODE        2
 #define TAPE_FORMAT_MODE       4
@@ -64,6 +118,35 @@
 #define DRUM_WRITE_MODE        2
 
 
+/*
+ * Binary object file (autocode_m20 -b, LOAD), all numbers are little-endian:
+ *   header (16 bytes):  magic "M20B", u16 version, u16 start address,
+ *                       u16 runs number, u16 reserved, u32 symbol map size
+ *   runs:               u16 address, u16 words number, words (u64 each)
+ *   symbol map:         text in format of map file (autocode_m20 -m)
+ */
+#define M20_OBJ_MAGIC          "M20B"
+#define M20_OBJ_VERSION        1
+#define M20_OBJ_HEADER_SIZE    16
+#define M20_OBJ_RUN_SIZE       4
+#define M20_OBJ_WORD_SIZE      8
+
+
+/*
+ * Heatmap file (HEATMAP FILE), all numbers are little-endian:
+ *   header (16 bytes):  magic "M20H", u16 version, u16 arrays number,
+ *                       u16 MOSU size, u16 drum size, u16 drums number,
+ *                       u16 reserved
+ *   arrays of counters (u64 each):  MOSU executions, MOSU reads, MOSU
+ *                       writes, then reads and writes of every drum
+ */
+#define M20_HEAT_MAGIC         "M20H"
+#define M20_HEAT_VERSION       1
+#define M20_HEAT_HEADER_SIZE   16
+#define M20_HEAT_WORD_SIZE     8
+#define M20_HEAT_ARRAYS        (3+2*MAX_PHYS_DRUM_COUNT)
+
+
 #define MAX_ADDR_VALUE      07777       /* length = 12 bits */
 #define MAX_OPCODE_VALUE      077       /* bits 42-37 = length 6 bits) */
 #define MAX_ADDR_TAG_VALUE     07       /* bits 45,44,43 = length 3 bits */
@@ -179,6 +262,15 @@
 #define EXT_UNIT	00003   /* 26..25 - drum or tape logical number */
 
 
+/* Devices of i/o statistics (SHOW STATS) */
+#define STAT_IO_DRUM      0
+#define STAT_IO_TAPE      1
+#define STAT_IO_CARD      2
+#define STAT_IO_PRINTER   3
+#define STAT_IO_PUNCH     4
+#define STAT_IO_NUM       5
+
+
 /* IS-2 addresses */
 #define  IS2_START_ADDRESS    07200
 #define  IS2_END_ADDRESS      07767
@@ -257,6 +349,9 @@
 #define     OPCODE_COND_JUMP_BY_SIG_W_0                       076
 #define     OPCODE_STOP_077                                   077
 
+/* 010, 030, 050, 070 = card and external device i/o, may schedule events */
+#define     OPCODE_IS_IO(op)              (((op) & 017) == 010)
+
 
 /* Simulator stop codes */
 
@@ -326,6 +421,9 @@ enum {
 	STOP_TAPE_NOT_IN_WRITE_MODE,		/* tape not in write mode */
 	STOP_TAPE_NOT_IN_READ_MODE,		/* tape not in read mode */
 	STOP_TAPE_MAP_ERROR,		        /* one more logical tapes mapped to one physical tape */
+	STOP_INSTRLIMIT,			/* instruction limit reached (RUN -I) */
+	STOP_TIMELIMIT,				/* emulated time limit reached (RUN -T) */
+	STOP_WATCHDOG,				/* host time limit reached (RUN -W) */
 };
 
 
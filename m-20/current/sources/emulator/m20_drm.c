@@ -11,6 +11,11 @@
  * There is no interrupt system in M20.
  * A real drum timing is implemented.
  *
+ * Drum image is a flat file of words, or a sparse image with bitmap of
+ * initialized words (see m20_defs.h).  Sparse image is created by
+ * ATTACH -S on a new (empty) file and recognized by magic on attach.
+ * Reading of word which was never written stops with STOP_DRUMINVDATA.
+ *
  * Revision History.
  *
  *  10-Nov-2014  DVS  Initial Implemementation
@@ -28,6 +33,9 @@
  *  06-Mar-2015  DVS  Added drum read/write data dump debugging option
  *  08-Mar-2015  DVS  Added more checksum control logic
  *  13-Mar-2015  DVS  Cleanup code
+ *  19-Oct-2026  DVS  Added in-memory attachments (mem:name)
+ *  19-Oct-2026  DVS  Added sparse drum image format
+ *  19-Oct-2026  DVS  Added drum words to data access heatmap (HEATMAP)
  *
  */
 
@@ -42,6 +50,8 @@ t_stat drum_svc (UNIT *uptr);
 t_stat drum_reset (DEVICE *dptr);
 t_stat drum_attach (UNIT *uptr, char *cptr);
 t_stat drum_detach (UNIT *uptr);
+t_stat drum_show_format (FILE *st, UNIT *uptr, int32 val, CONST void *desc);
+static t_stat drum_sparse_open (UNIT *uptr, int create);
 
 static int drum_map_check = 1;
 static int drum_auto_skip_zero_address = 1;
@@ -86,6 +96,7 @@ REG drum_reg[] = {
 };
 
 MTAB drum_mod[] = {
+	{ MTAB_XTD|MTAB_VUN|MTAB_NMO, 0, "FORMAT", NULL, NULL, &drum_show_format, NULL, "drum image format" },
 	{ 0 }
 };
 
@@ -105,6 +116,10 @@ extern void mosu_store (int addr, t_value val);
 extern t_value mosu_load (int addr);
 
 extern t_value  cyclic_checksum( t_value x, t_value y);
+extern t_stat m20_attach_unit (UNIT *uptr, CONST char *cptr);
+extern t_stat m20_detach_unit (UNIT *uptr);
+extern int  heatmap_on;
+extern void m20_heat_drum (int drum_no, int addr, int nwords, int write);
 
 
 /*
@@ -123,6 +138,19 @@ extern int ext_io_ram_chksum;           /* MOSU_CHK - memory address for checksu
 static  t_value  temp_drum_buf[DRUM_SIZE+1];
 
 
+/* sparse drum images */
+typedef  struct drum_sparse {
+    int      on;
+    t_value  map[DRUM_SPARSE_MAP_WORDS];	/* initialized words */
+    t_value  tab[DRUM_SPARSE_BLOCKS];		/* block file offsets */
+} DRUM_SPARSE;
+
+static  DRUM_SPARSE  drum_sparse[MAX_PHYS_DRUM_COUNT];
+static  t_value      drum_zero_block[DRUM_SPARSE_BLOCK];
+
+#define  DRUM_WORD_INIT(ds,a)   (((ds)->map[(a) >> 6] >> ((a) & 077)) & 1)
+
+
 
 /* storage for print and punch */
 
@@ -187,7 +215,12 @@ t_stat drum_attach (UNIT *uptr, char *cptr)
 
     sim_cancel(uptr);				           /* cancel current IO */
    
-    s = attach_unit (uptr, cptr);
+    s = m20_attach_unit (uptr, cptr);
+
+    if (s == SCPE_OK) {
+        s = drum_sparse_open (uptr, (sim_switches & SWMASK ('S')) != 0);
+        if (s != SCPE_OK) m20_detach_unit (uptr);
+    }
 
     if (sim_deb && drum_dev.dctrl) fprintf (sim_deb, "drm: drum_attach(..), name='%s' res=%d\n", cptr, s);
 
@@ -205,12 +238,172 @@ t_stat drum_detach (UNIT *uptr)
     if (sim_deb && drum_dev.dctrl) fprintf (sim_deb, "drm: drum_detach(..)\n");
 
     sim_cancel(uptr);
+    drum_sparse[uptr - drum_unit].on = 0;
+
+    return m20_detach_unit (uptr);
+}
+
+
+
+/*
+ *  Show drum image format
+ */
+t_stat drum_show_format (FILE *st, UNIT *uptr, int32 val, CONST void *desc)
+{
+    DRUM_SPARSE * ds = &drum_sparse[uptr - drum_unit];
+    int  a, nwords, nblocks;
+
+    if (!(uptr->flags & UNIT_ATT)) {
+        fprintf (st, "not attached\n");
+        return SCPE_OK;
+    }
+    if (!ds->on) {
+        fprintf (st, "flat image\n");
+        return SCPE_OK;
+    }
+    nwords = nblocks = 0;
+    for (a = 0; a < DRUM_SIZE; a++) nwords += (int) DRUM_WORD_INIT (ds, a);
+    for (a = 0; a < DRUM_SPARSE_BLOCKS; a++) nblocks += (ds->tab[a] != 0);
+    fprintf (st, "sparse image, %d words initialized, %d of %d blocks\n", nwords, nblocks, DRUM_SPARSE_BLOCKS);
+    return SCPE_OK;
+}
+
+
+
+
+/*
+ *  Sparse drum image:  recognize on attach or create on new file (-S)
+ */
+static t_stat drum_sparse_open (UNIT *uptr, int create)
+{
+    DRUM_SPARSE * ds = &drum_sparse[uptr - drum_unit];
+    FILE * f = uptr->fileref;
+    char   magic[8];
+    t_value hdr[DRUM_SPARSE_HDR_WORDS-1];
+    size_t n;
+
+    memset (ds, 0, sizeof(*ds));
+
+    if (fseek (f, 0, SEEK_SET)) return SCPE_IOERR;
+    n = fread (magic, 1, sizeof(magic), f);
+    if ((n == sizeof(magic)) && (memcmp (magic, DRUM_SPARSE_MAGIC, sizeof(magic)) == 0)) {
+        if ((fxread (hdr, sizeof(t_value), DRUM_SPARSE_HDR_WORDS-1, f) != DRUM_SPARSE_HDR_WORDS-1) ||
+            (hdr[0] != DRUM_SPARSE_VERSION) || (hdr[1] != DRUM_SIZE) || (hdr[2] != DRUM_SPARSE_BLOCK) ||
+            (fxread (ds->map, sizeof(t_value), DRUM_SPARSE_MAP_WORDS, f) != DRUM_SPARSE_MAP_WORDS) ||
+            (fxread (ds->tab, sizeof(t_value), DRUM_SPARSE_BLOCKS, f) != DRUM_SPARSE_BLOCKS))
+            return SCPE_FMT;
+        ds->on = 1;
+        return SCPE_OK;
+    }
+    if (!create) return SCPE_OK;			/* flat image */
 
-    return detach_unit (uptr);
+    if (n != 0) {
+        sim_printf ("Drum image is not empty, convert it by dump_drm -s\n");
+        return SCPE_ARG;
+    }
+    if (uptr->flags & UNIT_RO) return SCPE_RO;
+    memset (hdr, 0, sizeof(hdr));
+    hdr[0] = DRUM_SPARSE_VERSION;
+    hdr[1] = DRUM_SIZE;
+    hdr[2] = DRUM_SPARSE_BLOCK;
+    if (fseek (f, 0, SEEK_SET)) return SCPE_IOERR;
+    fwrite (DRUM_SPARSE_MAGIC, 1, sizeof(magic), f);
+    fxwrite (hdr, sizeof(t_value), DRUM_SPARSE_HDR_WORDS-1, f);
+    fxwrite (ds->map, sizeof(t_value), DRUM_SPARSE_MAP_WORDS, f);
+    fxwrite (ds->tab, sizeof(t_value), DRUM_SPARSE_BLOCKS, f);
+    fflush (f);
+    if (ferror (f)) return SCPE_IOERR;
+    ds->on = 1;
+    return SCPE_OK;
 }
 
 
 
+/*
+ *  Read words from drum image.  Count of words is stopped on end of
+ *  flat file or on first uninitialized word of sparse image.
+ */
+static t_stat drum_get_words (int drum_no, int addr, t_value *buf, int nwords, size_t *count)
+{
+    DRUM_SPARSE * ds = &drum_sparse[drum_no];
+    FILE * f = drum_unit[drum_no].fileref;
+    int    a, n;
+    size_t got;
+
+    *count = 0;
+    if (!ds->on) {
+        if (sim_deb && drum_dev.dctrl) fprintf (sim_deb, "drm: seek file_pos=%llu\n", addr*sizeof(t_value));
+        if (fseek (f, addr*sizeof(t_value), SEEK_SET)) return SCPE_IOERR;
+        *count = fxread (buf, sizeof(t_value), nwords, f);
+        return SCPE_OK;
+    }
+
+    while ((int) *count < nwords) {
+        a = addr + (int) *count;			/* run of initialized words in block */
+        for (n = 0; ((int) *count + n < nwords) && (a + n < DRUM_SIZE) &&
+                    ((a + n) / DRUM_SPARSE_BLOCK == a / DRUM_SPARSE_BLOCK) &&
+                    DRUM_WORD_INIT (ds, a + n); n++) ;
+        if (n == 0) break;
+        if (fseek (f, (long) ds->tab[a / DRUM_SPARSE_BLOCK] + (a % DRUM_SPARSE_BLOCK) * sizeof(t_value), SEEK_SET))
+            return SCPE_IOERR;
+        got = fxread (buf + *count, sizeof(t_value), n, f);
+        *count += got;
+        if (got != (size_t) n) break;
+    }
+    return SCPE_OK;
+}
+
+
+
+/*
+ *  Write words into drum image (blocks of sparse image are allocated
+ *  at end of file on first write)
+ */
+static t_stat drum_put_words (int drum_no, int addr, t_value *buf, int nwords, size_t *count)
+{
+    DRUM_SPARSE * ds = &drum_sparse[drum_no];
+    FILE * f = drum_unit[drum_no].fileref;
+    int    a, b, n, i, m;
+    size_t put;
+    t_offset pos;
+
+    *count = 0;
+    if (!ds->on) {
+        if (sim_deb && drum_dev.dctrl) fprintf (sim_deb, "drm: seek file_pos=%llu\n", addr*sizeof(t_value));
+        if (fseek (f, addr*sizeof(t_value), SEEK_SET)) return SCPE_IOERR;
+        *count = fxwrite (buf, sizeof(t_value), nwords, f);
+        return SCPE_OK;
+    }
+
+    while ((int) *count < nwords) {
+        a = addr + (int) *count;
+        b = a / DRUM_SPARSE_BLOCK;
+        n = DRUM_SPARSE_BLOCK - a % DRUM_SPARSE_BLOCK;
+        if (n > nwords - (int) *count) n = nwords - (int) *count;
+        if (ds->tab[b] == 0) {				/* allocate block */
+            if (fseek (f, 0, SEEK_END)) return SCPE_IOERR;
+            pos = sim_ftell (f);
+            if (fxwrite (drum_zero_block, sizeof(t_value), DRUM_SPARSE_BLOCK, f) != DRUM_SPARSE_BLOCK)
+                return SCPE_IOERR;
+            ds->tab[b] = (t_value) pos;
+            if (fseek (f, DRUM_SPARSE_TAB_POS + b*sizeof(t_value), SEEK_SET)) return SCPE_IOERR;
+            if (fxwrite (&ds->tab[b], sizeof(t_value), 1, f) != 1) return SCPE_IOERR;
+        }
+        if (fseek (f, (long) ds->tab[b] + (a % DRUM_SPARSE_BLOCK) * sizeof(t_value), SEEK_SET))
+            return SCPE_IOERR;
+        put = fxwrite (buf + *count, sizeof(t_value), n, f);
+        for (i = 0; i < (int) put; i++) ds->map[(a + i) >> 6] |= (t_value) 1 << ((a + i) & 077);
+        *count += put;
+        if (put != (size_t) n) break;
+
+        m = (a + n - 1) / 64 - a / 64 + 1;		/* update bitmap words */
+        if (fseek (f, DRUM_SPARSE_MAP_POS + (a / 64)*sizeof(t_value), SEEK_SET)) return SCPE_IOERR;
+        if (fxwrite (&ds->map[a / 64], sizeof(t_value), m, f) != (size_t) m) return SCPE_IOERR;
+    }
+    return SCPE_OK;
+}
+
+
 
 /*
  * Drum writing.
@@ -254,13 +447,11 @@ t_stat drum_write (int drum_no, int addr, int first, int last, t_value *sum,int
       }
     }
 
-    if (sim_deb && drum_dev.dctrl) fprintf (sim_deb, "drm: seek file_pos=%llu\n", addr*sizeof(t_value));
-    res = fseek (drum_unit[drum_no].fileref, addr*sizeof(t_value), SEEK_SET);
-    if (res) return SCPE_IOERR;
-
     if (sim_deb && drum_dev.dctrl) fprintf (sim_deb, "drm: nwords=%04o\n", nwords);
 
-    count = fxwrite (&temp_drum_buf[first], sizeof(t_value), nwords, drum_unit[drum_no].fileref);
+    res = drum_put_words (drum_no, addr, &temp_drum_buf[first], nwords, &count);
+    if (res) return res;
+    if (heatmap_on) m20_heat_drum (drum_no, addr, (int)count, 1);
     if (sim_deb && drum_dev.dctrl) fprintf (sim_deb, "drm: write_count=%04o\n", count);
     if (ocodes && (count <= nwords)) *ocodes = (int)count;
     if (ferror (drum_unit[drum_no].fileref)) return SCPE_IOERR;
@@ -278,7 +469,9 @@ t_stat drum_write (int drum_no, int addr, int first, int last, t_value *sum,int
           if (drum_write_data_dump) fprintf (sim_deb, "drm: write_value=%015llo\n", chksum);
         }
         if (!disable_control) {
-          count = fxwrite (&chksum, sizeof(t_value), 1, drum_unit[drum_no].fileref);
+          res = drum_put_words (drum_no, addr+nwords, &chksum, 1, &count);
+          if (res) return res;
+          if (heatmap_on) m20_heat_drum (drum_no, addr+nwords, (int)count, 1);
           if (sim_deb && drum_dev.dctrl) fprintf (sim_deb, "drm: write_count=%04o\n", count);
           if (ferror (drum_unit[drum_no].fileref)) return SCPE_IOERR;
           if (count != 1) return SCPE_IOERR;
@@ -322,11 +515,9 @@ t_stat drum_read (int drum_no, int addr, int first, int last, t_value *sum,int *
     if (sim_deb && drum_dev.dctrl) 
         fprintf (sim_deb, "drm: reading MD %05o mem_region %04o-%04o\n", addr, first, last);
 
-    if (sim_deb && drum_dev.dctrl) fprintf (sim_deb, "drm: seek file_pos=%llu\n", addr*sizeof(t_value));
-    res = fseek (drum_unit[drum_no].fileref, addr*8, SEEK_SET);
-    if (res) return SCPE_IOERR;
-
-    count = (int)fxread (&temp_drum_buf[first], sizeof(t_value), nwords, drum_unit[drum_no].fileref);
+    res = drum_get_words (drum_no, addr, &temp_drum_buf[first], nwords, &count);
+    if (res) return res;
+    if (heatmap_on) m20_heat_drum (drum_no, addr, (int)count, 0);
     if (sim_deb && drum_dev.dctrl) fprintf (sim_deb, "drm: read_count=%04o\n", count);
     if (ocodes && (count <= nwords)) *ocodes = (int)count;
     if (ferror (drum_unit[drum_no].fileref)) return SCPE_IOERR;
@@ -353,7 +544,9 @@ t_stat drum_read (int drum_no, int addr, int first, int last, t_value *sum,int *
     if (sum) {
 	/* Read and test checksum  */
 	old_sum = 0;
-	count = fxread (&old_sum, sizeof(t_value), 1, drum_unit[drum_no].fileref);
+	res = drum_get_words (drum_no, addr+nwords, &old_sum, 1, &count);
+	if (res) return res;
+	if (heatmap_on) m20_heat_drum (drum_no, addr+nwords, (int)count, 0);
         if (sim_deb && drum_dev.dctrl) fprintf (sim_deb, "drm: read_count=%04o\n", count);
         if (!disable_control) {
           if (ferror (drum_unit[drum_no].fileref)) return SCPE_IOERR;
@@ -14,6 +14,7 @@
  *  17-Nov-2014  DVS  Updated
  *  05-Dec-2014  DVS  Updated
  *  29-Jun-2021  DVS  Changed sim_stop_messages definitions
+ *  19-Oct-2026  DVS  Added run limit stop messages
  *
  */
 
@@ -89,6 +90,9 @@ const char *sim_stop_messages[SCPE_BASE] = {
 	"tape not in write mode",
 	"tape not in read mode",
 	"one more logical tapes mapped to one physical tape",
+	"Instruction limit reached",
+	"Emulated time limit reached",
+	"Host time limit reached (watchdog)",
     };
 
 
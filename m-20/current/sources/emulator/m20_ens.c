@@ -0,0 +1,760 @@
+/*
+ * File:     m20_ens.c
+ * Purpose:  M-20 simulator ensemble runs (parameter sweeps over key registers)
+ *
+ * Copyright (c) 2026, Dmitry Stefankov
+ *
+ * $Id$
+ *
+ * Ensemble runs the program from the current state (KRA, registers,
+ * MOSU) in up to ENS_MAX_LANES lanes, every lane with its own values of
+ * panel key registers RPU1..RPU4.  Lanes are kept as arrays by lane
+ * (struct of arrays): registers KRA, RA, RR, P1, signal w and own copy
+ * of MOSU.  Lanes with the same KRA form a group, which runs in lockstep:
+ * the instruction is fetched and decoded once for the group, and then
+ * executed for every lane with its own registers and data (arithmetic
+ * routines of CPU module).  Key registers are read by lane, so they don't
+ * split lanes.  When KRA of lanes diverges after a jump, the group is
+ * split by KRA and every new group continues alone; lanes which
+ * always jump together are never split.  A group is split too, if the
+ * instruction word at KRA differs between lanes (self-modifying code).
+ *
+ * Lanes stop on any stop of the CPU (STOP, errors, memory breakpoints),
+ * on the instruction limit and before card and external device i/o
+ * instructions, because devices are not duplicated per lane.  The CPU
+ * state, MOSU, the emulated time and the devices are not changed by
+ * the ensemble.
+ *
+ * Commands:
+ *   ENSEMBLE [-I n] [-D addr[-addr]] lane ...
+ *
+ *   lane = rpu1[/rpu2[/rpu3[/rpu4]]]  octal values of RPU1..RPU4,
+ *          omitted ones are current register values
+ *   -I n   instruction limit per lane (default INSTR_LIMIT or 100000000)
+ *   -D     print memory words of every lane after the run
+ *
+ * Revision History.
+ *
+ *  19-Oct-2026  DVS  Initial Implementation
+ *  19-Oct-2026  DVS  Lockstep execution of lanes by groups with the same
+ *                    KRA, split of groups only on diverging KRA
+ *
+ */
+
+#include "m20_defs.h"
+
+
+/* CPU module references */
+
+extern uint16   regKRA;
+extern uint16   regRA;
+extern int      trgSW;
+extern t_value  regRR;
+extern t_value  regP1;
+extern int      old_opcode;
+extern int      mosu_mode;
+extern int      memory_45_checking;
+extern int      use_add_sbst;
+extern int      new_add;
+extern int      new_mult;
+extern int      new_div;
+extern int      new_sqrt;
+extern int      enable_opcode_040_hack;
+
+extern t_value  RPU1, RPU2, RPU3, RPU4;
+
+extern t_value  MOSU[MAX_MEM_SIZE];
+extern t_uint64 run_instr_limit;
+
+extern const t_int64 cpu_op_time[MAX_OPCODE_VALUE+1];
+
+extern t_stat addition (t_value *result, t_value x, t_value y, int no_round, int no_norm);
+extern t_stat new_addition_v44 (t_value *result, t_value x, t_value y, int no_round, int no_norm);
+extern t_stat new_arithmetic_op (t_value *result, t_value x, t_value y, int op_code);
+extern t_stat add_exponent (t_value *result, t_value x, int n, int opcode);
+extern t_stat multiplication (t_value *result, t_value x, t_value y, int no_round, int no_norm);
+extern t_stat new_arithmetic_mult_op (t_value *result, t_value x, t_value y, int op_code);
+extern t_stat division (t_value *result, t_value x, t_value y, int no_round);
+extern t_stat new_arithmetic_div_op (t_value *result, t_value x, t_value y, int op_code);
+extern t_stat square_root (t_value *result, t_value x, int no_round);
+extern t_stat new_arithmetic_square_root (t_value *result, t_value x, int op_code);
+
+
+#define  ENS_MAX_LANES      16
+#define  ENS_RPU_NUM        4
+#define  ENS_DEF_LIMIT      100000000	/* instructions per lane */
+#define  ENS_STOP_IO        (-1)		/* lane stopped before i/o */
+#define  ENS_RUNNING        (-2)		/* lane not stopped yet */
+
+
+/* Instruction decoded once for group */
+typedef  struct ens_inst {
+    int        op;
+    int        tags;
+    int        a1, a2, a3;		/* addresses without RA */
+} ENS_INST, * PENS_INST;
+
+
+/* Lanes (struct of arrays) */
+static int       ens_lanes;
+static t_value   ens_rpu[ENS_RPU_NUM][ENS_MAX_LANES];
+static uint16    ens_kra[ENS_MAX_LANES];
+static uint16    ens_ra[ENS_MAX_LANES];
+static int       ens_sw[ENS_MAX_LANES];
+static t_value   ens_rr[ENS_MAX_LANES];
+static t_value   ens_p1[ENS_MAX_LANES];
+static int       ens_old_op[ENS_MAX_LANES];
+static t_stat    ens_stop[ENS_MAX_LANES];
+static t_uint64  ens_count[ENS_MAX_LANES];
+static t_int64   ens_time[ENS_MAX_LANES];
+static t_value   ens_mem[ENS_MAX_LANES][MAX_MEM_SIZE];
+
+/* Groups (masks of lanes) waiting for execution */
+static uint32    ens_wait[ENS_MAX_LANES];
+static int       ens_wait_num;
+static int       ens_groups;		/* groups created */
+static t_uint64  ens_executed;		/* instructions fetched by groups */
+
+
+
+/*
+ *  Memory of lane (as mosu_peek and mosu_store of CPU)
+ */
+static t_value ens_peek (int l, int addr)
+{
+    addr &= MAX_ADDR_VALUE;
+    if ((mosu_mode == MOSU_MODE_II) && (addr >= MOSU_MODE_II_SPEC_BASE_ADDR)) {
+        switch (addr - MOSU_MODE_II_SPEC_BASE_ADDR) {
+          case 1: case 2: case 3: case 4:
+            return ens_rpu[addr - MOSU_MODE_II_SPEC_BASE_ADDR - 1][l];
+          case 5:
+            return ens_rr[l];
+          default:
+            return 0;
+        }
+    }
+    return ens_mem[l][addr];
+}
+
+static void ens_store (int l, int addr, t_value val)
+{
+    addr &= MAX_ADDR_VALUE;
+    if (addr == 0) return;
+    if ((mosu_mode == MOSU_MODE_II) && (addr >= MOSU_MODE_II_SPEC_BASE_ADDR))
+        val = ens_peek (l, addr);
+    ens_mem[l][addr] = val;
+}
+
+static int ens_garbage (int l, int a1, int a2, int a3)
+{
+    return ((ens_peek (l, a1) | ens_peek (l, a2) | ens_peek (l, a3)) & ~WORD45) != 0;
+}
+
+
+
+/*
+ *  Execute decoded instruction in one lane (as cpu_one_inst),
+ *  KRA of lane is already incremented
+ */
+static t_stat ens_exec_lane (int l, PENS_INST in)
+{
+    int      op = in->op, a1 = in->a1, a2 = in->a2, a3 = in->a3, n = 0;
+    int      no_norm;
+    t_value  x, y, t, xm, ym, xe, ye;
+    t_value *rr = &ens_rr[l];
+    t_int64 *time = &ens_time[l];
+    t_stat   err = SCPE_OK;
+
+    if (in->tags & 4) a1 = (a1 + ens_ra[l]) & MAX_ADDR_VALUE;
+    if (in->tags & 2) a2 = (a2 + ens_ra[l]) & MAX_ADDR_VALUE;
+    if (in->tags & 1) a3 = (a3 + ens_ra[l]) & MAX_ADDR_VALUE;
+
+    if (memory_45_checking && ens_garbage (l, a1, a2, a3))
+        return STOP_MEMORY_GARBAGE_DETECTED;
+    if (sim_brk_summ && (sim_brk_test (a1, SWMASK ('R')) ||
+        sim_brk_test (a2, SWMASK ('R')) || sim_brk_test (a3, SWMASK ('W'))))
+        return STOP_MEM;
+
+    switch (op) {
+      default:
+        *time += cpu_op_time[op];
+        err = STOP_BADCMD;
+        goto done;
+
+      case OPCODE_ADD_ROUND_NORM:
+      case OPCODE_ADD_NORM:
+      case OPCODE_ADD_ROUND:
+      case OPCODE_ADD:
+      case OPCODE_SUB_ROUND_NORM:
+      case OPCODE_SUB_NORM:
+      case OPCODE_SUB_ROUND:
+      case OPCODE_SUB:
+        x = ens_peek (l, a1);
+        y = ens_peek (l, a2);
+        if (use_add_sbst) err = new_arithmetic_op (rr, x, y, op);
+        else {
+            if ((op & 017) == 002) y ^= SIGN;
+            if (new_add) err = new_addition_v44 (rr, x, y, op >> 4 & 1, op >> 5 & 1);
+            else err = addition (rr, x, y, op >> 4 & 1, op >> 5 & 1);
+        }
+        goto add_done;
+
+      case OPCODE_SUB_MOD_ROUND_NORM:
+      case OPCODE_SUB_MOD_NORM:
+      case OPCODE_SUB_MOD_ROUND:
+      case OPCODE_SUB_MOD:
+        x = ens_peek (l, a1);
+        y = ens_peek (l, a2);
+        if (use_add_sbst) err = new_arithmetic_op (rr, x, y, op);
+        else {
+            no_norm = !((op == OPCODE_SUB_MOD_ROUND_NORM) || (op == OPCODE_SUB_MOD_NORM));
+            if (new_add) err = new_addition_v44 (rr, x & ~SIGN, y | SIGN, 1, no_norm);
+            else err = addition (rr, x & ~SIGN, y | SIGN, 1, no_norm);
+        }
+      add_done:
+        if (err) goto done;
+        ens_store (l, a3, *rr);
+        ens_sw[l] = (*rr & SIGN) != 0;
+        *time += cpu_op_time[op];
+        break;
+
+      case OPCODE_MULT_ROUND_NORM:
+      case OPCODE_MULT_NORM:
+      case OPCODE_MULT_ROUND:
+      case OPCODE_MULT:
+        x = ens_peek (l, a1);
+        y = ens_peek (l, a2);
+        regP1 = ens_p1[l];			/* lower part of product */
+        if (new_mult) err = new_arithmetic_mult_op (rr, x, y, op);
+        else err = multiplication (rr, x, y, op >> 4 & 1, op >> 5 & 1);
+        ens_p1[l] = regP1;
+        goto ovf_done;
+
+      case OPCODE_DIV_ROUND_NORM:
+      case OPCODE_DIV_NORM:
+        x = ens_peek (l, a1);
+        y = ens_peek (l, a2);
+        if (new_div) err = new_arithmetic_div_op (rr, x, y, op);
+        else err = division (rr, x, y, op >> 4 & 1);
+        goto ovf_done;
+
+      case OPCODE_SQRT_ROUND_NORM:
+      case OPCODE_SQRT_NORM:
+        x = ens_peek (l, a1);
+        if (new_sqrt) err = new_arithmetic_square_root (rr, x, op);
+        else err = square_root (rr, x, op >> 4 & 1);
+      ovf_done:
+        if (err) goto done;
+        ens_store (l, a3, *rr);
+        ens_sw[l] = (int) (*rr >> BITS_36 & EXPONENT_VALUE_MASK) > EXP_OVF_VALUE;
+        *time += cpu_op_time[op];
+        break;
+
+      case OPCODE_OUT_LOWER_BITS_OF_MULT:
+        switch (ens_old_op[l]) {
+          case OPCODE_MULT_ROUND_NORM:
+          case OPCODE_MULT_NORM:
+          case OPCODE_MULT_ROUND:
+          case OPCODE_MULT:
+            *rr = ens_p1[l];
+            ens_sw[l] = (int) (*rr >> BITS_36 & EXPONENT_VALUE_MASK) > EXP_OVF_VALUE;
+            break;
+          default:
+            *rr = (*rr & EXP_SIGN_TAG) | (ens_p1[l] & MANTISSA);
+            ens_sw[l] = (*rr & MANTISSA) == 0;
+            break;
+        }
+        ens_store (l, a3, *rr);
+        *time += cpu_op_time[op];
+        break;
+
+      case OPCODE_ADD_ADDR_TO_EXP:
+        n = (a1 & EXPONENT_VALUE_MASK) - M20_MANTISSA_SHIFT;
+        goto add_exp;
+      case OPCODE_ADD_EXP_TO_EXP:
+        n = (int) (ens_peek (l, a1) >> BITS_36 & EXPONENT_VALUE_MASK) - M20_MANTISSA_SHIFT;
+        goto add_exp;
+      case OPCODE_SUB_ADDR_FROM_EXP:
+        n = M20_MANTISSA_SHIFT - (a1 & EXPONENT_VALUE_MASK);
+        goto add_exp;
+      case OPCODE_SUB_EXP_FROM_EXP:
+        n = M20_MANTISSA_SHIFT - (int) (ens_peek (l, a1) >> BITS_36 & EXPONENT_VALUE_MASK);
+      add_exp:
+        *time += cpu_op_time[op];
+        err = add_exponent (rr, ens_peek (l, a2), n, op);
+        if (err) goto done;
+        ens_store (l, a3, *rr);
+        ens_sw[l] = (int) (*rr >> BITS_36 & EXPONENT_VALUE_MASK) > EXP_OVF_VALUE;
+        break;
+
+      case OPCODE_TRANSFER_MEM2MEM:
+        *rr = ens_peek (l, a1);
+        ens_store (l, a3, *rr);
+        *time += cpu_op_time[op];
+        break;
+
+      case OPCODE_LOAD_FROM_KEY_REGISTER:
+        switch (a1 & 7) {
+          case 0:  *rr = 0; break;
+          case 1: case 2: case 3: case 4:
+                   *rr = ens_rpu[(a1 & 7) - 1][l]; break;
+          case 5:  break;
+          default: err = STOP_INVARG; goto done;
+        }
+        ens_store (l, a3, *rr);
+        *time += cpu_op_time[op];
+        break;
+
+      case OPCODE_BLANKING_040:
+        if (enable_opcode_040_hack) {
+            *time += cpu_op_time[op];
+            n = (ens_peek (l, a1) >> BITS_12) & MAX_ADDR_VALUE;
+            if (ens_ra[l] < n) ens_kra[l] = a2;
+            ens_ra[l] = a3;
+            break;
+        }
+        /* fall through */
+      case OPCODE_BLANKING_060:
+        *rr = 0;
+        ens_store (l, a3, *rr);
+        *time += cpu_op_time[op];
+        break;
+
+      case OPCODE_COMPARE:
+      case OPCODE_COMPARE_WITH_STOP:
+      case OPCODE_LOGICAL_MULT:
+      case OPCODE_LOGICAL_ADD:
+        x = ens_peek (l, a1);
+        y = ens_peek (l, a2);
+        if (op == OPCODE_LOGICAL_MULT) *rr = x & y;
+        else if (op == OPCODE_LOGICAL_ADD) *rr = x | y;
+        else *rr = x ^ y;
+        ens_sw[l] = (*rr == 0);
+        *time += cpu_op_time[op];
+        if ((op == OPCODE_COMPARE_WITH_STOP) && !ens_sw[l]) {
+            err = STOP_ASSERT;
+            goto done;
+        }
+        ens_store (l, a3, *rr);
+        break;
+
+      case OPCODE_ADD_CMDS:
+      case OPCODE_SUB_CMDS:
+        x = ens_peek (l, a1);
+        y = ens_peek (l, a2);
+        if (op == OPCODE_ADD_CMDS) y = (x & MANTISSA) + (y & MANTISSA);
+        else y = (x & MANTISSA) - (y & MANTISSA);
+        *rr = (x & ~MANTISSA & WORD45) | (y & MANTISSA);
+        ens_store (l, a3, *rr);
+        ens_sw[l] = (y & BIT37) != 0;
+        *time += cpu_op_time[op];
+        break;
+
+      case OPCODE_ADD_OPCS:
+      case OPCODE_SUB_OPCS:
+        x = ens_peek (l, a1);
+        y = ens_peek (l, a2);
+        if (op == OPCODE_ADD_OPCS) y = (x & ~MANTISSA) + (y & ~MANTISSA);
+        else y = (x & ~MANTISSA) - (y & ~MANTISSA);
+        *rr = (x & MANTISSA) | (y & ~MANTISSA & WORD45);
+        ens_store (l, a3, *rr);
+        ens_sw[l] = (y & BIT46) != 0;
+        *time += cpu_op_time[op];
+        break;
+
+      case OPCODE_SHIFT_MANTISSA_BY_ADDR:
+      case OPCODE_SHIFT_MANTISSA_BY_EXP:
+        if (op == OPCODE_SHIFT_MANTISSA_BY_ADDR) n = (a1 & EXPONENT_VALUE_MASK) - M20_MANTISSA_SHIFT;
+        else n = (int) (ens_peek (l, a1) >> BITS_36 & EXPONENT_VALUE_MASK) - M20_MANTISSA_SHIFT;
+        *time += cpu_op_time[op] + TIME_US(1.5) * (n>0 ? n : -n);
+        y = ens_peek (l, a2);
+        *rr = (y & ~MANTISSA);
+        if (n >= 0) *rr |= (((y & MANTISSA) << n) & MANTISSA);
+        else *rr |= (((y & MANTISSA) >> -n) & MANTISSA);
+        ens_store (l, a3, *rr);
+        ens_sw[l] = ((*rr & MANTISSA) == 0);
+        break;
+
+      case OPCODE_SHIFT_CODE_BY_ADDR:
+      case OPCODE_SHIFT_CODE_BY_EXP:
+        if (op == OPCODE_SHIFT_CODE_BY_ADDR) n = (a1 & EXPONENT_VALUE_MASK) - M20_MANTISSA_SHIFT;
+        else n = (int) (ens_peek (l, a1) >> BITS_36 & EXPONENT_VALUE_MASK) - M20_MANTISSA_SHIFT;
+        *time += cpu_op_time[op] + TIME_US(1.5) * (n>0 ? n : -n);
+        *rr = ens_peek (l, a2);
+        if (n > 0) *rr = (*rr << n);
+        else if (n < 0) *rr >>= -n;
+        *rr &= WORD45;
+        ens_store (l, a3, *rr);
+        ens_sw[l] = (*rr == 0);
+        break;
+
+      case OPCODE_ADD_CYCLIC:
+        x = ens_peek (l, a1);
+        y = ens_peek (l, a2);
+        *rr = (x & ~MANTISSA) + (y & ~MANTISSA);
+        t = (x & MANTISSA) + (y & MANTISSA);
+        ens_sw[l] = (t & BIT37) != 0;
+        if (*rr & BIT46) *rr += BIT37;
+        if (t & BIT37) t += 1;
+        *rr &= WORD45;
+        *rr |= (t & MANTISSA);
+        ens_store (l, a3, *rr);
+        *time += cpu_op_time[op];
+        break;
+
+      case OPCODE_SUB_CYCLIC:
+        x = ens_peek (l, a1);
+        y = ens_peek (l, a2);
+        xm = x & MANTISSA;
+        ym = y & MANTISSA;
+        xe = x & ~MANTISSA;
+        ye = y & ~MANTISSA;
+        t = 0; *rr = 0;
+        if (xm < ym) t += BIT37 + (xm - ym) - 1;
+        else t = xm - ym;
+        if (xe < ye) { *rr += BIT46 + (xe - ye) - BIT37; t -= 1; }
+        else *rr = xe - ye;
+        ens_sw[l] = (t & BIT37) != 0;
+        *rr |= (t & MANTISSA);
+        *rr &= WORD45;
+        ens_store (l, a3, *rr);
+        *time += cpu_op_time[op];
+        break;
+
+      case OPCODE_SHIFT_CYCLIC:
+        x = ens_peek (l, a1);
+        *rr = (x & WORD21) << BITS_24 | (x >> BITS_24 & WORD21);
+        ens_store (l, a3, *rr);
+        ens_sw[l] = (a3 == 0);
+        *time += cpu_op_time[op];
+        break;
+
+      case OPCODE_STOP_017:
+      case OPCODE_STOP_037:
+      case OPCODE_STOP_057:
+      case OPCODE_STOP_077:
+        *time += cpu_op_time[op];
+        *rr = 0;
+        ens_store (l, a3, *rr);
+        err = STOP_STOP;
+        goto done;
+
+      case OPCODE_CHANGE_RA_BY_ADDR:
+      case OPCODE_CHANGE_RA_BY_CODE:
+        *rr = ((t_value)OPCODE_CHANGE_RA_BY_ADDR<<BITS_36) | (a1 << BITS_12);
+        ens_store (l, a3, *rr);
+        if (op == OPCODE_CHANGE_RA_BY_ADDR) ens_ra[l] = a2;
+        else ens_ra[l] = ens_peek (l, a2) >> BITS_12 & MAX_ADDR_VALUE;
+        *time += cpu_op_time[op];
+        break;
+
+      case OPCODE_JUMP_WITH_RETURN:
+        *rr = ((t_value)OPCODE_JUMP_WITH_RETURN<<BITS_36) | (a1 << BITS_12);
+        ens_store (l, a3, *rr);
+        ens_kra[l] = a2;
+        *time += cpu_op_time[op];
+        break;
+
+      case OPCODE_COND_JUMP_BY_SIG_W_1:
+      case OPCODE_JUMP_BY_ADDR:
+      case OPCODE_COND_JUMP_BY_SIG_W_0:
+        *rr = ens_peek (l, a1);
+        ens_store (l, a3, *rr);
+        if ((op == OPCODE_JUMP_BY_ADDR) ||
+            ((op == OPCODE_COND_JUMP_BY_SIG_W_1) && ens_sw[l]) ||
+            ((op == OPCODE_COND_JUMP_BY_SIG_W_0) && !ens_sw[l])) ens_kra[l] = a2;
+        *time += cpu_op_time[op];
+        break;
+
+      case OPCODE_GOTO_AFTER_CYCLE_BY_PA_012:
+      case OPCODE_GOTO_AFTER_CYCLE_BY_PA_032:
+      case OPCODE_GOTO_AFTER_CYCLE_BY_PA_SIG_W_1_011:
+      case OPCODE_GOTO_AFTER_CYCLE_BY_PA_SIG_W_1_031:
+      case OPCODE_GOTO_AFTER_CYCLE_BY_PA_SIG_W_0_051:
+      case OPCODE_GOTO_AFTER_CYCLE_BY_PA_SIG_W_0_071:
+        switch (op) {
+          case OPCODE_GOTO_AFTER_CYCLE_BY_PA_012:           n = (ens_ra[l] < (unsigned)a1); break;
+          case OPCODE_GOTO_AFTER_CYCLE_BY_PA_032:           n = (ens_ra[l] >= (unsigned)a1); break;
+          case OPCODE_GOTO_AFTER_CYCLE_BY_PA_SIG_W_1_011:   n = (ens_ra[l] < (unsigned)a1) && ens_sw[l]; break;
+          case OPCODE_GOTO_AFTER_CYCLE_BY_PA_SIG_W_1_031:   n = (ens_ra[l] >= (unsigned)a1) && ens_sw[l]; break;
+          case OPCODE_GOTO_AFTER_CYCLE_BY_PA_SIG_W_0_051:   n = (ens_ra[l] < (unsigned)a1) && !ens_sw[l]; break;
+          default:                                          n = (ens_ra[l] >= (unsigned)a1) && !ens_sw[l]; break;
+        }
+        if (n) ens_kra[l] = a2;
+        ens_ra[l] = a3;
+        *time += cpu_op_time[op];
+        break;
+    }
+
+    if (memory_45_checking && ens_garbage (l, a1, a2, a3))
+        err = STOP_MEMORY_GARBAGE_DETECTED;
+
+done:
+    switch (ens_old_op[l]) {		/* P1 state as by CPU */
+      case OPCODE_MULT_ROUND_NORM:
+      case OPCODE_MULT_NORM:
+      case OPCODE_MULT_ROUND:
+      case OPCODE_MULT:
+        break;
+      default:
+        if (in->tags & 4) a1 = (a1 + ens_ra[l]) & MAX_ADDR_VALUE;
+        ens_p1[l] = ens_mem[l][a1];
+        break;
+    }
+    ens_old_op[l] = op;
+    return err;
+}
+
+
+
+/*
+ *  Stop of lane (as cpu_exec_fetched)
+ */
+static void ens_lane_stop (int l, t_stat r)
+{
+    if ((r == STOP_NEGSQRT) || (r == STOP_CRBADSUM) || (r == STOP_READERR) ||
+        (r == STOP_STOP) || (r == STOP_TAPEREADERR)) {
+        if (ens_kra[l] > 0001) ens_kra[l] -= 1;
+    }
+    ens_stop[l] = r;
+}
+
+
+
+/*
+ *  First lane of mask
+ */
+static int ens_first_lane (uint32 lanes)
+{
+    int i;
+
+    for (i = 0; i < ens_lanes; i++)
+        if (lanes & (1u << i)) return i;
+    return 0;
+}
+
+
+
+/*
+ *  Split lanes with other values than the first lane (KRA or instruction
+ *  word), every part but the first one waits for execution
+ */
+static uint32 ens_split (uint32 lanes, int by_word)
+{
+    uint32  rest = lanes, part, first = 0;
+    t_value v, w;
+    int     i, l;
+
+    while (rest) {
+        l = ens_first_lane (rest);
+        v = by_word ? ens_mem[l][ens_kra[l]] : ens_kra[l];
+        part = 0;
+        for (i = l; i < ens_lanes; i++) {
+            if (!(rest & (1u << i))) continue;
+            w = by_word ? ens_mem[i][ens_kra[i]] : ens_kra[i];
+            if (w == v) part |= 1u << i;
+        }
+        rest &= ~part;
+        if (first == 0) first = part;
+        else {
+            ens_wait[ens_wait_num++] = part;
+            ens_groups++;
+        }
+    }
+    return first;
+}
+
+
+
+/*
+ *  Run group of lanes with the same KRA in lockstep until all lanes stop
+ */
+static void ens_run_group (uint32 lanes, t_uint64 limit)
+{
+    ENS_INST in;
+    t_value  rk;
+    t_stat   r;
+    uint32   mask;
+    int      i, l, kra, diff;
+
+    while (lanes) {
+        l = ens_first_lane (lanes);
+        kra = ens_kra[l];
+        r = ENS_RUNNING;
+        if (ens_count[l] >= limit) r = STOP_INSTRLIMIT;
+        else if (kra >= MAX_MEM_SIZE) r = STOP_RUNOUT;
+        if (r != ENS_RUNNING) {
+            for (i = l; i < ens_lanes; i++)
+                if (lanes & (1u << i)) ens_stop[i] = r;
+            return;
+        }
+
+        /* shared fetch */
+        rk = ens_mem[l][kra];
+        for (i = l + 1; i < ens_lanes; i++)
+            if ((lanes & (1u << i)) && (ens_mem[i][kra] != rk)) break;
+        if (i < ens_lanes) {
+            lanes = ens_split (lanes, TRUE);
+            continue;
+        }
+
+        /* shared decode */
+        in.tags = (int) (rk >> BITS_42 & MAX_ADDR_TAG_VALUE);
+        in.op   = (int) (rk >> BITS_36 & MAX_OPCODE_VALUE);
+        in.a1   = (int) (rk >> BITS_24 & MAX_ADDR_VALUE);
+        in.a2   = (int) (rk >> BITS_12 & MAX_ADDR_VALUE);
+        in.a3   = (int) (rk >> BITS_0  & MAX_ADDR_VALUE);
+        if (OPCODE_IS_IO (in.op)) {
+            for (i = l; i < ens_lanes; i++)
+                if (lanes & (1u << i)) ens_stop[i] = ENS_STOP_IO;
+            return;
+        }
+        ens_executed++;
+
+        /* execution by lanes */
+        mask = lanes;
+        diff = FALSE;
+        for (i = l; i < ens_lanes; i++) {
+            if (!(mask & (1u << i))) continue;
+            ens_kra[i] = kra + 1;
+            r = ens_exec_lane (i, &in);
+            if (r != STOP_MEM) ens_count[i]++;
+            if (r) {
+                ens_lane_stop (i, r);
+                lanes &= ~(1u << i);
+            }
+            else if (ens_kra[i] != ens_kra[ens_first_lane (lanes)]) diff = TRUE;
+        }
+        if (diff) lanes = ens_split (lanes, FALSE);
+    }
+}
+
+
+
+/*
+ *  Print results
+ */
+static const char *ens_stop_text (t_stat r)
+{
+    if (r == ENS_STOP_IO) return "i/o instruction";
+    if ((r > 0) && (r < SCPE_BASE) && (sim_stop_messages[r] != NULL))
+        return sim_stop_messages[r];
+    return sim_error_text (r);
+}
+
+static void ens_print (FILE *st, int d_start, int d_end)
+{
+    int      i, a;
+    t_uint64 lane_sum = 0;
+
+    for (i = 0; i < ens_lanes; i++) lane_sum += ens_count[i];
+
+    fprintf (st, "Ensemble: %d lanes, %d groups, %.0f instructions executed for %.0f of lanes\n",
+             ens_lanes, ens_groups, (double) ens_executed, (double) lane_sum);
+    fprintf (st, "Lane  RPU1             RPU2             RPU3             RPU4             KRA   Instructions  Time, s\n");
+    for (i = 0; i < ens_lanes; i++) {
+        fprintf (st, "%4d  %015llo  %015llo  %015llo  %015llo  %04o  %12.0f  %.6f  %s\n",
+                 i, ens_rpu[0][i], ens_rpu[1][i], ens_rpu[2][i], ens_rpu[3][i],
+                 ens_kra[i], (double) ens_count[i], TIME_TO_US (ens_time[i]) / 1000000.0,
+                 ens_stop_text (ens_stop[i]));
+    }
+    if (d_start < 0) return;
+    for (i = 0; i < ens_lanes; i++) {
+        fprintf (st, "Lane %d:\n", i);
+        for (a = d_start; a <= d_end; a++)
+            fprintf (st, "  %04o: %015llo\n", a, ens_mem[i][a]);
+    }
+}
+
+
+
+/*
+ *  ENSEMBLE command
+ */
+t_stat m20_ens_cmd (int32 flag, CONST char *cptr)
+{
+    char      gbuf[CBUFSIZE], *tptr;
+    t_value   cur[ENS_RPU_NUM];
+    t_value   save_p1;
+    t_uint64  limit;
+    t_addr    lo, hi;
+    int       d_start = -1, d_end = -1;
+    int       i, k;
+    double    v;
+    uint32    lanes;
+
+    limit = (run_instr_limit > 0) ? run_instr_limit : ENS_DEF_LIMIT;
+
+    while (*cptr == '-') {
+        cptr = get_glyph (cptr, gbuf, 0);
+        if (*cptr == 0) return SCPE_2FARG;
+        if (strcmp (gbuf, "-I") == 0) {
+            cptr = get_glyph (cptr, gbuf, 0);
+            v = strtod (gbuf, &tptr);
+            if ((tptr == gbuf) || (*tptr != 0) || (v < 1)) return SCPE_ARG;
+            limit = (t_uint64) v;
+        }
+        else if (strcmp (gbuf, "-D") == 0) {
+            cptr = get_glyph (cptr, gbuf, 0);
+            tptr = (char *) get_range (NULL, gbuf, &lo, &hi, 8, MAX_ADDR_VALUE, 0);
+            if ((tptr == NULL) || (*tptr != 0) || (lo > hi)) return SCPE_ARG;
+            d_start = (int) lo;
+            d_end = (int) hi;
+        }
+        else return SCPE_ARG;
+    }
+
+    /* lanes */
+    cur[0] = RPU1;  cur[1] = RPU2;  cur[2] = RPU3;  cur[3] = RPU4;
+    ens_lanes = 0;
+    while (*cptr) {
+        if (ens_lanes >= ENS_MAX_LANES) return SCPE_2MARG;
+        cptr = get_glyph (cptr, gbuf, 0);
+        tptr = gbuf;
+        for (k = 0; k < ENS_RPU_NUM; k++) {
+            ens_rpu[k][ens_lanes] = cur[k];
+            if (*tptr == 0) continue;
+            if (*tptr != '/') {
+                ens_rpu[k][ens_lanes] = (t_value) strtotv (tptr, (CONST char **) &tptr, 8);
+                if (ens_rpu[k][ens_lanes] & ~WORD45) return SCPE_ARG;
+            }
+            if (*tptr == '/') tptr++;
+            else if (*tptr != 0) return SCPE_ARG;
+        }
+        if (*tptr != 0) return SCPE_ARG;
+        ens_lanes++;
+    }
+    if (ens_lanes == 0) return SCPE_2FARG;
+
+    /* every lane starts from the CPU state */
+    for (i = 0; i < ens_lanes; i++) {
+        ens_kra[i] = regKRA & MAX_ADDR_VALUE;
+        ens_ra[i] = regRA;
+        ens_sw[i] = trgSW;
+        ens_rr[i] = regRR;
+        ens_p1[i] = regP1;
+        ens_old_op[i] = old_opcode;
+        ens_stop[i] = ENS_RUNNING;
+        ens_count[i] = 0;
+        ens_time[i] = 0;
+        memcpy (ens_mem[i], MOSU, sizeof (MOSU));
+    }
+    save_p1 = regP1;			/* used by multiplication */
+
+    /* all lanes start as one group */
+    ens_wait_num = 0;
+    ens_groups = 1;
+    ens_executed = 0;
+    lanes = (1u << ens_lanes) - 1;
+    for (;;) {
+        ens_run_group (lanes, limit);
+        if (ens_wait_num == 0) break;
+        lanes = ens_wait[--ens_wait_num];
+    }
+    regP1 = save_p1;
+
+    ens_print (stdout, d_start, d_end);
+    if (sim_log && (sim_log != stdout)) ens_print (sim_log, d_start, d_end);
+
+    return SCPE_OK;
+}
@@ -0,0 +1,292 @@
+/*
+ * File:     m20_heat.c
+ * Purpose:  M-20 simulator data access heatmap of MOSU and drums
+ *
+ * Copyright (c) 2026, Dmitry Stefankov
+ *
+ * $Id$
+ *
+ * With DEP HEATMAP 1 are counted while CPU is running:  executions
+ * (instruction fetches) of every MOSU address, reads and writes of MOSU
+ * words by instruction operands and by external devices, and reads and
+ * writes of every word of physical drums by drum transfers (checksum
+ * words are included).  Idle loop fast-forward is not used while
+ * counting, so every pass of the loop is seen.
+ *
+ * Commands:
+ *   SHOW MEMORY HEATMAP (or HEATMAP)  print totals, hottest words and
+ *                                     maps of MOSU and drums
+ *   RESET MEMORY HEATMAP              clear counters
+ *   HEATMAP FILE file                 write counters into binary file
+ *                                     (format in m20_defs.h)
+ *
+ * In maps one character stands for 8 words, the darker the more
+ * accesses (logarithmic scale to the hottest character of the map).
+ *
+ * Revision History.
+ *
+ *  19-Oct-2026  DVS  Initial Implementation
+ *
+ */
+
+#include "m20_defs.h"
+#include <math.h>
+
+
+#define  HEAT_TOP            8		/* hottest words in summary */
+#define  HEAT_MAP_GROUP      8		/* words per map character */
+#define  HEAT_MAP_WIDTH      64		/* characters per map line */
+
+#define  HEAT_SUM(c1,c2,a)   ((c1)[a] + ((c2) ? (c2)[a] : 0))
+
+
+/* Parameters (CPU registers) */
+
+int  heatmap_on = 0;			/* enable heatmap counters */
+
+
+/* Counters */
+
+static t_uint64  heat_exec[MAX_MEM_SIZE];
+static t_uint64  heat_read[MAX_MEM_SIZE];
+static t_uint64  heat_write[MAX_MEM_SIZE];
+static t_uint64  heat_drum_read[MAX_PHYS_DRUM_COUNT][DRUM_SIZE];
+static t_uint64  heat_drum_write[MAX_PHYS_DRUM_COUNT][DRUM_SIZE];
+
+static const char heat_levels[] = " .:-=+*#%@";
+
+
+
+/*
+ *  Collection
+ */
+void m20_heat_exec (int addr)
+{
+    heat_exec[addr & MAX_ADDR_VALUE]++;
+}
+
+
+void m20_heat_read (int addr)
+{
+    heat_read[addr & MAX_ADDR_VALUE]++;
+}
+
+
+void m20_heat_write (int addr)
+{
+    heat_write[addr & MAX_ADDR_VALUE]++;
+}
+
+
+void m20_heat_drum (int drum_no, int addr, int nwords, int write)
+{
+    t_uint64 *cnt;
+    int  i;
+
+    if ((drum_no < 0) || (drum_no >= MAX_PHYS_DRUM_COUNT) || !sim_is_running) return;
+    cnt = write ? heat_drum_write[drum_no] : heat_drum_read[drum_no];
+    for (i = 0; (i < nwords) && (addr + i < DRUM_SIZE); i++)
+        cnt[addr + i]++;
+}
+
+
+void m20_heat_reset (void)
+{
+    memset (heat_exec, 0, sizeof(heat_exec));
+    memset (heat_read, 0, sizeof(heat_read));
+    memset (heat_write, 0, sizeof(heat_write));
+    memset (heat_drum_read, 0, sizeof(heat_drum_read));
+    memset (heat_drum_write, 0, sizeof(heat_drum_write));
+}
+
+
+
+/*
+ *  Output
+ */
+static void m20_heat_top (FILE *st, const char *title, const t_uint64 *c1, const t_uint64 *c2,
+                          int size, int width)
+{
+    int  top[HEAT_TOP];
+    int  a, i, k, n = 0;
+    t_uint64 v;
+
+    for (a = 0; a < size; a++) {			/* sorted by count */
+        v = HEAT_SUM (c1, c2, a);
+        if (v == 0) continue;
+        if (n < HEAT_TOP) k = n++;
+        else if (v > HEAT_SUM (c1, c2, top[HEAT_TOP-1])) k = HEAT_TOP-1;
+        else continue;
+        for (; (k > 0) && (HEAT_SUM (c1, c2, top[k-1]) < v); k--) top[k] = top[k-1];
+        top[k] = a;
+    }
+    if (n == 0) return;
+    fprintf (st, "  %-10s", title);
+    for (i = 0; i < n; i++)
+        fprintf (st, " %0*o(%llu)", width, top[i], HEAT_SUM (c1, c2, top[i]));
+    fprintf (st, "\n");
+}
+
+
+static void m20_heat_map (FILE *st, const char *title, const t_uint64 *c1, const t_uint64 *c2,
+                          int size)
+{
+    t_uint64 sum[DRUM_SIZE/HEAT_MAP_GROUP];
+    t_uint64 max = 0;
+    int  a, i, n, lev;
+
+    n = size / HEAT_MAP_GROUP;
+    for (i = 0; i < n; i++) {
+        sum[i] = 0;
+        for (a = i*HEAT_MAP_GROUP; a < (i+1)*HEAT_MAP_GROUP; a++)
+            sum[i] += HEAT_SUM (c1, c2, a);
+        if (sum[i] > max) max = sum[i];
+    }
+    if (max == 0) return;
+
+    fprintf (st, "%s:\n", title);
+    for (i = 0; i < n; i++) {
+        if ((i % HEAT_MAP_WIDTH) == 0) fprintf (st, "  %05o  ", i*HEAT_MAP_GROUP);
+        if (sum[i] == 0) lev = 0;
+        else if (max == 1) lev = 9;
+        else lev = 1 + (int)(8.0 * log ((double)sum[i]) / log ((double)max));
+        fputc (heat_levels[lev], st);
+        if ((i % HEAT_MAP_WIDTH) == HEAT_MAP_WIDTH-1) fprintf (st, "\n");
+    }
+}
+
+
+static void m20_heat_totals (const t_uint64 *c, int size, int *words, t_uint64 *sum)
+{
+    int  a;
+
+    *words = 0;
+    *sum = 0;
+    for (a = 0; a < size; a++) {
+        if (c[a] == 0) continue;
+        (*words)++;
+        *sum += c[a];
+    }
+}
+
+
+static void m20_heat_print (FILE *st)
+{
+    char  title[64];
+    int   d, we, wr, ww;
+    t_uint64  se, sr, sw;
+
+    fprintf (st, "Memory heatmap%s:\n", heatmap_on ? "" : " (off, DEP HEATMAP 1)");
+    m20_heat_totals (heat_exec, MAX_MEM_SIZE, &we, &se);
+    m20_heat_totals (heat_read, MAX_MEM_SIZE, &wr, &sr);
+    m20_heat_totals (heat_write, MAX_MEM_SIZE, &ww, &sw);
+    fprintf (st, "  MOSU:      executed %d words (%llu), read %d words (%llu), written %d words (%llu)\n",
+             we, se, wr, sr, ww, sw);
+    for (d = 0; d < MAX_PHYS_DRUM_COUNT; d++) {
+        m20_heat_totals (heat_drum_read[d], DRUM_SIZE, &wr, &sr);
+        m20_heat_totals (heat_drum_write[d], DRUM_SIZE, &ww, &sw);
+        if ((sr == 0) && (sw == 0)) continue;
+        fprintf (st, "  DRUM%d:     read %d words (%llu), written %d words (%llu)\n",
+                 d, wr, sr, ww, sw);
+    }
+
+    m20_heat_top (st, "executed:", heat_exec, NULL, MAX_MEM_SIZE, 4);
+    m20_heat_top (st, "read:", heat_read, NULL, MAX_MEM_SIZE, 4);
+    m20_heat_top (st, "written:", heat_write, NULL, MAX_MEM_SIZE, 4);
+    for (d = 0; d < MAX_PHYS_DRUM_COUNT; d++) {
+        _snprintf (title, sizeof(title), "DRUM%d:", d);
+        m20_heat_top (st, title, heat_drum_read[d], heat_drum_write[d], DRUM_SIZE, 5);
+    }
+
+    m20_heat_map (st, "MOSU executions", heat_exec, NULL, MAX_MEM_SIZE);
+    m20_heat_map (st, "MOSU reads and writes", heat_read, heat_write, MAX_MEM_SIZE);
+    for (d = 0; d < MAX_PHYS_DRUM_COUNT; d++) {
+        _snprintf (title, sizeof(title), "DRUM%d reads and writes", d);
+        m20_heat_map (st, title, heat_drum_read[d], heat_drum_write[d], DRUM_SIZE);
+    }
+}
+
+
+t_stat m20_heat_show (FILE *st)
+{
+    m20_heat_print (st);
+    return SCPE_OK;
+}
+
+
+
+/*
+ *  Binary file of counters
+ */
+static void m20_heat_put_le (unsigned char *p, t_uint64 v, int size)
+{
+    int  i;
+
+    for (i = 0; i < size; i++, v >>= 8) p[i] = (unsigned char)(v & 0xFF);
+}
+
+
+static int m20_heat_put_array (FILE *f, const t_uint64 *c, int size)
+{
+    unsigned char  buf[M20_HEAT_WORD_SIZE];
+    int  a;
+
+    for (a = 0; a < size; a++) {
+        m20_heat_put_le (buf, c[a], M20_HEAT_WORD_SIZE);
+        if (fwrite (buf, 1, sizeof(buf), f) != sizeof(buf)) return -1;
+    }
+    return 0;
+}
+
+
+static t_stat m20_heat_save (const char *filename)
+{
+    unsigned char  hdr[M20_HEAT_HEADER_SIZE];
+    FILE * f;
+    int  d, err;
+
+    f = sim_fopen (filename, "wb");
+    if (f == NULL) return SCPE_OPENERR;
+
+    memset (hdr, 0, sizeof(hdr));
+    memcpy (hdr, M20_HEAT_MAGIC, 4);
+    m20_heat_put_le (hdr+4, M20_HEAT_VERSION, 2);
+    m20_heat_put_le (hdr+6, M20_HEAT_ARRAYS, 2);
+    m20_heat_put_le (hdr+8, MAX_MEM_SIZE, 2);
+    m20_heat_put_le (hdr+10, DRUM_SIZE, 2);
+    m20_heat_put_le (hdr+12, MAX_PHYS_DRUM_COUNT, 2);
+    err = (fwrite (hdr, 1, sizeof(hdr), f) != sizeof(hdr));
+    err = err || m20_heat_put_array (f, heat_exec, MAX_MEM_SIZE);
+    err = err || m20_heat_put_array (f, heat_read, MAX_MEM_SIZE);
+    err = err || m20_heat_put_array (f, heat_write, MAX_MEM_SIZE);
+    for (d = 0; d < MAX_PHYS_DRUM_COUNT; d++) {
+        err = err || m20_heat_put_array (f, heat_drum_read[d], DRUM_SIZE);
+        err = err || m20_heat_put_array (f, heat_drum_write[d], DRUM_SIZE);
+    }
+    if (fclose (f) != 0) err = 1;
+
+    return err ? SCPE_IOERR : SCPE_OK;
+}
+
+
+
+/*
+ *  HEATMAP command
+ */
+t_stat m20_heat_cmd (int32 flag, CONST char *cptr)
+{
+    char  gbuf[CBUFSIZE];
+
+    cptr = get_glyph (cptr, gbuf, 0);
+    if (gbuf[0] == 0) {
+        m20_heat_print (stdout);
+        if (sim_log && (sim_log != stdout)) m20_heat_print (sim_log);
+        return SCPE_OK;
+    }
+    if (strcmp (gbuf, "FILE") != 0) return SCPE_ARG;
+
+    cptr = get_glyph_nc (cptr, gbuf, 0);
+    if (gbuf[0] == 0) return SCPE_2FARG;
+    if (*cptr) return SCPE_2MARG;
+    return m20_heat_save (gbuf);
+}
@@ -0,0 +1,345 @@
+/*
+ * File:     m20_hpc.c
+ * Purpose:  M-20 simulator host performance counters by M-20 opcodes
+ *
+ * Copyright (c) 2026, Dmitry Stefankov
+ *
+ * $Id$
+ *
+ * With DEP HPC_SAMPLE n every n-th instruction (1 - every instruction)
+ * is executed between two reads of host counters of simulator process:
+ * cycles, instructions, branch misses and L1 data cache read misses
+ * (Linux perf_event_open, user mode only).  Differences are summed by
+ * M-20 opcode and by address range of instruction (HPC_RANGE_SIZE words),
+ * so it is seen which operations cost the host mispredictions and cache
+ * misses.  Cost of counter reads is measured when counters are opened and
+ * subtracted from averages in report.
+ *
+ * Burst execution is not used while sampling.  If counters cannot be
+ * opened (other OS, no PMU in virtual machine, perf_event_paranoid),
+ * only samples are counted and report tells the reason.  Counter that
+ * is not supported by host CPU is left out.
+ *
+ * Commands:
+ *   PROFILE HOST [n]                print host counters by opcodes and
+ *                                   address ranges (first n lines)
+ *   PROFILE RESET                   clear profile data
+ *
+ * Revision History.
+ *
+ *  19-Oct-2026  DVS  Initial Implementation
+ *
+ */
+
+#include "m20_defs.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <errno.h>
+#define  M20_HPC_PERF        1
+#endif
+
+
+/* System module references (symbol map) */
+
+extern const char * m20_sym_name (int addr);
+
+
+#define  HPC_CYCLES          0
+#define  HPC_INSTR           1
+#define  HPC_BRANCH_MISS     2
+#define  HPC_L1D_MISS        3
+#define  HPC_NUM             4
+
+#define  HPC_RANGE_SIZE      0100		/* words of address range */
+#define  HPC_RANGES          (MAX_MEM_SIZE/HPC_RANGE_SIZE)
+#define  HPC_CALIBRATE       1000		/* empty samples to measure overhead */
+
+/* Counters state */
+#define  HPC_UNTRIED         0
+#define  HPC_OPEN            1
+#define  HPC_FAILED          2
+
+
+/* Parameters (CPU registers) */
+
+int  hpc_sample = 0;			/* sample every n-th instruction (0 - off) */
+int  hpc_countdown = 0;			/* instructions to next sample */
+
+
+/* Counters of samples */
+typedef  struct hpc_stat {
+    t_uint64  samples;
+    t_uint64  sum[HPC_NUM];
+} HPC_STAT, * PHPC_STAT;
+
+
+static const char * hpc_name[HPC_NUM] = {
+    "cycles", "instructions", "branch-misses", "L1D-misses"
+};
+
+static HPC_STAT   hpc_op[MAX_OPCODE_VALUE+1];
+static HPC_STAT   hpc_range[HPC_RANGES];
+static HPC_STAT   hpc_total;
+static double     hpc_overhead[HPC_NUM];	/* per sample */
+static int        hpc_state = HPC_UNTRIED;
+static char       hpc_error[128] = "";
+static int        hpc_index[HPC_NUM];		/* position in group read (-1 - none) */
+static int        hpc_group_num = 0;
+static t_uint64   hpc_before[HPC_NUM];
+
+#if M20_HPC_PERF
+static int        hpc_leader = -1;
+
+typedef  struct hpc_read_buf {
+    t_uint64  nr;
+    t_uint64  values[HPC_NUM];
+} HPC_READ_BUF;
+#endif
+
+
+
+/*
+ *  Host counters
+ */
+#if M20_HPC_PERF
+static int hpc_open_one (uint32 type, t_uint64 config)
+{
+    struct perf_event_attr pe;
+
+    memset (&pe, 0, sizeof(pe));
+    pe.type = type;
+    pe.size = sizeof(pe);
+    pe.config = config;
+    pe.disabled = (hpc_leader < 0);
+    pe.exclude_kernel = 1;
+    pe.exclude_hv = 1;
+    pe.read_format = PERF_FORMAT_GROUP;
+    return (int) syscall (__NR_perf_event_open, &pe, 0, -1, hpc_leader, 0);
+}
+#endif
+
+
+/* Read counters of group into v[] (0 for counters left out) */
+static int hpc_read (t_uint64 *v)
+{
+#if M20_HPC_PERF
+    HPC_READ_BUF  buf;
+    int  i;
+
+    if (read (hpc_leader, &buf, sizeof(buf)) < (ssize_t)(sizeof(t_uint64) * (1 + hpc_group_num)))
+        return -1;
+    for (i = 0; i < HPC_NUM; i++)
+        v[i] = (hpc_index[i] >= 0) ? buf.values[hpc_index[i]] : 0;
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+
+static void hpc_calibrate (void)
+{
+    t_uint64  v0[HPC_NUM], v1[HPC_NUM];
+    double    sum[HPC_NUM];
+    int  i, k;
+
+    memset (sum, 0, sizeof(sum));
+    for (k = 0; k < HPC_CALIBRATE; k++) {
+        if ((hpc_read (v0) != 0) || (hpc_read (v1) != 0)) break;
+        for (i = 0; i < HPC_NUM; i++) sum[i] += (double)(v1[i] - v0[i]);
+    }
+    for (i = 0; i < HPC_NUM; i++)
+        hpc_overhead[i] = (k > 0) ? sum[i] / k : 0;
+}
+
+
+static void hpc_open (void)
+{
+#if M20_HPC_PERF
+    static const uint32 type[HPC_NUM] = {
+        PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE
+    };
+    static const t_uint64 config[HPC_NUM] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_BRANCH_MISSES,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+    };
+    int  i, fd;
+
+    hpc_state = HPC_FAILED;
+    for (i = 0; i < HPC_NUM; i++) {
+        hpc_index[i] = -1;
+        fd = hpc_open_one (type[i], config[i]);
+        if (fd < 0) {
+            if (hpc_leader < 0)			/* no counters opened yet */
+                _snprintf (hpc_error, sizeof(hpc_error), "perf_event_open: %s", strerror (errno));
+            continue;
+        }
+        if (hpc_leader < 0) hpc_leader = fd;
+        hpc_index[i] = hpc_group_num++;
+    }
+    if (hpc_leader < 0) return;
+    if (ioctl (hpc_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) != 0) {
+        _snprintf (hpc_error, sizeof(hpc_error), "perf_event enable: %s", strerror (errno));
+        return;
+    }
+    hpc_state = HPC_OPEN;
+    hpc_calibrate ();
+#else
+    hpc_state = HPC_FAILED;
+    strcpy (hpc_error, "not supported on this host");
+#endif
+}
+
+
+
+/*
+ *  Called on start of simulation
+ */
+void m20_hpc_run_start (void)
+{
+    if (!hpc_sample) return;
+    if (hpc_state == HPC_UNTRIED) hpc_open ();
+    hpc_countdown = hpc_sample;
+}
+
+
+/*
+ *  Called before and after sampled instruction
+ */
+void m20_hpc_begin (void)
+{
+    hpc_countdown = hpc_sample;
+    if (hpc_state == HPC_OPEN) hpc_read (hpc_before);
+}
+
+
+void m20_hpc_end (int pc, int op)
+{
+    t_uint64  v[HPC_NUM];
+    PHPC_STAT  sp[3];
+    int  i, k;
+
+    sp[0] = &hpc_op[op & MAX_OPCODE_VALUE];
+    sp[1] = &hpc_range[(pc & MAX_ADDR_VALUE) / HPC_RANGE_SIZE];
+    sp[2] = &hpc_total;
+    if ((hpc_state == HPC_OPEN) && (hpc_read (v) == 0)) {
+        for (i = 0; i < HPC_NUM; i++) v[i] -= hpc_before[i];
+    }
+    else memset (v, 0, sizeof(v));
+    for (k = 0; k < 3; k++) {
+        sp[k]->samples++;
+        for (i = 0; i < HPC_NUM; i++) sp[k]->sum[i] += v[i];
+    }
+}
+
+
+void m20_hpc_reset (void)
+{
+    memset (hpc_op, 0, sizeof(hpc_op));
+    memset (hpc_range, 0, sizeof(hpc_range));
+    memset (&hpc_total, 0, sizeof(hpc_total));
+}
+
+
+
+/*
+ *  Report
+ */
+static double hpc_avg (PHPC_STAT sp, int i)
+{
+    double  v;
+
+    if (sp->samples == 0) return 0;
+    v = (double)sp->sum[i] / sp->samples - hpc_overhead[i];
+    return (v > 0) ? v : 0;
+}
+
+
+/* Sort key: cycles, or samples without counters */
+static double hpc_weight (PHPC_STAT sp)
+{
+    if (hpc_state == HPC_OPEN) return hpc_avg (sp, HPC_CYCLES) * sp->samples;
+    return (double)sp->samples;
+}
+
+
+static PHPC_STAT hpc_sort_table;
+
+static int hpc_cmp (const void * p1, const void * p2)
+{
+    double  w1 = hpc_weight (&hpc_sort_table[*(const int *)p1]);
+    double  w2 = hpc_weight (&hpc_sort_table[*(const int *)p2]);
+
+    if (w1 < w2) return 1;
+    if (w1 > w2) return -1;
+    return *(const int *)p1 - *(const int *)p2;
+}
+
+
+static void hpc_print_table (FILE * st, PHPC_STAT table, int size, int range, int max)
+{
+    int  order[HPC_RANGES > MAX_OPCODE_VALUE+1 ? HPC_RANGES : MAX_OPCODE_VALUE+1];
+    int  i, j, n = 0;
+    double  total = hpc_weight (&hpc_total);
+    PHPC_STAT  sp;
+
+    for (i = 0; i < size; i++)
+        if (table[i].samples > 0) order[n++] = i;
+    hpc_sort_table = table;
+    qsort (order, n, sizeof(int), hpc_cmp);
+
+    if (range) fprintf (st, "range       ");
+    else fprintf (st, "op  ");
+    fprintf (st, "     samples   share");
+    if (hpc_state == HPC_OPEN)
+        for (j = 0; j < HPC_NUM; j++)
+            if (hpc_index[j] >= 0) fprintf (st, " %14s", hpc_name[j]);
+    fprintf (st, "%s\n", range ? "  routine" : "");
+
+    for (i = 0; (i < n) && ((max == 0) || (i < max)); i++) {
+        sp = &table[order[i]];
+        if (range) fprintf (st, "%04o-%04o  ", order[i]*HPC_RANGE_SIZE, (order[i]+1)*HPC_RANGE_SIZE-1);
+        else fprintf (st, "%02o  ", order[i]);
+        fprintf (st, "%12llu %6.2f%%", sp->samples, (total > 0) ? 100.0 * hpc_weight (sp) / total : 0.0);
+        if (hpc_state == HPC_OPEN)
+            for (j = 0; j < HPC_NUM; j++)
+                if (hpc_index[j] >= 0) fprintf (st, " %14.2f", hpc_avg (sp, j));
+        if (range && m20_sym_name (order[i]*HPC_RANGE_SIZE))
+            fprintf (st, "  %s", m20_sym_name (order[i]*HPC_RANGE_SIZE));
+        fprintf (st, "\n");
+    }
+}
+
+
+/*
+ *  Print host counters (per sampled instruction) by opcodes and ranges
+ *  max - number of printed lines of every table (0 = all)
+ */
+void m20_hpc_print (FILE * st, int max)
+{
+    int  i;
+
+    fprintf (st, "\n*** Host counters stat ***\n");
+    fprintf (st, "Sampled every %d instructions%s, samples=%llu\n",
+             hpc_sample, hpc_sample ? "" : " (off, DEP HPC_SAMPLE n)", hpc_total.samples);
+    if (hpc_state == HPC_OPEN) {
+        fprintf (st, "Averages per instruction, minus overhead of counter reads:");
+        for (i = 0; i < HPC_NUM; i++)
+            if (hpc_index[i] >= 0) fprintf (st, "  %s=%.1f", hpc_name[i], hpc_overhead[i]);
+        fprintf (st, "\n");
+    }
+    else if (hpc_state == HPC_FAILED)
+        fprintf (st, "Host counters are not available (%s), only samples are counted\n", hpc_error);
+    if (hpc_total.samples > 0) {
+        hpc_print_table (st, hpc_op, MAX_OPCODE_VALUE+1, FALSE, max);
+        hpc_print_table (st, hpc_range, HPC_RANGES, TRUE, max);
+    }
+    fprintf (st, "**********\n\n");
+}
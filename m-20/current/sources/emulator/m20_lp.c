@@ -19,6 +19,8 @@
  *  05-Dec-2014  DVS  Minor fixes
  *  27-Dec-2014  DVS  Added +,- bcd-codes according [1973 Lavrov]
  *  13-Mar-2015  DVS  Cleanup code
+ *  19-Oct-2026  DVS  Exact integer binary-to-decimal conversion for print
+ *  19-Oct-2026  DVS  Added in-memory attachments (mem:name)
  *
  */
 
@@ -50,6 +52,8 @@ extern t_value mosu_load (int addr);
 extern t_stat put_code_into_cbuf_reg( t_value ncode);
 extern t_value  cyclic_checksum( t_value x, t_value y);
 extern double m20_to_ieee (t_value word);
+extern t_stat m20_attach_unit (UNIT *uptr, CONST char *cptr);
+extern t_stat m20_detach_unit (UNIT *uptr);
 
 /* functions */
 t_stat lpt_reset (DEVICE *dptr);
@@ -146,7 +150,7 @@ t_stat lpt_attach (UNIT *uptr, char *cptr)
 
     active_lpt++;
 
-    return attach_unit (uptr, cptr);
+    return m20_attach_unit (uptr, cptr);
 }
 
 
@@ -159,7 +163,7 @@ t_stat lpt_detach (UNIT *uptr)
 
     active_lpt--;
 
-    return detach_unit (uptr);
+    return m20_detach_unit (uptr);
 }
 
 
@@ -197,63 +201,148 @@ t_stat  output_lp_line( char * out_line )
 
 
 
+/*
+ *  Exact binary-to-decimal conversion of M-20 number.
+ *
+ *  Value is mantissa * 2^(exponent-64-36), i.e. integer N = mantissa*2^k
+ *  (k >= 0) or N = mantissa*5^(-k) scaled by 10^k (k < 0). N is built in
+ *  base 10^9 limbs with table of powers of 5, all its decimal digits are
+ *  exact. Result is rounded to 10 significant digits (half to even, as
+ *  printf does for "%13.9e") and first 9 digits are printed.
+ */
+
+#define DEC_LIMB_BASE      1000000000
+#define DEC_LIMB_DIGITS    9
+#define DEC_MAX_LIMBS      12
+#define DEC_MAX_DIGITS     (DEC_MAX_LIMBS*DEC_LIMB_DIGITS)
+#define DEC_POW5_MAX       13
+
+static const uint32 dec_pow5_table[DEC_POW5_MAX+1] = {
+    1, 5, 25, 125, 625, 3125, 15625, 78125, 390625, 1953125,
+    9765625, 48828125, 244140625, 1220703125
+};
+
+
+/* digits of N (most significant first, no leading zeros), returns number */
+static int dec_exact_digits( t_value mantissa, int bin_exp, char * digits, int * dec_exp )
+{
+    uint32   limbs[DEC_MAX_LIMBS];
+    int      limbs_num, i, j, n, k;
+    t_value  carry;
+    char     tmp[DEC_LIMB_DIGITS];
+    uint32   v;
+
+    if (bin_exp >= 0) {
+        mantissa <<= bin_exp;		/* < 2^63 */
+        k = 0;
+    }
+    else k = -bin_exp;
+
+    limbs_num = 0;
+    while( mantissa > 0 ) {
+        limbs[limbs_num++] = (uint32)(mantissa % DEC_LIMB_BASE);
+        mantissa /= DEC_LIMB_BASE;
+    }
+
+    /* multiply by 5^k */
+    for( j=k; j>0; j-=n ) {
+        n = (j > DEC_POW5_MAX) ? DEC_POW5_MAX : j;
+        carry = 0;
+        for( i=0; i<limbs_num; i++ ) {
+            carry += (t_value)limbs[i] * dec_pow5_table[n];
+            limbs[i] = (uint32)(carry % DEC_LIMB_BASE);
+            carry /= DEC_LIMB_BASE;
+        }
+        while( carry > 0 ) {
+            limbs[limbs_num++] = (uint32)(carry % DEC_LIMB_BASE);
+            carry /= DEC_LIMB_BASE;
+        }
+    }
+
+    n = 0;
+    for( i=limbs_num-1; i>=0; i-- ) {
+        v = limbs[i];
+        for( j=DEC_LIMB_DIGITS-1; j>=0; j-- ) {
+            tmp[j] = (char)('0' + v % 10);
+            v /= 10;
+        }
+        for( j=0; j<DEC_LIMB_DIGITS; j++ ) {
+            if ((n == 0) && (tmp[j] == '0')) continue;
+            digits[n++] = tmp[j];
+        }
+    }
+
+    *dec_exp = n - k;
+    return n;
+}
+
+
+
 t_stat  make_decimal_print_values( t_value mcode, PDECIMAL_PRINT_VALUES  p_d_values )
 {
-    int sign, exp_d, i;
-    char * p, *s, *p1,*p2;
-    double d;
-    char  temp_buf[32];
+    char  digits[DEC_MAX_DIGITS+1];
+    int   n, i, exp_d, round_up;
+    t_value  mantissa;
 
     if (p_d_values == NULL) return SCPE_IOERR;
 
-    d = m20_to_ieee (mcode);
-    _snprintf (lbuf,sizeof(lbuf),"%13.9e", d);
-    s = lbuf;
-    p = s;
-    sign = 1;
-    if (*p == '-') { sign = 0; p++; }
-    p1 = strchr(p,'.');
-    p2 = strchr(p,'e');
-    if ((p1 == NULL) || (p2 == NULL)) return SCPE_IOERR;
-
     p_d_values->mcode = mcode;
-    p_d_values->num_sign = sign;
+    p_d_values->num_sign = (mcode & SIGN) ? 0 : 1;
 
-    exp_d = atoi(p2+1);
-
-    s = p2; s++;
-    memset( temp_buf, 0, sizeof(temp_buf) );
-    if (*p == '0') {
-        p1++; s = temp_buf; i = 0;
-        while( p1 != p2) {
-            *s++ = *p1++;
-            if (i > (sizeof(temp_buf)-1)) break;
+    mantissa = mcode & MANTISSA;
+    exp_d = 0;
+    n = 0;
+    if (mantissa != 0)
+        n = dec_exact_digits( mantissa, (int)((mcode & EXPONENT) >> BITS_36) - M20_MANTISSA_SHIFT - BITS_36,
+                              digits, &exp_d );
+
+    /* round to 10 significant digits */
+    if (n > 10) {
+        round_up = 0;
+        if (digits[10] > '5') round_up = 1;
+        else if (digits[10] == '5') {
+            for( i=11; i<n; i++ ) if (digits[i] != '0') break;
+            if (i < n) round_up = 1;
+            else round_up = (digits[9] - '0') & 1;
         }
-    }
-    else {
-        s = temp_buf;
-        *s++ = *p; exp_d++;
-        p1++;
-        i=1;
-        while( p1 != p2) {
-            *s++ = *p1++; i++;
-            if (i > (sizeof(temp_buf)-1)) break;
+        if (round_up) {
+            for( i=9; i>=0; i-- ) {
+                if (digits[i] != '9') { digits[i]++; break; }
+                digits[i] = '0';
+            }
+            if (i < 0) { digits[0] = '1'; exp_d++; }
         }
     }
-    temp_buf[9] = '\0';
+    for( i=n; i<9; i++ ) digits[i] = '0';
 
-    p_d_values->exponent_value = exp_d;
-    sign = 0;
-    if (exp_d >= 0) sign = 1; 
-    p_d_values->exp_sign = sign;
+    for( i=0; i<9; i++ ) p_d_values->mantissa_array[i] = digits[i];
+    p_d_values->mantissa_array[9] = '\0';
 
-    strncpy( p_d_values->mantissa_array, temp_buf, 32-1 );
+    p_d_values->exponent_value = exp_d;
+    p_d_values->exp_sign = (exp_d >= 0) ? 1 : 0;
 
     return SCPE_OK;
 }
 
 
 
+/*
+ *  Print 2-digit absolute value of decimal exponent
+ */
+t_stat  output_lp_exponent( int exp_d )
+{
+    char  buf[3];
+
+    if (exp_d < 0) exp_d = -exp_d;
+    buf[0] = (char)('0' + (exp_d / 10) % 10);
+    buf[1] = (char)('0' + exp_d % 10);
+    buf[2] = '\0';
+
+    return output_lp_line(buf);
+}
+
+
+
 t_stat  output_m20_type_0( t_value  mcode )
 {
     t_stat   err;
@@ -269,11 +358,9 @@ t_stat  output_m20_type_0( t_value  mcode )
     if (err) return err;
     err = output_lp_char (dp_values.exp_sign & 1 ? '0' : '1');
     if (err) return err;
-    _snprintf (lbuf,sizeof(lbuf),"%02u", abs(dp_values.exponent_value));
-    err = output_lp_line(lbuf);
+    err = output_lp_exponent(dp_values.exponent_value);
     if (err) return err;
-    _snprintf (lbuf,sizeof(lbuf),"%s", dp_values.mantissa_array);
-    err = output_lp_line(lbuf);
+    err = output_lp_line(dp_values.mantissa_array);
     if (err) return err;
 
     err = output_lp_line(cr_lf_str);
@@ -299,11 +386,9 @@ t_stat  output_m20_type_1( t_value  mcode )
     if (err) return err;
     err = output_lp_char (dp_values.exp_sign & 1 ? '+' : '-');
     if (err) return err;
-    _snprintf (lbuf,sizeof(lbuf),"%02u", abs(dp_values.exponent_value));
-    err = output_lp_line(lbuf);
+    err = output_lp_exponent(dp_values.exponent_value);
     if (err) return err;
-    _snprintf (lbuf,sizeof(lbuf),"%s", dp_values.mantissa_array);
-    err = output_lp_line(lbuf);
+    err = output_lp_line(dp_values.mantissa_array);
     if (err) return err;
 
     err = output_lp_line(cr_lf_str);
@@ -330,15 +415,13 @@ t_stat  output_m20_type_2( t_value  mcode )
     if (err) return err;
     err = output_lp_char (dp_values.num_sign ? '+' : '-');
     if (err) return err;
-    _snprintf (lbuf,sizeof(lbuf),"%s", dp_values.mantissa_array);
-    err = output_lp_line(lbuf);
+    err = output_lp_line(dp_values.mantissa_array);
     if (err) return err;
     err = output_lp_char (' ');
     if (err) return err;
     err = output_lp_char (dp_values.exp_sign & 1 ? '+' : '-');
     if (err) return err;
-    _snprintf (lbuf,sizeof(lbuf),"%02u", abs(dp_values.exponent_value));
-    err = output_lp_line(lbuf);
+    err = output_lp_exponent(dp_values.exponent_value);
     if (err) return err;
 
     /* user-friendly M-20 print style */
@@ -380,15 +463,13 @@ t_stat  output_m20_type_3( t_value  mcode )
     if (err) return err;
     err = output_lp_char (dp_values.num_sign ? '+' : '-');
     if (err) return err;
-    _snprintf (lbuf,sizeof(lbuf),"%s", dp_values.mantissa_array);
-    err = output_lp_line(lbuf);
+    err = output_lp_line(dp_values.mantissa_array);
     if (err) return err;
     err = output_lp_char (' ');
     if (err) return err;
     err = output_lp_char (dp_values.exp_sign & 1 ? '+' : '-');
     if (err) return err;
-    _snprintf (lbuf,sizeof(lbuf),"%02u", abs(dp_values.exponent_value));
-    err = output_lp_line(lbuf);
+    err = output_lp_exponent(dp_values.exponent_value);
     if (err) return err;
 
     /* user-friendly M-20 print style */
@@ -0,0 +1,525 @@
+/*
+ * File:     m20_mem.c
+ * Purpose:  M-20 simulator in-memory files for device attachments
+ *
+ * Copyright (c) 2026, Dmitry Stefankov
+ *
+ * $Id$
+ *
+ * Memory files are named buffers which can be attached to any unit
+ * instead of host file:  ATTACH CDR mem:deck,  ATTACH LPT mem:print.
+ * Input decks, drum and tape images are supplied by m20_mem_put()
+ * (or MEMFILE LOAD), printer and punch output is collected into
+ * growable buffers and read by m20_mem_get() (or MEMFILE SAVE).
+ *
+ * Units work with usual stdio FILE, which is built on buffer with
+ * fopencookie() (glibc) or funopen() (BSD, macOS). On other hosts
+ * buffer is copied to tmpfile() on attach and back on detach.
+ *
+ * Attach switches:  -N  new (empty) buffer,  -R  read only (buffer must
+ * exist),  -E  buffer must exist,  -A  append (sequential units).
+ *
+ * Commands:
+ *   MEMFILE LOAD name file          copy host file into buffer
+ *   MEMFILE SAVE name file          write buffer into host file
+ *   MEMFILE FREE name|ALL           delete buffer(s)
+ *   MEMFILE SHOW                    list buffers
+ *
+ * Revision History.
+ *
+ *  19-Oct-2026  DVS  Initial Implementation
+ *  19-Oct-2026  DVS  Added m20_mem_fclose() for libm20
+ *
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE     1               /* fopencookie() */
+#endif
+
+#include "m20_defs.h"
+
+#if defined(__GLIBC__)
+#define M20_MEM_COOKIE  1
+#elif defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || defined(__APPLE__)
+#define M20_MEM_FUNOPEN 1
+#endif
+
+
+#define M20_MEM_PREFIX      "mem:"
+#define M20_MEM_PREFIX_LEN  4
+#define M20_MEM_INIT_SIZE   4096
+
+
+/* Named memory buffer */
+typedef struct m20_mem_buf {
+    struct m20_mem_buf * next;
+    unsigned char *  data;
+    size_t           size;              /* bytes used */
+    size_t           alloc;             /* bytes allocated */
+    int              opened;            /* open files count */
+    char             name[1];
+} M20_MEM_BUF, *PM20_MEM_BUF;
+
+/* Open file on memory buffer */
+typedef struct m20_mem_file {
+    struct m20_mem_file * next;
+    PM20_MEM_BUF     buf;
+    FILE *           fp;
+    size_t           pos;
+    int              read_only;
+} M20_MEM_FILE, *PM20_MEM_FILE;
+
+static PM20_MEM_BUF   mem_bufs = NULL;
+static PM20_MEM_FILE  mem_files = NULL;
+
+
+
+/*
+ *  Search buffer by name (case-insensitive)
+ */
+static PM20_MEM_BUF m20_mem_find (const char * name)
+{
+    PM20_MEM_BUF  mb;
+
+    for (mb = mem_bufs; mb != NULL; mb = mb->next)
+        if (strcasecmp (mb->name, name) == 0) return mb;
+    return NULL;
+}
+
+
+static PM20_MEM_BUF m20_mem_create (const char * name)
+{
+    PM20_MEM_BUF  mb;
+
+    mb = m20_mem_find (name);
+    if (mb != NULL) return mb;
+
+    mb = (PM20_MEM_BUF) calloc (1, sizeof(M20_MEM_BUF) + strlen(name));
+    if (mb == NULL) return NULL;
+    strcpy (mb->name, name);
+    mb->next = mem_bufs;
+    mem_bufs = mb;
+    return mb;
+}
+
+
+static int m20_mem_reserve (PM20_MEM_BUF mb, size_t size)
+{
+    unsigned char * p;
+    size_t  n;
+
+    if (size <= mb->alloc) return 0;
+    n = (mb->alloc == 0) ? M20_MEM_INIT_SIZE : mb->alloc;
+    while (n < size) n *= 2;
+    p = (unsigned char *) realloc (mb->data, n);
+    if (p == NULL) return -1;
+    memset (p + mb->alloc, 0, n - mb->alloc);
+    mb->data = p;
+    mb->alloc = n;
+    return 0;
+}
+
+
+/* flush stdio buffers of files opened on buffer */
+static void m20_mem_flush (PM20_MEM_BUF mb)
+{
+    PM20_MEM_FILE  mf;
+
+    for (mf = mem_files; mf != NULL; mf = mf->next)
+        if ((mf->buf == mb) && (mf->fp != NULL)) fflush (mf->fp);
+}
+
+
+
+/*
+ *  Embedding interface: put input data, get output data, free buffers
+ */
+t_stat m20_mem_put (const char * name, const void * data, size_t size)
+{
+    PM20_MEM_BUF  mb;
+
+    mb = m20_mem_create (name);
+    if (mb == NULL) return SCPE_MEM;
+    if (mb->opened) return SCPE_ALATT;
+    if (m20_mem_reserve (mb, size) != 0) return SCPE_MEM;
+    if (size > 0) memcpy (mb->data, data, size);
+    mb->size = size;
+    return SCPE_OK;
+}
+
+
+const void * m20_mem_get (const char * name, size_t * size)
+{
+    PM20_MEM_BUF  mb;
+
+    mb = m20_mem_find (name);
+    if (mb == NULL) return NULL;
+    m20_mem_flush (mb);
+    if (size != NULL) *size = mb->size;
+    return (mb->data != NULL) ? (const void *) mb->data : (const void *) "";
+}
+
+
+t_stat m20_mem_free (const char * name)
+{
+    PM20_MEM_BUF  mb, *pp;
+
+    for (pp = &mem_bufs; (mb = *pp) != NULL; pp = &mb->next) {
+        if (strcasecmp (mb->name, name) != 0) continue;
+        if (mb->opened) return SCPE_ALATT;
+        *pp = mb->next;
+        free (mb->data);
+        free (mb);
+        return SCPE_OK;
+    }
+    return SCPE_NOATT;
+}
+
+
+void m20_mem_free_all (void)
+{
+    PM20_MEM_BUF  mb, next, *pp;
+
+    pp = &mem_bufs;
+    for (mb = mem_bufs; mb != NULL; mb = next) {
+        next = mb->next;
+        if (mb->opened) {
+            pp = &mb->next;
+            continue;
+        }
+        *pp = next;
+        free (mb->data);
+        free (mb);
+    }
+}
+
+
+
+/*
+ *  stdio functions on memory buffer
+ */
+static long m20_mem_do_read (PM20_MEM_FILE mf, char * buf, size_t size)
+{
+    PM20_MEM_BUF  mb = mf->buf;
+
+    if (mf->pos >= mb->size) return 0;
+    if (size > mb->size - mf->pos) size = mb->size - mf->pos;
+    memcpy (buf, mb->data + mf->pos, size);
+    mf->pos += size;
+    return (long) size;
+}
+
+
+static long m20_mem_do_write (PM20_MEM_FILE mf, const char * buf, size_t size)
+{
+    PM20_MEM_BUF  mb = mf->buf;
+
+    if (mf->read_only) return -1;
+    if (m20_mem_reserve (mb, mf->pos + size) != 0) return -1;
+    memcpy (mb->data + mf->pos, buf, size);
+    mf->pos += size;
+    if (mf->pos > mb->size) mb->size = mf->pos;
+    return (long) size;
+}
+
+
+static int m20_mem_do_seek (PM20_MEM_FILE mf, t_int64 * offset, int whence)
+{
+    t_int64  pos;
+
+    switch (whence) {
+        case SEEK_SET: pos = *offset;                          break;
+        case SEEK_CUR: pos = (t_int64) mf->pos + *offset;      break;
+        case SEEK_END: pos = (t_int64) mf->buf->size + *offset; break;
+        default:       return -1;
+    }
+    if (pos < 0) return -1;
+    mf->pos = (size_t) pos;
+    *offset = pos;
+    return 0;
+}
+
+
+static int m20_mem_do_close (PM20_MEM_FILE mf)
+{
+    PM20_MEM_FILE  *pp;
+
+    for (pp = &mem_files; *pp != NULL; pp = &(*pp)->next)
+        if (*pp == mf) {
+            *pp = mf->next;
+            break;
+        }
+    mf->buf->opened--;
+    free (mf);
+    return 0;
+}
+
+
+#if defined(M20_MEM_COOKIE)
+
+static ssize_t m20_mem_cookie_read (void * cookie, char * buf, size_t size)
+{
+    return m20_mem_do_read ((PM20_MEM_FILE) cookie, buf, size);
+}
+
+static ssize_t m20_mem_cookie_write (void * cookie, const char * buf, size_t size)
+{
+    return m20_mem_do_write ((PM20_MEM_FILE) cookie, buf, size);
+}
+
+static int m20_mem_cookie_seek (void * cookie, off64_t * offset, int whence)
+{
+    t_int64  pos = *offset;
+
+    if (m20_mem_do_seek ((PM20_MEM_FILE) cookie, &pos, whence) != 0) return -1;
+    *offset = pos;
+    return 0;
+}
+
+static int m20_mem_cookie_close (void * cookie)
+{
+    return m20_mem_do_close ((PM20_MEM_FILE) cookie);
+}
+
+#elif defined(M20_MEM_FUNOPEN)
+
+static int m20_mem_funopen_read (void * cookie, char * buf, int size)
+{
+    return (int) m20_mem_do_read ((PM20_MEM_FILE) cookie, buf, size);
+}
+
+static int m20_mem_funopen_write (void * cookie, const char * buf, int size)
+{
+    return (int) m20_mem_do_write ((PM20_MEM_FILE) cookie, buf, size);
+}
+
+static fpos_t m20_mem_funopen_seek (void * cookie, fpos_t offset, int whence)
+{
+    t_int64  pos = offset;
+
+    if (m20_mem_do_seek ((PM20_MEM_FILE) cookie, &pos, whence) != 0) return -1;
+    return (fpos_t) pos;
+}
+
+static int m20_mem_funopen_close (void * cookie)
+{
+    return m20_mem_do_close ((PM20_MEM_FILE) cookie);
+}
+
+#endif
+
+
+
+/*
+ *  Open stdio file on memory buffer
+ */
+FILE * m20_mem_fopen (const char * name, int read_only, int create)
+{
+    PM20_MEM_BUF   mb;
+    PM20_MEM_FILE  mf;
+
+    mb = create ? m20_mem_create (name) : m20_mem_find (name);
+    if (mb == NULL) return NULL;
+
+    mf = (PM20_MEM_FILE) calloc (1, sizeof(M20_MEM_FILE));
+    if (mf == NULL) return NULL;
+    mf->buf = mb;
+    mf->read_only = read_only;
+
+#if defined(M20_MEM_COOKIE)
+    {
+    cookie_io_functions_t  io;
+
+    io.read  = m20_mem_cookie_read;
+    io.write = m20_mem_cookie_write;
+    io.seek  = m20_mem_cookie_seek;
+    io.close = m20_mem_cookie_close;
+    mf->fp = fopencookie (mf, read_only ? "rb" : "rb+", io);
+    }
+#elif defined(M20_MEM_FUNOPEN)
+    mf->fp = funopen (mf, m20_mem_funopen_read, m20_mem_funopen_write,
+                      m20_mem_funopen_seek, m20_mem_funopen_close);
+#else
+    /* no custom streams: work on temporary file, copy back at detach */
+    mf->fp = tmpfile ();
+    if ((mf->fp != NULL) && (mb->size > 0)) {
+        if (fwrite (mb->data, 1, mb->size, mf->fp) != mb->size) {
+            fclose (mf->fp);
+            mf->fp = NULL;
+        }
+        else rewind (mf->fp);
+    }
+#endif
+
+    if (mf->fp == NULL) {
+        free (mf);
+        return NULL;
+    }
+    mb->opened++;
+    mf->next = mem_files;
+    mem_files = mf;
+    return mf->fp;
+}
+
+
+/*
+ *  Prepare memory file for close (copy temporary file back into buffer)
+ */
+static void m20_mem_fclose_prepare (FILE * fp)
+{
+#if !defined(M20_MEM_COOKIE) && !defined(M20_MEM_FUNOPEN)
+    PM20_MEM_FILE  mf;
+    long  size;
+
+    for (mf = mem_files; mf != NULL; mf = mf->next)
+        if (mf->fp == fp) break;
+    if (mf == NULL) return;
+
+    if (!mf->read_only) {
+        fflush (fp);
+        fseek (fp, 0, SEEK_END);
+        size = ftell (fp);
+        rewind (fp);
+        if ((size >= 0) && (m20_mem_reserve (mf->buf, (size_t) size) == 0))
+            mf->buf->size = fread (mf->buf->data, 1, (size_t) size, fp);
+    }
+    mf->fp = NULL;
+    m20_mem_do_close (mf);
+#endif
+}
+
+
+int m20_mem_fclose (FILE * fp)
+{
+    m20_mem_fclose_prepare (fp);
+    return fclose (fp);
+}
+
+
+
+/*
+ *  Attach unit to host file or memory buffer (mem:name)
+ */
+t_stat m20_attach_unit (UNIT * uptr, CONST char * cptr)
+{
+    const char * name;
+    int  read_only, create;
+
+    if (strncasecmp (cptr, M20_MEM_PREFIX, M20_MEM_PREFIX_LEN) != 0)
+        return attach_unit (uptr, cptr);
+
+    name = cptr + M20_MEM_PREFIX_LEN;
+    if (*name == '\0') return SCPE_ARG;
+    if (!(uptr->flags & UNIT_ATTABLE)) return SCPE_NOATT;
+
+    read_only = (sim_switches & SWMASK ('R')) || (uptr->flags & UNIT_RO);
+    if (read_only && !(uptr->flags & (UNIT_ROABLE | UNIT_RO))) return SCPE_NORO;
+    create = !read_only && !(sim_switches & SWMASK ('E'));
+
+    if ((sim_switches & SWMASK ('N')) && !read_only) {
+        if (m20_mem_put (name, NULL, 0) != SCPE_OK) return SCPE_OPENERR;
+    }
+
+    uptr->filename = (char *) calloc (CBUFSIZE, sizeof (char));
+    if (uptr->filename == NULL) return SCPE_MEM;
+    strlcpy (uptr->filename, cptr, CBUFSIZE);
+
+    uptr->fileref = m20_mem_fopen (name, read_only, create);
+    if (uptr->fileref == NULL) {
+        free (uptr->filename);
+        uptr->filename = NULL;
+        return SCPE_OPENERR;
+    }
+    if (read_only) uptr->flags |= UNIT_RO;
+    uptr->flags |= UNIT_ATT;
+    uptr->pos = 0;
+    if ((sim_switches & SWMASK ('A')) && (uptr->flags & UNIT_SEQ) &&
+        (fseek (uptr->fileref, 0, SEEK_END) == 0))
+        uptr->pos = (t_addr) ftell (uptr->fileref);
+
+    return SCPE_OK;
+}
+
+
+t_stat m20_detach_unit (UNIT * uptr)
+{
+    if ((uptr->flags & UNIT_ATT) && (uptr->fileref != NULL) && (uptr->filename != NULL) &&
+        (strncasecmp (uptr->filename, M20_MEM_PREFIX, M20_MEM_PREFIX_LEN) == 0))
+        m20_mem_fclose_prepare (uptr->fileref);
+
+    return detach_unit (uptr);
+}
+
+
+
+/*
+ *  MEMFILE command
+ */
+t_stat m20_mem_cmd (int32 flag, CONST char * cptr)
+{
+    char  gbuf[CBUFSIZE], nbuf[CBUFSIZE], fbuf[CBUFSIZE];
+    PM20_MEM_BUF  mb;
+    FILE *  fp;
+    long    size;
+    t_stat  r;
+
+    cptr = get_glyph (cptr, gbuf, 0);
+
+    if (strcmp (gbuf, "SHOW") == 0 || gbuf[0] == '\0') {
+        for (mb = mem_bufs; mb != NULL; mb = mb->next) {
+            m20_mem_flush (mb);
+            sim_printf ("%-24s %10lu bytes%s\n", mb->name, (unsigned long) mb->size,
+                        mb->opened ? "  (attached)" : "");
+        }
+        return SCPE_OK;
+    }
+
+    cptr = get_glyph_nc (cptr, nbuf, 0);
+    if (nbuf[0] == '\0') return SCPE_2FARG;
+
+    if (strcmp (gbuf, "FREE") == 0) {
+        if (strcasecmp (nbuf, "ALL") == 0) {
+            m20_mem_free_all ();
+            return SCPE_OK;
+        }
+        return m20_mem_free (nbuf);
+    }
+
+    cptr = get_glyph_nc (cptr, fbuf, 0);
+    if (fbuf[0] == '\0') return SCPE_2FARG;
+
+    if (strcmp (gbuf, "LOAD") == 0) {
+        unsigned char * data;
+
+        fp = sim_fopen (fbuf, "rb");
+        if (fp == NULL) return SCPE_OPENERR;
+        fseek (fp, 0, SEEK_END);
+        size = ftell (fp);
+        rewind (fp);
+        data = (unsigned char *) malloc (size > 0 ? size : 1);
+        if (data == NULL) {
+            fclose (fp);
+            return SCPE_MEM;
+        }
+        size = (long) fread (data, 1, size, fp);
+        fclose (fp);
+        r = m20_mem_put (nbuf, data, size);
+        free (data);
+        return r;
+    }
+
+    if (strcmp (gbuf, "SAVE") == 0) {
+        const void * data;
+        size_t  n;
+
+        data = m20_mem_get (nbuf, &n);
+        if (data == NULL) return sim_messagef (SCPE_ARG, "No memory file %s\n", nbuf);
+        fp = sim_fopen (fbuf, "wb");
+        if (fp == NULL) return SCPE_OPENERR;
+        if (n > 0) fwrite (data, 1, n, fp);
+        fclose (fp);
+        return SCPE_OK;
+    }
+
+    return sim_messagef (SCPE_NOFNC, "Unknown MEMFILE command: %s\n", gbuf);
+}
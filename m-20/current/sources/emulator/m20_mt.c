@@ -6,6 +6,13 @@
  *
  * $Id$
  *
+ * Tape image is a flat file of zones (header word, data, checksum), or a
+ * compressed container (see m20_defs.h) created by ATTACH -C on a new
+ * (empty) file and recognized by magic on attach.  Container is decoded
+ * into temporary file on attach and coded back on detach.  Zone directory
+ * is used by read and write to seek to wanted zone without reading of all
+ * zones before it (not used with MT debugging, trace shows every zone).
+ *
  * Revision History.
  *
  *  10-Nov-2014  DVS  Initial Implemementation
@@ -22,6 +29,8 @@
  *  08-Mar-2015  DVS  Added more checksum control logic
  *                    Added tape read/write data dump debugging option
  *  13-Mar-2015  DVS  Cleanup code
+ *  19-Oct-2026  DVS  Added in-memory attachments (mem:name)
+ *  19-Oct-2026  DVS  Added compressed tape container, zone directory
  *
  */
 
@@ -36,6 +45,9 @@ t_stat mt_svc (UNIT *uptr);
 t_stat mt_reset (DEVICE *dptr);
 t_stat mt_attach (UNIT *uptr, char *cptr);
 t_stat mt_detach (UNIT *uptr);
+t_stat mt_show_format (FILE *st, UNIT *uptr, int32 val, CONST void *desc);
+static t_stat mt_cont_open (UNIT *uptr, int create);
+static t_stat mt_cont_save (UNIT *uptr);
 
 static int tape_auto_skip_zero_address = 1;
 static int tape_map_check = 1;
@@ -87,6 +99,7 @@ REG mt_reg[] = {
 };
 
 MTAB mt_mod[] = {
+	{ MTAB_XTD|MTAB_VUN|MTAB_NMO, 0, "FORMAT", NULL, NULL, &mt_show_format, NULL, "tape image format" },
 	{ 0 }
 };
 
@@ -106,6 +119,8 @@ extern t_value mosu_load (int addr);
 extern void mosu_store (int addr, t_value val);
 
 extern t_value  cyclic_checksum( t_value x, t_value y);
+extern t_stat m20_attach_unit (UNIT *uptr, CONST char *cptr);
+extern t_stat m20_detach_unit (UNIT *uptr);
 
 /*
  * Parameter of external device data movement
@@ -124,6 +139,32 @@ extern int ext_io_ram_chksum;           /* MOSU_CHK - memory address for checksu
 static t_value  temp_zone_buf[MAX_TAPE_ZONE_SIZE+1];
 
 
+/* zone directory and compressed container */
+typedef  struct mt_zone {
+    int      num;				/* zone number */
+    int      size;				/* zone data words */
+    long     pos;				/* tape word of zone header */
+} MT_ZONE;
+
+#define  MT_DIR_SIZE      (MAX_TAPE_SIZE/3+1)
+
+#define  MT_DIR_NONE      0			/* not built */
+#define  MT_DIR_WHOLE     1			/* all tape */
+#define  MT_DIR_PART      2			/* irregular data after last zone */
+
+typedef  struct mt_image {
+    int      cont;				/* compressed container attached */
+    int      dirty;				/* tape changed since attach */
+    FILE *   cfile;				/* container (unit works on decoded copy) */
+    int      state;				/* directory state */
+    int      nzones;
+    long     end;				/* tape word after last zone */
+    MT_ZONE  dir[MT_DIR_SIZE];
+} MT_IMAGE;
+
+static  MT_IMAGE  mt_image[MAX_TAPES_COUNT];
+
+
 
 /*
  *  Event: tape service finally
@@ -164,7 +205,12 @@ t_stat mt_attach (UNIT *uptr, char *cptr)
 
     sim_cancel(uptr);				           /* cancel current IO */
    
-    s = attach_unit (uptr, cptr);
+    s = m20_attach_unit (uptr, cptr);
+
+    if (s == SCPE_OK) {
+        s = mt_cont_open (uptr, (sim_switches & SWMASK ('C')) != 0);
+        if (s != SCPE_OK) m20_detach_unit (uptr);
+    }
 
     if (sim_deb && mt_dev.dctrl) fprintf (sim_deb, "mt: mt_attach(..), name='%s' res=%d\n", cptr, s);
 
@@ -178,12 +224,348 @@ t_stat mt_attach (UNIT *uptr, char *cptr)
  */
 t_stat mt_detach (UNIT *uptr)
 {
+    MT_IMAGE * mi = &mt_image[uptr - mt_unit];
+    t_stat r = SCPE_OK, s;
 
     if (sim_deb && mt_dev.dctrl) fprintf (sim_deb, "mt: mt_detach(..)\n");
 
     sim_cancel(uptr);
 
-    return detach_unit (uptr);
+    if ((uptr->flags & UNIT_ATT) && mi->cont) {
+        if (mi->dirty && !(uptr->flags & UNIT_RO)) r = mt_cont_save (uptr);
+        fclose (uptr->fileref);
+        uptr->fileref = mi->cfile;
+        mi->cfile = NULL;
+        mi->cont = 0;
+    }
+    mi->state = MT_DIR_NONE;
+
+    s = m20_detach_unit (uptr);
+    return (r != SCPE_OK) ? r : s;
+}
+
+
+
+/*
+ *  Build zone directory of tape (header words only are read)
+ */
+static void mt_dir_build (int mt_no)
+{
+    MT_IMAGE * mi = &mt_image[mt_no];
+    FILE * f = mt_unit[mt_no].fileref;
+    t_value  hdr;
+    long  len, pos = 0;
+    int   size;
+
+    mi->nzones = 0;
+    mi->end = 0;
+    mi->state = MT_DIR_PART;
+    if (fseek (f, 0, SEEK_END)) return;
+    len = ftell (f);
+
+    while ((pos+1)*(long)sizeof(t_value) <= len) {
+        if (fseek (f, pos*sizeof(t_value), SEEK_SET)) break;
+        if (fxread (&hdr, sizeof(t_value), 1, f) != 1) break;
+        size = (int)(hdr >> BITS_32);
+        if ((size < 0) || (size > MAX_TAPE_ZONE_SIZE)) break;
+        if ((pos+size+2)*(long)sizeof(t_value) > len) break;
+        if (mi->nzones >= MT_DIR_SIZE) break;
+        mi->dir[mi->nzones].num = hdr & 0xFFFFFFF;
+        mi->dir[mi->nzones].size = size;
+        mi->dir[mi->nzones].pos = pos;
+        mi->nzones++;
+        pos += size+2;
+    }
+    mi->end = pos;
+    if (pos*(long)sizeof(t_value) == len) mi->state = MT_DIR_WHOLE;
+}
+
+
+
+/*
+ *  Tape word to start zone search from.  Zones before first zone with
+ *  number >= wanted are skipped, search stops on this zone as on tape.
+ */
+static long mt_dir_find (int mt_no, int user_zone_num)
+{
+    MT_IMAGE * mi = &mt_image[mt_no];
+    int  i;
+
+    if (sim_deb && mt_dev.dctrl) return 0;
+
+    if (mi->state == MT_DIR_NONE) mt_dir_build (mt_no);
+    for (i = 0; i < mi->nzones; i++) {
+        if (mi->dir[i].num >= user_zone_num) return mi->dir[i].pos;
+    }
+    return mi->end;
+}
+
+
+
+/*
+ *  Show tape image format
+ */
+t_stat mt_show_format (FILE *st, UNIT *uptr, int32 val, CONST void *desc)
+{
+    MT_IMAGE * mi = &mt_image[uptr - mt_unit];
+
+    if (!(uptr->flags & UNIT_ATT)) {
+        fprintf (st, "not attached\n");
+        return SCPE_OK;
+    }
+    if (mi->state == MT_DIR_NONE) mt_dir_build (uptr - mt_unit);
+    fprintf (st, "%s, %d zones", mi->cont ? "compressed container" : "flat image", mi->nzones);
+    if (mi->state == MT_DIR_PART) fprintf (st, ", irregular data at word %ld", mi->end);
+    fprintf (st, "\n");
+    return SCPE_OK;
+}
+
+
+
+/*
+ *  Write words of zone as runs of container
+ */
+static void mt_cont_put_runs (FILE *f, t_value *w, long n)
+{
+    long  i = 0, r, l;
+    t_value  ctl;
+
+    while (i < n) {
+        for (r = 1; (i+r < n) && (w[i+r] == w[i]); r++) ;
+        if (r >= MT_CONT_MIN_REPEAT) {
+            ctl = ((t_value)MT_CONT_REPEAT << BITS_32) | (t_value)r;
+            fxwrite (&ctl, sizeof(t_value), 1, f);
+            fxwrite (&w[i], sizeof(t_value), 1, f);
+            i += r;
+            continue;
+        }
+        for (l = i+1; l < n; l++) {			/* literal up to next repeat */
+            if ((l+2 < n) && (w[l] == w[l+1]) && (w[l] == w[l+2])) break;
+        }
+        ctl = ((t_value)MT_CONT_LITERAL << BITS_32) | (t_value)(l-i);
+        fxwrite (&ctl, sizeof(t_value), 1, f);
+        fxwrite (&w[i], sizeof(t_value), l-i, f);
+        i = l;
+    }
+}
+
+
+
+/*
+ *  Read n words coded as runs of container
+ */
+static t_stat mt_cont_get_runs (FILE *f, t_value *w, long n)
+{
+    long  i = 0, cnt, j;
+    t_value  ctl;
+
+    while (i < n) {
+        if (fxread (&ctl, sizeof(t_value), 1, f) != 1) return SCPE_FMT;
+        cnt = (long)(ctl & 0xFFFFFFFF);
+        if ((cnt <= 0) || (cnt > n-i)) return SCPE_FMT;
+        switch ((int)(ctl >> BITS_32)) {
+          case MT_CONT_REPEAT:
+            if (fxread (&w[i], sizeof(t_value), 1, f) != 1) return SCPE_FMT;
+            for (j = 1; j < cnt; j++) w[i+j] = w[i];
+            break;
+          case MT_CONT_LITERAL:
+            if (fxread (&w[i], sizeof(t_value), cnt, f) != (size_t)cnt) return SCPE_FMT;
+            break;
+          default:
+            return SCPE_FMT;
+        }
+        i += cnt;
+    }
+    return SCPE_OK;
+}
+
+
+
+/*
+ *  Decode container into (temporary) flat tape file, fill zone directory
+ */
+static t_stat mt_cont_load (FILE *f, FILE *tf, MT_IMAGE *mi)
+{
+    t_value  hdr[MT_CONT_HDR_WORDS-1];
+    t_value *words = NULL, *dir = NULL;
+    long  nwords, ndir, i, pos = 0;
+    t_stat r = SCPE_FMT;
+
+    if ((fxread (hdr, sizeof(t_value), MT_CONT_HDR_WORDS-1, f) != MT_CONT_HDR_WORDS-1) ||
+        (hdr[0] != MT_CONT_VERSION))
+        return SCPE_FMT;
+    nwords = (long)hdr[1];
+    ndir = (long)hdr[2];
+    if ((nwords < 0) || (ndir < 0) || (ndir > nwords)) return SCPE_FMT;
+
+    words = (t_value *) malloc ((nwords+1)*sizeof(t_value));
+    dir = (t_value *) malloc ((ndir*MT_CONT_DIR_WORDS+1)*sizeof(t_value));
+    if ((words == NULL) || (dir == NULL)) {
+        r = SCPE_MEM;
+        goto done;
+    }
+    if (fseek (f, (long)hdr[3], SEEK_SET) ||
+        (fxread (dir, sizeof(t_value), ndir*MT_CONT_DIR_WORDS, f) != (size_t)(ndir*MT_CONT_DIR_WORDS)))
+        goto done;
+
+    mi->nzones = 0;
+    for (i = 0; i < ndir; i++) {
+        t_value * e = &dir[i*MT_CONT_DIR_WORDS];
+        if (((long)e[1] != pos) || ((long)e[2] > nwords-pos)) goto done;
+        if (fseek (f, (long)e[3], SEEK_SET)) goto done;
+        if (mt_cont_get_runs (f, &words[pos], (long)e[2]) != SCPE_OK) goto done;
+        if ((e[0] != MT_CONT_TAIL) && (mi->nzones < MT_DIR_SIZE)) {
+            mi->dir[mi->nzones].num = e[0] & 0xFFFFFFF;
+            mi->dir[mi->nzones].size = (int)(e[0] >> BITS_32);
+            mi->dir[mi->nzones].pos = pos;
+            mi->nzones++;
+            mi->end = pos + (long)e[2];
+        }
+        pos += (long)e[2];
+    }
+    if (pos != nwords) goto done;
+
+    if (fxwrite (words, sizeof(t_value), nwords, tf) != (size_t)nwords) {
+        r = SCPE_IOERR;
+        goto done;
+    }
+    if (mi->end == nwords) mi->state = MT_DIR_WHOLE;
+    else mi->state = MT_DIR_PART;
+    r = SCPE_OK;
+
+  done:
+    free (words);
+    free (dir);
+    return r;
+}
+
+
+
+/*
+ *  Compressed container:  recognize on attach or create on new file (-C)
+ */
+static t_stat mt_cont_open (UNIT *uptr, int create)
+{
+    MT_IMAGE * mi = &mt_image[uptr - mt_unit];
+    FILE * f = uptr->fileref;
+    FILE * tf;
+    char   magic[8];
+    size_t n;
+    int    is_cont;
+    t_stat r;
+
+    mi->cont = 0;
+    mi->dirty = 0;
+    mi->cfile = NULL;
+    mi->state = MT_DIR_NONE;
+    mi->nzones = 0;
+    mi->end = 0;
+
+    if (fseek (f, 0, SEEK_SET)) return SCPE_IOERR;
+    n = fread (magic, 1, sizeof(magic), f);
+    is_cont = (n == sizeof(magic)) && (memcmp (magic, MT_CONT_MAGIC, sizeof(magic)) == 0);
+    if (!is_cont) {
+        if (!create) return SCPE_OK;			/* flat image */
+        if (n != 0) {
+            sim_printf ("Tape image is not empty, convert it by dump_mt -c\n");
+            return SCPE_ARG;
+        }
+        if (uptr->flags & UNIT_RO) return SCPE_RO;
+    }
+
+    tf = tmpfile ();
+    if (tf == NULL) return SCPE_OPENERR;
+    if (is_cont) {
+        r = mt_cont_load (f, tf, mi);
+        if (r != SCPE_OK) {
+            fclose (tf);
+            mi->state = MT_DIR_NONE;
+            return r;
+        }
+    }
+    else mi->state = MT_DIR_WHOLE;			/* empty tape */
+
+    mi->cfile = f;
+    mi->cont = 1;
+    mi->dirty = !is_cont;
+    uptr->fileref = tf;
+    return SCPE_OK;
+}
+
+
+
+/*
+ *  Code tape back into container (on detach)
+ */
+static t_stat mt_cont_save (UNIT *uptr)
+{
+    MT_IMAGE * mi = &mt_image[uptr - mt_unit];
+    FILE * tf = uptr->fileref;
+    FILE * f = mi->cfile;
+    t_value  hdr[MT_CONT_HDR_WORDS-1];
+    t_value *words, *dir;
+    long  len, nwords, ndir = 0, pos = 0, n;
+    int   size;
+    t_stat r = SCPE_OK;
+
+    if (fseek (tf, 0, SEEK_END)) return SCPE_IOERR;
+    len = ftell (tf);
+    nwords = len / (long)sizeof(t_value);
+    words = (t_value *) malloc ((nwords+1)*sizeof(t_value));
+    dir = (t_value *) malloc ((nwords+1)*MT_CONT_DIR_WORDS*sizeof(t_value));
+    if ((words == NULL) || (dir == NULL)) {
+        free (words);
+        free (dir);
+        return SCPE_MEM;
+    }
+    if (fseek (tf, 0, SEEK_SET) || (fxread (words, sizeof(t_value), nwords, tf) != (size_t)nwords)) {
+        r = SCPE_IOERR;
+        goto done;
+    }
+
+    memset (hdr, 0, sizeof(hdr));
+    if (fseek (f, 0, SEEK_SET)) {
+        r = SCPE_IOERR;
+        goto done;
+    }
+    fwrite (MT_CONT_MAGIC, 1, 8, f);
+    fxwrite (hdr, sizeof(t_value), MT_CONT_HDR_WORDS-1, f);
+
+    while (pos < nwords) {				/* zones, then irregular tail */
+        t_value * e = &dir[ndir*MT_CONT_DIR_WORDS];
+        size = (int)(words[pos] >> BITS_32);
+        if ((size >= 0) && (size <= MAX_TAPE_ZONE_SIZE) && (pos+size+2 <= nwords)) {
+            n = size+2;
+            e[0] = words[pos];
+        }
+        else {
+            n = nwords-pos;
+            e[0] = MT_CONT_TAIL;
+        }
+        e[1] = pos;
+        e[2] = n;
+        e[3] = ftell (f);
+        mt_cont_put_runs (f, &words[pos], n);
+        pos += n;
+        ndir++;
+    }
+
+    hdr[0] = MT_CONT_VERSION;
+    hdr[1] = nwords;
+    hdr[2] = ndir;
+    hdr[3] = ftell (f);
+    fxwrite (dir, sizeof(t_value), ndir*MT_CONT_DIR_WORDS, f);
+    hdr[4] = ftell (f);
+    fseek (f, sizeof(t_value), SEEK_SET);
+    fxwrite (hdr, sizeof(t_value), MT_CONT_HDR_WORDS-1, f);
+    fflush (f);
+    if (ferror (f)) r = SCPE_IOERR;
+    else sim_set_fsize (f, (t_addr)hdr[4]);		/* container may be shorter now */
+
+  done:
+    free (words);
+    free (dir);
+    return r;
 }
 
 
@@ -206,6 +588,7 @@ t_stat mt_format_tape (t_value *sum, int * ocodes, int first, int last)
     int codes_num = 0;
     int no_mosu_access = 0;
     int user_mt_no, tape_chk, j;
+    int dir_whole;
     unsigned long int  tape_len;
 
     user_mt_no = (ext_io_op & EXT_UNIT);
@@ -285,6 +668,11 @@ t_stat mt_format_tape (t_value *sum, int * ocodes, int first, int last)
     if ((last_fmt_pos+(codes_group_size+1+1)*sizeof(t_value)) > MAX_TAPE_SIZE*sizeof(t_value)) 
         return STOP_TAPEBADFLEN;
 
+    /* Directory is rebuilt if formatting fails */
+    dir_whole = (mt_image[mt_no].state == MT_DIR_WHOLE);
+    mt_image[mt_no].state = MT_DIR_NONE;
+    mt_image[mt_no].dirty = 1;
+
     /* 
        Write zone number and size.
        In real M-20 zone was written twice and no codes count was written.
@@ -330,6 +718,16 @@ t_stat mt_format_tape (t_value *sum, int * ocodes, int first, int last)
     codes_num++;
     if (ocodes) *ocodes = codes_num;
     if (sum) *sum = chksum;
+
+    /* New zone at end of tape */
+    if (dir_whole && (mt_image[mt_no].nzones < MT_DIR_SIZE) && ((last_fmt_pos % sizeof(t_value)) == 0)) {
+        MT_ZONE * z = &mt_image[mt_no].dir[mt_image[mt_no].nzones++];
+        z->num = zone_num;
+        z->size = codes_group_size;
+        z->pos = last_fmt_pos / sizeof(t_value);
+        mt_image[mt_no].end = z->pos + codes_group_size + 2;
+        mt_image[mt_no].state = MT_DIR_WHOLE;
+    }
 	
     return SCPE_OK;
 }
@@ -349,6 +747,7 @@ t_stat mt_write (int mt_no, int user_zone_num, int first, int last, t_value *sum
     int  cur_zone_num, cur_zone_size;
     t_value  temp_value, chksum;
     unsigned long int  tape_len, cur_tape_pos;
+    long  start_pos;
 
     if (sim_deb && mt_dev.dctrl)
 	fprintf (sim_deb, "mt: mt_write(%d,%05o,%04o,%04o,..)\n", mt_no, user_zone_num, first, last);
@@ -373,15 +772,16 @@ t_stat mt_write (int mt_no, int user_zone_num, int first, int last, t_value *sum
     if (res) return SCPE_IOERR;
     tape_len = ftell (mt_unit[mt_no].fileref);
 
-    /* Rewind tape into the beginning */
+    /* Rewind tape into the beginning (or to zone found by directory) */
     if (sim_deb && mt_dev.dctrl) fprintf (sim_deb, "mt: mt_write(): rewind tape to beginning\n");
-    res = fseek (mt_unit[mt_no].fileref, 0, SEEK_SET);
+    start_pos = mt_dir_find (mt_no, user_zone_num);
+    res = fseek (mt_unit[mt_no].fileref, start_pos*sizeof(t_value), SEEK_SET);
     if (res) return SCPE_IOERR;
 
-    cur_tape_pos = 0;
+    cur_tape_pos = start_pos*sizeof(t_value);
     cur_zone_num = 0;
 
-    codes_num = 0;
+    codes_num = (int)start_pos;
     if (ocodes) *ocodes = codes_num;
 
     //while( cur_zone_num <= MAX_TAPE_ZONE_NUM) {
@@ -424,6 +824,7 @@ t_stat mt_write (int mt_no, int user_zone_num, int first, int last, t_value *sum
 	        fprintf (sim_deb, "mt: mt_write(): cur_tape_pos=%d, tape_len=%d\n", cur_tape_pos, tape_len );
             res = fseek (mt_unit[mt_no].fileref, cur_tape_pos, SEEK_SET);
             if (res) return SCPE_IOERR;
+            mt_image[mt_no].dirty = 1;
             if (sim_deb && mt_dev.dctrl) fprintf (sim_deb, "mt: mt_write(): write zone data or zeroes\n");
             chksum = 0;
             for( i=0; i<userwords; i++ ) {
@@ -527,6 +928,7 @@ t_stat mt_read (int mt_no, int user_zone_num, int first, int last, t_value *sum,
     int  cur_zone_num, cur_zone_size;
     t_value  temp_value, chksum, calc_sum, user_chksum;
     unsigned long tape_len, cur_tape_pos;
+    long  start_pos;
 
     if (sim_deb && mt_dev.dctrl)
 	fprintf (sim_deb, "mt: mt_read(%d,%05o,%04o,%04o,..)\n", mt_no, user_zone_num, first, last);
@@ -551,15 +953,16 @@ t_stat mt_read (int mt_no, int user_zone_num, int first, int last, t_value *sum,
     if (res) return SCPE_IOERR;
     tape_len = ftell (mt_unit[mt_no].fileref);
 
-    /* Rewind tape into the beginning */
+    /* Rewind tape into the beginning (or to zone found by directory) */
     if (sim_deb && mt_dev.dctrl) fprintf (sim_deb, "mt: mt_read(): rewind tape to beginning\n");
-    res = fseek (mt_unit[mt_no].fileref, 0, SEEK_SET);
+    start_pos = mt_dir_find (mt_no, user_zone_num);
+    res = fseek (mt_unit[mt_no].fileref, start_pos*sizeof(t_value), SEEK_SET);
     if (res) return SCPE_IOERR;
 
-    cur_tape_pos = 0;
+    cur_tape_pos = start_pos*sizeof(t_value);
     cur_zone_num = 0;
 
-    codes_num = 0;
+    codes_num = (int)start_pos;
     if (ocodes) *ocodes = codes_num;
 
     while( cur_tape_pos < tape_len) {
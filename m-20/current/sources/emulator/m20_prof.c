@@ -0,0 +1,874 @@
+/*
+ * File:     m20_prof.c
+ * Purpose:  M-20 simulator guest program profilers
+ *
+ * Copyright (c) 2026, Dmitry Stefankov
+ *
+ * $Id$
+ *
+ * Call-graph profiler.
+ *
+ * Subroutine call on M-20 is made by instruction 016 (jump with return):
+ * the return instruction (016 with return address in A2) is stored at A3
+ * and control is transfered to A2. Routine returns by jump to that cell
+ * (or any jump to return address). Profiler tracks this linkage and
+ * builds a dynamic call tree with instruction counts and emulated time.
+ * Every transfer of control to the return address of one of the active
+ * frames is treated as return (deeper frames are dropped).
+ *
+ * Loop profiler.
+ *
+ * Loops on M-20 are closed by cycle instructions (011, 012, 031, 032, 051,
+ * 071) which compare RA with A1, jump to A2 and load A3 into RA. Profiler
+ * is keyed on address of cycle instruction: loop is entered when cycle
+ * instruction is executed first time (body is started at last execution
+ * of jump address A2) and left when jump is not taken. For every loop are
+ * counted entries, iterations (min/avg/max per entry), instructions and
+ * emulated time of loop body (nested loops and calls are included).
+ *
+ * Self-modifying code monitor.
+ *
+ * Programs patch instructions by command arithmetic (013, 033, 053, 073),
+ * store computed instructions by transfer (000) and load code overlays
+ * by external devices. Monitor counts for every address executions
+ * (at instruction fetch) and writes while CPU is running, and how often
+ * word is executed after it was written since its previous execution
+ * (such execution would miss any cache of decoded instructions). For
+ * these executions are kept distances (in instructions) from the write
+ * to the fetch, and for every writing instruction the count of writes
+ * to code that was already executed.
+ *
+ * Commands:
+ *   PROFILE CALLS                   print routines table
+ *   PROFILE FOLDED file [TIME]      write call stacks in folded format
+ *                                   (flamegraph.pl), weight is instruction
+ *                                   count or emulated time (us)
+ *   PROFILE LOOPS                   print loops table
+ *   PROFILE SMC [n]                 print self-modifying code table (first
+ *                                   n addresses and writers)
+ *   PROFILE HOST [n]                print host counters by opcodes (m20_hpc.c)
+ *   PROFILE LISTING file            load autocode_m20 listing to show
+ *                                   source lines in loops table
+ *   PROFILE RESET                   clear profile data
+ *
+ * Revision History.
+ *
+ *  19-Oct-2026  DVS  Initial Implementation (call-graph profiler)
+ *  19-Oct-2026  DVS  Added loop profiler
+ *  19-Oct-2026  DVS  Routine names and source lines from symbol map (LOAD -S)
+ *  19-Oct-2026  DVS  Added self-modifying code monitor
+ *  19-Oct-2026  DVS  Added host counters report (PROFILE HOST)
+ *
+ */
+
+#include "m20_defs.h"
+
+
+/* CPU module references */
+
+extern uint16   regKRA;
+extern uint16   regRA;
+extern t_value  regRK;
+extern t_uint64 cpu_instr_count;
+
+
+/* System module references (symbol map) */
+
+extern const char * m20_sym_name (int addr);
+extern int m20_sym_line (int addr);
+
+
+/* Host counters module references */
+
+extern void m20_hpc_print (FILE * st, int max);
+extern void m20_hpc_reset (void);
+
+
+/* Parameters (CPU registers) */
+
+int  call_profile = 0;			/* enable call-graph profiler */
+int  loop_profile = 0;			/* enable loop profiler */
+int  smc_profile = 0;			/* enable self-modifying code monitor */
+
+
+#define  MAX_CALL_DEPTH      256
+#define  MAX_CALL_NODES      65536
+#define  ROOT_NODE           0
+
+
+/* Routine statistics (by entry address) */
+typedef  struct call_routine_stat {
+    double   calls;
+    double   excl_count;
+    double   excl_time;
+    double   incl_count;
+    double   incl_time;
+    int      active;		/* number of frames on stack */
+} CALL_ROUTINE_STAT, * PCALL_ROUTINE_STAT;
+
+
+/* Node of dynamic call tree */
+typedef  struct call_node {
+    int      entry;		/* routine entry address (-1 for root) */
+    int      parent;
+    int      child;		/* first child */
+    int      sibling;		/* next child of parent */
+    double   count;		/* exclusive instruction count */
+    double   time;		/* exclusive emulated time */
+} CALL_NODE, * PCALL_NODE;
+
+
+/* Active call frame */
+typedef  struct call_frame {
+    int       node;
+    int       entry;
+    int       ret_addr;
+    t_uint64  start_count;
+    double    start_time;
+} CALL_FRAME, * PCALL_FRAME;
+
+
+static CALL_ROUTINE_STAT  call_routines[MAX_MEM_SIZE];
+static PCALL_NODE         call_nodes = NULL;
+static int                call_nodes_num = 0;
+static int                call_nodes_size = 0;
+static CALL_FRAME         call_stack[MAX_CALL_DEPTH];
+static int                call_depth = 0;
+static int                call_cur_node = ROOT_NODE;
+static t_uint64           call_count = 0;	/* instructions seen by profiler */
+static double             call_time = 0;
+static double             call_lost = 0;	/* calls over max. depth or nodes */
+
+
+/* Loop statistics (by address of cycle instruction) */
+typedef  struct loop_stat {
+    double    entries;
+    double    iterations;
+    double    min_trip;
+    double    max_trip;
+    double    body_count;
+    double    body_time;
+    int       target;		/* last jump address */
+    int       active;
+    double    cur_trip;
+    t_uint64  start_count;
+    double    start_time;
+} LOOP_STAT, * PLOOP_STAT;
+
+
+static LOOP_STAT   loop_table[MAX_MEM_SIZE];
+static t_uint64    loop_visit_count[MAX_MEM_SIZE];	/* last execution of address */
+static double      loop_visit_time[MAX_MEM_SIZE];
+static t_uint64    loop_count = 0;			/* instructions seen by profiler */
+static double      loop_time = 0;
+
+
+/* Self-modifying code statistics (by address) */
+typedef  struct smc_stat {
+    double    execs;		/* instruction fetches */
+    double    writes;		/* writes while CPU is running */
+    double    code_writes;	/* writes after first execution */
+    double    stale_execs;	/* executions after write */
+    double    min_dist;		/* distance from write to execution */
+    double    max_dist;
+    double    sum_dist;
+    t_uint64  write_count;	/* instruction count at last write */
+    int       writer;		/* address of last writing instruction */
+    int       dirty;		/* written since last execution */
+    double    writer_code;	/* as writer: writes to executed code */
+} SMC_STAT, * PSMC_STAT;
+
+
+#define  SMC_WRITER_CMDS     0	/* command arithmetic 013, 033, 053, 073 */
+#define  SMC_WRITER_MOVE     1	/* transfer 000 */
+#define  SMC_WRITER_IO       2	/* external devices */
+#define  SMC_WRITER_OTHER    3
+#define  SMC_WRITER_NUM      4
+#define  SMC_DIST_BUCKETS    24	/* distances 1, 2-3, 4-7, ... */
+
+
+static const char * smc_writer_name[SMC_WRITER_NUM] = {
+    "command arithmetic", "transfer", "i/o", "other"
+};
+
+static SMC_STAT    smc_table[MAX_MEM_SIZE];
+static int         smc_pc = 0;			/* instruction being executed */
+static int         smc_op = 0;
+static double      smc_kind_writes[SMC_WRITER_NUM];	/* writes to executed code */
+static double      smc_dist_hist[SMC_DIST_BUCKETS];
+static t_uint64    smc_count = 0;		/* instructions seen by monitor */
+static double      smc_stale = 0;		/* executions after write */
+
+
+/* Source lines from autocode listing (by address) */
+static int         src_line_num[MAX_MEM_SIZE];
+static char *      src_line_text[MAX_MEM_SIZE];
+
+
+
+/*
+ *  Routine name (label from symbol map or octal address)
+ */
+static char * prof_addr_name (int addr, char * buf, int size)
+{
+    if (addr < 0) _snprintf (buf, size, "main");
+    else if (m20_sym_name (addr)) _snprintf (buf, size, "%s", m20_sym_name (addr));
+    else _snprintf (buf, size, "%04o", addr);
+    return buf;
+}
+
+
+
+/*
+ *  Clear call-graph profile
+ */
+void call_prof_reset (void)
+{
+    memset (call_routines, 0, sizeof(call_routines));
+    free (call_nodes);
+    call_nodes = NULL;
+    call_nodes_num = call_nodes_size = 0;
+    call_depth = 0;
+    call_cur_node = ROOT_NODE;
+    call_count = 0;
+    call_time = 0;
+    call_lost = 0;
+}
+
+
+
+/*
+ *  Clear loop profile
+ */
+void loop_prof_reset (void)
+{
+    memset (loop_table, 0, sizeof(loop_table));
+    memset (loop_visit_count, 0, sizeof(loop_visit_count));
+    memset (loop_visit_time, 0, sizeof(loop_visit_time));
+    loop_count = 0;
+    loop_time = 0;
+}
+
+
+
+/*
+ *  Clear self-modifying code statistics
+ */
+void smc_prof_reset (void)
+{
+    memset (smc_table, 0, sizeof(smc_table));
+    memset (smc_kind_writes, 0, sizeof(smc_kind_writes));
+    memset (smc_dist_hist, 0, sizeof(smc_dist_hist));
+    smc_count = 0;
+    smc_stale = 0;
+}
+
+
+
+/*
+ *  Find or create child node of call tree
+ */
+static int call_node_child (int parent, int entry)
+{
+    PCALL_NODE  p;
+    int  n;
+
+    for( n=call_nodes[parent].child; n>0; n=call_nodes[n].sibling ) {
+        if (call_nodes[n].entry == entry) return n;
+    }
+    if (call_nodes_num >= MAX_CALL_NODES) return -1;
+    if (call_nodes_num == call_nodes_size) {
+        p = (PCALL_NODE) realloc (call_nodes, (call_nodes_size + 1024) * sizeof(CALL_NODE));
+        if (p == NULL) return -1;
+        call_nodes = p;
+        call_nodes_size += 1024;
+    }
+    n = call_nodes_num++;
+    memset (&call_nodes[n], 0, sizeof(CALL_NODE));
+    call_nodes[n].entry = entry;
+    call_nodes[n].parent = parent;
+    call_nodes[n].sibling = call_nodes[parent].child;
+    call_nodes[parent].child = n;
+
+    return n;
+}
+
+
+
+/*
+ *  Leave frame on top of call stack
+ */
+static void call_pop (void)
+{
+    PCALL_FRAME  f = &call_stack[--call_depth];
+    PCALL_ROUTINE_STAT  rs = &call_routines[f->entry];
+    int  i;
+
+    /* recursive calls are counted once per inclusive totals */
+    if (--rs->active == 0) {
+        rs->incl_count += (double)(call_count - f->start_count);
+        rs->incl_time  += call_time - f->start_time;
+    }
+    /* current node is node of nearest tracked frame */
+    call_cur_node = ROOT_NODE;
+    for( i=call_depth-1; i>=0; i-- ) {
+        if (call_stack[i].node >= 0) { call_cur_node = call_stack[i].node; break; }
+    }
+}
+
+
+
+/*
+ *  Called after every executed instruction
+ *  pc   - address of instruction
+ *  op   - operation code
+ *  time - emulated time of instruction
+ */
+void call_prof_inst (int pc, int op, double time)
+{
+    PCALL_FRAME  f;
+    int  i, a1, a2;
+
+    if (call_nodes == NULL) {
+        /* root node of call tree */
+        call_nodes = (PCALL_NODE) calloc (1024, sizeof(CALL_NODE));
+        if (call_nodes == NULL) return;
+        call_nodes_size = 1024;
+        call_nodes_num = 1;
+        call_nodes[ROOT_NODE].entry = -1;
+        call_cur_node = ROOT_NODE;
+    }
+
+    /* exclusive counters of current routine */
+    call_count++;
+    call_time += time;
+    call_nodes[call_cur_node].count += 1;
+    call_nodes[call_cur_node].time  += time;
+    if (call_depth > 0) {
+        call_routines[call_stack[call_depth-1].entry].excl_count += 1;
+        call_routines[call_stack[call_depth-1].entry].excl_time  += time;
+    }
+
+    if (regKRA == ((pc + 1) & MAX_ADDR_VALUE)) return;
+
+    /* return to one of active frames */
+    for( i=call_depth-1; i>=0; i-- ) {
+        if (call_stack[i].ret_addr == regKRA) {
+            while (call_depth > i) call_pop ();
+            return;
+        }
+    }
+
+    if (op != OPCODE_JUMP_WITH_RETURN) return;
+
+    /* new call */
+    a1 = regRK >> BITS_24 & MAX_ADDR_VALUE;
+    if ((regRK >> BITS_42) & 4) a1 = (a1 + regRA) & MAX_ADDR_VALUE;
+    a2 = regKRA & MAX_ADDR_VALUE;
+    if (call_depth >= MAX_CALL_DEPTH) { call_lost++; return; }
+
+    f = &call_stack[call_depth++];
+    f->entry = a2;
+    f->ret_addr = a1;
+    f->start_count = call_count;
+    f->start_time = call_time;
+    f->node = call_node_child (call_cur_node, a2);
+    if (f->node >= 0) call_cur_node = f->node;
+    else call_lost++;
+    call_routines[a2].calls += 1;
+    call_routines[a2].active++;
+}
+
+
+
+/*
+ *  Inclusive counters with active frames
+ */
+static void call_prof_totals (int entry, double * incl_count, double * incl_time)
+{
+    int  i;
+
+    *incl_count = call_routines[entry].incl_count;
+    *incl_time  = call_routines[entry].incl_time;
+    for( i=0; i<call_depth; i++ ) {
+        if (call_stack[i].entry == entry) {
+            *incl_count += (double)(call_count - call_stack[i].start_count);
+            *incl_time  += call_time - call_stack[i].start_time;
+            break;
+        }
+    }
+}
+
+
+static int call_prof_cmp (const void * p1, const void * p2)
+{
+    double  c1, t1, c2, t2;
+
+    call_prof_totals (*(const int *)p1, &c1, &t1);
+    call_prof_totals (*(const int *)p2, &c2, &t2);
+    if (t1 < t2) return 1;
+    if (t1 > t2) return -1;
+    return *(const int *)p1 - *(const int *)p2;
+}
+
+
+
+/*
+ *  Print routines table (sorted by inclusive time)
+ */
+void call_prof_print (FILE * st)
+{
+    int  order[MAX_MEM_SIZE];
+    int  i, n = 0;
+    double  ic, it;
+    char  name[64];
+
+    for( i=0; i<MAX_MEM_SIZE; i++ ) {
+        if (call_routines[i].calls > 0) order[n++] = i;
+    }
+    qsort (order, n, sizeof(int), call_prof_cmp);
+
+    fprintf (st, "\n*** Call graph profile stat ***\n");
+    fprintf (st, "routine            calls     incl_count     incl_time  incl%%     excl_count     excl_time  excl%%\n");
+    for( i=0; i<n; i++ ) {
+        PCALL_ROUTINE_STAT rs = &call_routines[order[i]];
+        call_prof_totals (order[i], &ic, &it);
+        fprintf (st, "%-12s %11.0f %14.0f %13.2f %6.2f %14.0f %13.2f %6.2f\n",
+                 prof_addr_name (order[i], name, sizeof(name)), rs->calls,
+                 ic, it, call_time > 0 ? 100.0*it/call_time : 0.0,
+                 rs->excl_count, rs->excl_time,
+                 call_time > 0 ? 100.0*rs->excl_time/call_time : 0.0 );
+    }
+    fprintf (st, "Summary:  routines=%d  count=%.0f  times=%.2f  depth=%d  lost=%.0f\n",
+             n, (double)call_count, call_time, call_depth, call_lost );
+    fprintf (st, "**********\n\n");
+}
+
+
+
+/*
+ *  Write call stacks in folded format: "main;0100;0200 weight"
+ */
+t_stat call_prof_folded (const char * filename, int by_time)
+{
+    FILE * fp;
+    int  i, n, len, depth;
+    int  path[MAX_CALL_DEPTH+1];
+    double  w;
+    char  name[64];
+
+    if (call_nodes == NULL) return sim_messagef (SCPE_NOFNC, "No call graph profile data\n");
+
+    fp = fopen (filename, "w");
+    if (fp == NULL) return SCPE_OPENERR;
+
+    for( i=0; i<call_nodes_num; i++ ) {
+        w = by_time ? call_nodes[i].time : call_nodes[i].count;
+        if (w <= 0) continue;
+        depth = 0;
+        for( n=i; (n != ROOT_NODE) && (depth < MAX_CALL_DEPTH); n=call_nodes[n].parent ) path[depth++] = n;
+        path[depth++] = ROOT_NODE;
+        len = 0;
+        while (depth-- > 0) {
+            if (len++) fprintf (fp, ";");
+            fprintf (fp, "%s", prof_addr_name (call_nodes[path[depth]].entry, name, sizeof(name)));
+        }
+        fprintf (fp, " %.0f\n", w);
+    }
+    fclose (fp);
+
+    return SCPE_OK;
+}
+
+
+
+/*
+ *  Called after every executed instruction
+ *  pc   - address of instruction
+ *  op   - operation code
+ *  ra   - address register before instruction
+ *  time - emulated time of instruction
+ */
+void loop_prof_inst (int pc, int op, int ra, double time)
+{
+    PLOOP_STAT  lp;
+    int  a2;
+
+    loop_count++;
+    loop_time += time;
+    loop_visit_count[pc] = loop_count;
+    loop_visit_time[pc]  = loop_time - time;	/* time before instruction */
+
+    switch (op) {
+      case OPCODE_GOTO_AFTER_CYCLE_BY_PA_SIG_W_1_011:
+      case OPCODE_GOTO_AFTER_CYCLE_BY_PA_012:
+      case OPCODE_GOTO_AFTER_CYCLE_BY_PA_SIG_W_1_031:
+      case OPCODE_GOTO_AFTER_CYCLE_BY_PA_032:
+      case OPCODE_GOTO_AFTER_CYCLE_BY_PA_SIG_W_0_051:
+      case OPCODE_GOTO_AFTER_CYCLE_BY_PA_SIG_W_0_071:
+        break;
+      default:
+        return;
+    }
+
+    lp = &loop_table[pc];
+    a2 = regRK >> BITS_12 & MAX_ADDR_VALUE;
+    if ((regRK >> BITS_42) & 2) a2 = (a2 + ra) & MAX_ADDR_VALUE;
+
+    if (!lp->active) {
+        /* first iteration is started at last execution of jump address */
+        lp->active = 1;
+        lp->cur_trip = 0;
+        if ((a2 <= pc) && (loop_visit_count[a2] > 0)) {
+            lp->start_count = loop_visit_count[a2] - 1;
+            lp->start_time  = loop_visit_time[a2];
+        }
+        else {
+            lp->start_count = loop_count - 1;
+            lp->start_time  = loop_time - time;
+        }
+    }
+    lp->target = a2;
+    lp->cur_trip += 1;
+    lp->iterations += 1;
+
+    if (regKRA == a2) return;		/* next iteration */
+
+    /* exit from loop */
+    lp->active = 0;
+    lp->entries += 1;
+    if ((lp->min_trip == 0) || (lp->cur_trip < lp->min_trip)) lp->min_trip = lp->cur_trip;
+    if (lp->cur_trip > lp->max_trip) lp->max_trip = lp->cur_trip;
+    lp->body_count += (double)(loop_count - lp->start_count);
+    lp->body_time  += loop_time - lp->start_time;
+}
+
+
+
+static int loop_prof_cmp (const void * p1, const void * p2)
+{
+    PLOOP_STAT  l1 = &loop_table[*(const int *)p1];
+    PLOOP_STAT  l2 = &loop_table[*(const int *)p2];
+
+    if (l1->body_time < l2->body_time) return 1;
+    if (l1->body_time > l2->body_time) return -1;
+    return *(const int *)p1 - *(const int *)p2;
+}
+
+
+
+/*
+ *  Print loops table (sorted by body time)
+ */
+void loop_prof_print (FILE * st)
+{
+    int  order[MAX_MEM_SIZE];
+    int  i, n = 0;
+    PLOOP_STAT  lp;
+
+    for( i=0; i<MAX_MEM_SIZE; i++ ) {
+        if (loop_table[i].iterations > 0) order[n++] = i;
+    }
+    qsort (order, n, sizeof(int), loop_prof_cmp);
+
+    fprintf (st, "\n*** Loop profile stat ***\n");
+    fprintf (st, "cycle body        entries   iterations  min_it   avg_it  max_it     body_count      body_time  time%%\n");
+    for( i=0; i<n; i++ ) {
+        lp = &loop_table[order[i]];
+        fprintf (st, "%04o  %04o %12.0f %12.0f %7.0f %8.1f %7.0f %14.0f %14.2f %6.2f%s\n",
+                 order[i], lp->target, lp->entries, lp->iterations, lp->min_trip,
+                 lp->entries > 0 ? lp->iterations/lp->entries : 0.0, lp->max_trip,
+                 lp->body_count, lp->body_time,
+                 loop_time > 0 ? 100.0*lp->body_time/loop_time : 0.0,
+                 lp->active ? "  (active)" : "" );
+        if (src_line_num[order[i]] > 0)
+            fprintf (st, "      line %d: %s\n", src_line_num[order[i]],
+                     src_line_text[order[i]] ? src_line_text[order[i]] : "");
+        else if (m20_sym_line (order[i]) > 0)
+            fprintf (st, "      line %d%s%s\n", m20_sym_line (order[i]),
+                     m20_sym_name (lp->target) ? ", body " : "",
+                     m20_sym_name (lp->target) ? m20_sym_name (lp->target) : "");
+    }
+    fprintf (st, "Summary:  loops=%d  count=%.0f  times=%.2f\n", n, (double)loop_count, loop_time );
+    fprintf (st, "**********\n\n");
+}
+
+
+
+/*
+ *  Called before every executed instruction (at fetch)
+ *  pc   - address of instruction
+ *  op   - operation code
+ */
+void smc_prof_fetch (int pc, int op)
+{
+    PSMC_STAT  sp = &smc_table[pc];
+    double  d;
+    int  b;
+
+    smc_pc = pc;
+    smc_op = op;
+    smc_count++;
+    sp->execs += 1;
+    if (!sp->dirty) return;
+
+    /* execution of written word */
+    sp->dirty = 0;
+    sp->stale_execs += 1;
+    smc_stale += 1;
+    d = (double)(cpu_instr_count - sp->write_count);
+    if ((sp->min_dist == 0) || (d < sp->min_dist)) sp->min_dist = d;
+    if (d > sp->max_dist) sp->max_dist = d;
+    sp->sum_dist += d;
+    for( b=0; (b < SMC_DIST_BUCKETS-1) && (d >= 2.0); b++ ) d /= 2;
+    smc_dist_hist[b] += 1;
+}
+
+
+
+/*
+ *  Called on every memory write while CPU is running
+ *  addr - written address
+ */
+void smc_prof_write (int addr)
+{
+    PSMC_STAT  sp = &smc_table[addr];
+    int  kind;
+
+    sp->writes += 1;
+    sp->write_count = cpu_instr_count;
+    sp->writer = smc_pc;
+    sp->dirty = 1;
+    if (sp->execs == 0) return;
+
+    /* write to executed code */
+    sp->code_writes += 1;
+    smc_table[smc_pc].writer_code += 1;
+    switch (smc_op) {
+      case OPCODE_ADD_CMDS:
+      case OPCODE_SUB_CMDS:
+      case OPCODE_ADD_OPCS:
+      case OPCODE_SUB_OPCS:
+        kind = SMC_WRITER_CMDS;
+        break;
+      case OPCODE_TRANSFER_MEM2MEM:
+        kind = SMC_WRITER_MOVE;
+        break;
+      default:
+        kind = OPCODE_IS_IO (smc_op) ? SMC_WRITER_IO : SMC_WRITER_OTHER;
+        break;
+    }
+    smc_kind_writes[kind] += 1;
+}
+
+
+
+static int smc_prof_cmp (const void * p1, const void * p2)
+{
+    PSMC_STAT  s1 = &smc_table[*(const int *)p1];
+    PSMC_STAT  s2 = &smc_table[*(const int *)p2];
+
+    if (s1->stale_execs < s2->stale_execs) return 1;
+    if (s1->stale_execs > s2->stale_execs) return -1;
+    if (s1->code_writes < s2->code_writes) return 1;
+    if (s1->code_writes > s2->code_writes) return -1;
+    return *(const int *)p1 - *(const int *)p2;
+}
+
+static int smc_writer_cmp (const void * p1, const void * p2)
+{
+    PSMC_STAT  s1 = &smc_table[*(const int *)p1];
+    PSMC_STAT  s2 = &smc_table[*(const int *)p2];
+
+    if (s1->writer_code < s2->writer_code) return 1;
+    if (s1->writer_code > s2->writer_code) return -1;
+    return *(const int *)p1 - *(const int *)p2;
+}
+
+
+
+/*
+ *  Print self-modifying code table (sorted by executions after write)
+ *  max - number of printed addresses and writers (0 = all)
+ */
+void smc_prof_print (FILE * st, int max)
+{
+    int  order[MAX_MEM_SIZE];
+    int  i, n = 0, code = 0, stable = 0;
+    double  lo, hi;
+    PSMC_STAT  sp;
+
+    for( i=0; i<MAX_MEM_SIZE; i++ ) {
+        sp = &smc_table[i];
+        if (sp->execs == 0) continue;
+        code++;
+        if (sp->writes == 0) stable++;
+        else order[n++] = i;
+    }
+    qsort (order, n, sizeof(int), smc_prof_cmp);
+
+    fprintf (st, "\n*** Self-modifying code stat ***\n");
+    fprintf (st, "addr         execs   exec_after_wr       writes  code_writes   min_dist   avg_dist   max_dist  writer\n");
+    for( i=0; (i < n) && ((max == 0) || (i < max)); i++ ) {
+        sp = &smc_table[order[i]];
+        fprintf (st, "%04o  %12.0f  %14.0f %12.0f %12.0f %10.0f %10.1f %10.0f  %04o  %s\n",
+                 order[i], sp->execs, sp->stale_execs, sp->writes, sp->code_writes,
+                 sp->min_dist, sp->stale_execs > 0 ? sp->sum_dist/sp->stale_execs : 0.0,
+                 sp->max_dist, sp->writer,
+                 m20_sym_name (order[i]) ? m20_sym_name (order[i]) : "" );
+    }
+
+    /* instructions writing to executed code */
+    for( i=0, n=0; i<MAX_MEM_SIZE; i++ ) {
+        if (smc_table[i].writer_code > 0) order[n++] = i;
+    }
+    qsort (order, n, sizeof(int), smc_writer_cmp);
+    if (n > 0) {
+        fprintf (st, "writer  code_writes  routine\n");
+        for( i=0; (i < n) && ((max == 0) || (i < max)); i++ ) {
+            fprintf (st, "%04o   %12.0f  %s\n", order[i], smc_table[order[i]].writer_code,
+                     m20_sym_name (order[i]) ? m20_sym_name (order[i]) : "" );
+        }
+    }
+
+    fprintf (st, "Writes to executed code:");
+    for( i=0; i<SMC_WRITER_NUM; i++ )
+        fprintf (st, "  %s=%.0f", smc_writer_name[i], smc_kind_writes[i]);
+    fprintf (st, "\n");
+    fprintf (st, "Distance from write to execution (instructions):\n");
+    for( i=0, lo=1; i<SMC_DIST_BUCKETS; i++, lo*=2 ) {
+        if (smc_dist_hist[i] == 0) continue;
+        hi = 2*lo - 1;
+        if (i == SMC_DIST_BUCKETS-1) fprintf (st, "  %10.0f-      %12.0f\n", lo, smc_dist_hist[i]);
+        else fprintf (st, "  %10.0f-%-10.0f %12.0f\n", lo, hi, smc_dist_hist[i]);
+    }
+    fprintf (st, "Summary:  code=%d  stable=%d  written=%d  count=%.0f  exec_after_wr=%.0f  cacheable=%.2f%%\n",
+             code, stable, code - stable, (double)smc_count, smc_stale,
+             smc_count > 0 ? 100.0*(smc_count - smc_stale)/smc_count : 0.0 );
+    fprintf (st, "**********\n\n");
+}
+
+
+
+/*
+ *  Load address to source line map from autocode_m20 listing
+ *
+ *  Listing lines:
+ *    NNNNN:   source text
+ *    NNNNN:   :AAAA  t oo aaaa aaaa aaaa
+ */
+t_stat prof_load_listing (const char * filename)
+{
+    FILE * fp;
+    char  buf[2048];
+    char  text[2048];
+    char * p;
+    int  line, text_line = 0, addr, t, op, n = 0;
+
+    fp = fopen (filename, "r");
+    if (fp == NULL) return SCPE_OPENERR;
+
+    for( addr=0; addr<MAX_MEM_SIZE; addr++ ) {
+        free (src_line_text[addr]);
+        src_line_text[addr] = NULL;
+        src_line_num[addr] = 0;
+    }
+    text[0] = '\0';
+
+    while (fgets (buf, sizeof(buf), fp) != NULL) {
+        p = strchr (buf, '\n');
+        if (p != NULL) *p = '\0';
+        p = strchr (buf, '\r');
+        if (p != NULL) *p = '\0';
+        if (sscanf (buf, "%d:   :%o  %o %o", &line, &addr, &t, &op) == 4) {
+            if ((addr < 0) || (addr >= MAX_MEM_SIZE)) continue;
+            src_line_num[addr] = line;
+            if ((line == text_line) && (src_line_text[addr] == NULL)) {
+                src_line_text[addr] = (char *) malloc (strlen(text)+1);
+                if (src_line_text[addr] != NULL) strcpy (src_line_text[addr], text);
+            }
+            n++;
+            continue;
+        }
+        if ((sscanf (buf, "%d:", &line) == 1) && ((p = strchr (buf, ':')) != NULL)) {
+            if (p[1] == ' ' && p[2] == ' ' && p[3] == ' ' && p[4] == ':') continue;
+            text_line = line;
+            for( p++; (*p == ' ') || (*p == '\t'); p++ ) ;
+            strncpy (text, p, sizeof(text)-1);
+            text[sizeof(text)-1] = '\0';
+        }
+    }
+    fclose (fp);
+
+    printf ("%d addresses loaded from listing %s\n", n, filename);
+
+    return SCPE_OK;
+}
+
+
+
+/*
+ *  PROFILE command
+ */
+t_stat prof_cmd (int32 flag, CONST char *cptr)
+{
+    char  gbuf[CBUFSIZE];
+    char  fbuf[CBUFSIZE];
+
+    cptr = get_glyph (cptr, gbuf, 0);
+    if (strcmp (gbuf, "CALLS") == 0) {
+        if (*cptr) return SCPE_2MARG;
+        call_prof_print (stdout);
+        return SCPE_OK;
+    }
+    if (strcmp (gbuf, "FOLDED") == 0) {
+        cptr = get_glyph_nc (cptr, fbuf, 0);
+        if (fbuf[0] == '\0') return SCPE_2FARG;
+        cptr = get_glyph (cptr, gbuf, 0);
+        if (*cptr || (gbuf[0] && strcmp (gbuf, "TIME"))) return SCPE_ARG;
+        return call_prof_folded (fbuf, gbuf[0] != '\0');
+    }
+    if (strcmp (gbuf, "LOOPS") == 0) {
+        if (*cptr) return SCPE_2MARG;
+        loop_prof_print (stdout);
+        return SCPE_OK;
+    }
+    if (strcmp (gbuf, "SMC") == 0) {
+        t_stat r = SCPE_OK;
+        int  max = 0;
+
+        cptr = get_glyph (cptr, gbuf, 0);
+        if (*cptr) return SCPE_2MARG;
+        if (gbuf[0]) max = (int) get_uint (gbuf, 10, MAX_MEM_SIZE, &r);
+        if (r != SCPE_OK) return SCPE_ARG;
+        smc_prof_print (stdout, max);
+        return SCPE_OK;
+    }
+    if (strcmp (gbuf, "HOST") == 0) {
+        t_stat r = SCPE_OK;
+        int  max = 0;
+
+        cptr = get_glyph (cptr, gbuf, 0);
+        if (*cptr) return SCPE_2MARG;
+        if (gbuf[0]) max = (int) get_uint (gbuf, 10, MAX_MEM_SIZE, &r);
+        if (r != SCPE_OK) return SCPE_ARG;
+        m20_hpc_print (stdout, max);
+        return SCPE_OK;
+    }
+    if (strcmp (gbuf, "LISTING") == 0) {
+        cptr = get_glyph_nc (cptr, fbuf, 0);
+        if (fbuf[0] == '\0') return SCPE_2FARG;
+        if (*cptr) return SCPE_2MARG;
+        return prof_load_listing (fbuf);
+    }
+    if (strcmp (gbuf, "RESET") == 0) {
+        if (*cptr) return SCPE_2MARG;
+        call_prof_reset ();
+        loop_prof_reset ();
+        smc_prof_reset ();
+        m20_hpc_reset ();
+        return SCPE_OK;
+    }
+
+    return SCPE_ARG;
+}
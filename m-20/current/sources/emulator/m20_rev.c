@@ -0,0 +1,498 @@
+/*
+ * File:     m20_rev.c
+ * Purpose:  M-20 simulator reverse execution (step back / run back)
+ *
+ * Copyright (c) 2026, Dmitry Stefankov
+ *
+ * $Id$
+ *
+ * Reverse execution is built on periodic checkpoints of CPU registers
+ * and MOSU taken every REV_INTERVAL instructions, plus deterministic
+ * re-execution from the nearest checkpoint up to the wanted instruction.
+ *
+ * Memory checkpoints are delta-compressed: only a newest full image of MOSU
+ * (shadow) is kept, and every older checkpoint stores only the words that
+ * differ from the next (newer) checkpoint. The number of checkpoints is
+ * limited by REV_DEPTH, the oldest one is dropped when the ring is full.
+ *
+ * External devices are not rewound, so every instruction which does real
+ * i/o (010, 030, 070) starts a new history: it is not possible to step back
+ * over such an instruction. The emulated time (SHOW TIME) is not rewound too.
+ *
+ * Checkpoints are taken only with DEP REV_ENABLE 1 (off by default, it
+ * costs a hook on every instruction and disables burst execution).
+ *
+ * Commands:
+ *   BSTEP [n]          step back n instructions (default 1)
+ *   BRUN               run back to the start of history
+ *   BRUN addr          run back until KRA is equal to addr (octal)
+ *   BRUN WATCH addr    run back until last change of memory word addr
+ *
+ * Revision History.
+ *
+ *  19-Oct-2026  DVS  Initial Implementation
+ *  19-Oct-2026  DVS  Integer emulated timebase
+ *  19-Oct-2026  DVS  Checkpoints off by default (REV_ENABLE 0)
+ *
+ */
+
+#include "m20_defs.h"
+
+
+/* CPU module references */
+
+extern DEVICE cpu_dev;
+
+extern uint16   regKRA;
+extern uint16   regRA;
+extern uint16   regSMA;
+extern int      trgSW;
+extern int      regROP;
+extern t_value  regRK;
+extern t_value  regRR;
+extern t_value  regP1;
+extern t_value  regP2;
+extern int      old_opcode;
+extern t_int64  delay;
+extern int      print_sys_stat;
+
+extern int ext_io_op;
+extern int ext_io_dev_zone_addr;
+extern int ext_io_ram_start;
+extern int ext_io_ram_end;
+extern int ext_io_ram_jump;
+extern int ext_io_ram_chksum;
+
+extern t_value  MOSU[MAX_MEM_SIZE];
+extern t_uint64 cpu_instr_count;
+
+extern t_stat cpu_exec_inst (void);
+
+
+/* Parameters (CPU registers) */
+
+int  rev_enable   = 0;		/* take checkpoints during run */
+int  rev_interval = 1000;	/* instructions between checkpoints */
+int  rev_depth    = 256;	/* max. number of checkpoints */
+
+
+/* Delta-compressed memory word */
+typedef  struct rev_delta {
+    uint16   addr;
+    t_value  val;
+} REV_DELTA, * PREV_DELTA;
+
+
+/* Checkpoint of CPU state */
+typedef  struct rev_checkpoint {
+    t_uint64   count;		/* instructions executed before this point */
+    uint16     KRA, RA, SMA;
+    int        SW, ROP;
+    t_value    RK, RR, P1, P2;
+    int        old_op;
+    int        io_op, io_zone, io_start, io_end, io_jump, io_chksum;
+    PREV_DELTA delta;		/* words to go back from next checkpoint */
+    int        delta_num;
+} REV_CHECKPOINT, * PREV_CHECKPOINT;
+
+
+static PREV_CHECKPOINT  rev_ring = NULL;
+static int              rev_ring_size = 0;
+static int              rev_head = 0;		/* oldest checkpoint */
+static int              rev_num = 0;		/* number of checkpoints */
+static t_uint64         rev_next = 0;		/* next periodic checkpoint */
+static t_value          rev_shadow[MAX_MEM_SIZE];	/* MOSU at newest checkpoint */
+static int              rev_delta_buf[MAX_MEM_SIZE];
+
+
+
+#define  REV_SLOT(n)  (&rev_ring[(rev_head + (n)) % rev_ring_size])
+
+
+
+/*
+ *  Save and compare CPU registers
+ */
+static void rev_save_regs (PREV_CHECKPOINT cp)
+{
+    cp->count = cpu_instr_count;
+    cp->KRA = regKRA;  cp->RA = regRA;  cp->SMA = regSMA;
+    cp->SW  = trgSW;   cp->ROP = regROP;
+    cp->RK  = regRK;   cp->RR = regRR;  cp->P1 = regP1;  cp->P2 = regP2;
+    cp->old_op = old_opcode;
+    cp->io_op = ext_io_op;             cp->io_zone = ext_io_dev_zone_addr;
+    cp->io_start = ext_io_ram_start;   cp->io_end = ext_io_ram_end;
+    cp->io_jump = ext_io_ram_jump;     cp->io_chksum = ext_io_ram_chksum;
+}
+
+static void rev_load_regs (PREV_CHECKPOINT cp)
+{
+    cpu_instr_count = cp->count;
+    regKRA = cp->KRA;  regRA = cp->RA;  regSMA = cp->SMA;
+    trgSW  = cp->SW;   regROP = cp->ROP;
+    regRK  = cp->RK;   regRR = cp->RR;  regP1 = cp->P1;  regP2 = cp->P2;
+    old_opcode = cp->old_op;
+    ext_io_op = cp->io_op;             ext_io_dev_zone_addr = cp->io_zone;
+    ext_io_ram_start = cp->io_start;   ext_io_ram_end = cp->io_end;
+    ext_io_ram_jump = cp->io_jump;     ext_io_ram_chksum = cp->io_chksum;
+}
+
+static int rev_same_regs (PREV_CHECKPOINT cp)
+{
+    REV_CHECKPOINT  t;
+
+    rev_save_regs (&t);
+    return (t.KRA == cp->KRA) && (t.RA == cp->RA) && (t.SMA == cp->SMA) &&
+           (t.SW == cp->SW) && (t.ROP == cp->ROP) && (t.RK == cp->RK) &&
+           (t.RR == cp->RR) && (t.P1 == cp->P1) && (t.P2 == cp->P2) &&
+           (t.old_op == cp->old_op) && (t.io_op == cp->io_op) &&
+           (t.io_zone == cp->io_zone) && (t.io_start == cp->io_start) &&
+           (t.io_end == cp->io_end) && (t.io_jump == cp->io_jump) &&
+           (t.io_chksum == cp->io_chksum);
+}
+
+
+
+/*
+ *  Drop checkpoints from n (newest side) to the end of history
+ */
+static void rev_truncate (int n)
+{
+    int  i;
+
+    for( i=n; i<rev_num; i++ ) {
+        free (REV_SLOT(i)->delta);
+        REV_SLOT(i)->delta = NULL;
+        REV_SLOT(i)->delta_num = 0;
+    }
+    if (n < rev_num) rev_num = n;
+}
+
+
+
+/*
+ *  Forget all history
+ */
+void rev_reset (void)
+{
+    rev_truncate (0);
+    rev_head = 0;
+    rev_next = 0;
+}
+
+
+
+/*
+ *  Take checkpoint at current instruction
+ */
+void rev_checkpoint (void)
+{
+    PREV_CHECKPOINT  cp;
+    int  i, n;
+
+    if (rev_depth < 2) rev_depth = 2;
+    if (rev_interval < 1) rev_interval = 1;
+
+    /* history ring must be reallocated with new depth */
+    if (rev_ring_size != rev_depth) {
+        rev_reset ();
+        free (rev_ring);
+        rev_ring = (PREV_CHECKPOINT) calloc (rev_depth, sizeof(REV_CHECKPOINT));
+        rev_ring_size = (rev_ring == NULL) ? 0 : rev_depth;
+        if (rev_ring == NULL) return;
+    }
+
+    rev_next = cpu_instr_count + rev_interval;
+
+    if (rev_num > 0) {
+        cp = REV_SLOT(rev_num-1);
+        if (cp->count == cpu_instr_count) {
+            /* state was changed without execution */
+            if (!rev_same_regs (cp) || memcmp (rev_shadow, MOSU, sizeof(MOSU)))
+                rev_reset ();
+            else
+                return;
+        }
+    }
+
+    if (rev_num > 0) {
+        /* store differences from this point back to previous checkpoint */
+        cp = REV_SLOT(rev_num-1);
+        n = 0;
+        for( i=0; i<MAX_MEM_SIZE; i++ ) {
+            if (rev_shadow[i] != MOSU[i]) rev_delta_buf[n++] = i;
+        }
+        if (n > 0) {
+            cp->delta = (PREV_DELTA) malloc (n * sizeof(REV_DELTA));
+            if (cp->delta == NULL) { rev_reset (); goto first; }
+            for( i=0; i<n; i++ ) {
+                cp->delta[i].addr = (uint16)rev_delta_buf[i];
+                cp->delta[i].val  = rev_shadow[rev_delta_buf[i]];
+            }
+        }
+        cp->delta_num = n;
+        if (rev_num == rev_ring_size) {
+            /* drop oldest checkpoint */
+            free (REV_SLOT(0)->delta);
+            REV_SLOT(0)->delta = NULL;
+            REV_SLOT(0)->delta_num = 0;
+            rev_head = (rev_head + 1) % rev_ring_size;
+            rev_num--;
+        }
+    }
+
+  first:
+    cp = REV_SLOT(rev_num);
+    rev_save_regs (cp);
+    cp->delta = NULL;
+    cp->delta_num = 0;
+    rev_num++;
+    memcpy (rev_shadow, MOSU, sizeof(MOSU));
+}
+
+
+
+/*
+ *  Called after every executed instruction
+ */
+void rev_after_inst (int op)
+{
+    switch (op) {
+      case OPCODE_INPUT_CODES_FROM_PUNCH_CARDS_WITH_STOP:
+      case OPCODE_INPUT_CODES_FROM_PUNCH_CARDS:
+      case OPCODE_IO_EXT_DEV_TO_MEM_070:
+        /* external devices can't be rewound */
+        rev_reset ();
+        rev_checkpoint ();
+        return;
+      default:
+        break;
+    }
+    if (cpu_instr_count >= rev_next) rev_checkpoint ();
+}
+
+
+
+/*
+ *  Called on start and stop of simulation
+ */
+void rev_run_start (void)
+{
+    if (!rev_enable) { rev_reset (); return; }
+    rev_checkpoint ();
+}
+
+void rev_run_stop (void)
+{
+    if (!rev_enable) return;
+    rev_checkpoint ();
+}
+
+
+
+/*
+ *  Restore checkpoint n (memory and registers)
+ */
+static void rev_restore (int n)
+{
+    PREV_CHECKPOINT  cp;
+    int  i, j;
+
+    memcpy (MOSU, rev_shadow, sizeof(MOSU));
+    for( i=rev_num-2; i>=n; i-- ) {
+        cp = REV_SLOT(i);
+        for( j=0; j<cp->delta_num; j++ ) MOSU[cp->delta[j].addr] = cp->delta[j].val;
+    }
+    rev_load_regs (REV_SLOT(n));
+}
+
+
+
+/*
+ *  Deterministic re-execution up to instruction number
+ *  (without trace, statistics and breakpoints)
+ */
+static t_stat rev_replay (t_uint64 target)
+{
+    FILE *  save_deb = sim_deb;
+    uint32  save_brk = sim_brk_summ;
+    int     save_stat = print_sys_stat;
+    t_int64 save_delay = delay;
+    t_stat  r = SCPE_OK;
+
+    sim_deb = NULL;
+    sim_brk_summ = 0;
+    print_sys_stat = 0;
+    while (cpu_instr_count < target) {
+        if (regKRA >= MAX_MEM_SIZE) { r = STOP_RUNOUT; break; }
+        regRK = MOSU[regKRA];
+        cpu_exec_inst ();
+    }
+    sim_deb = save_deb;
+    sim_brk_summ = save_brk;
+    print_sys_stat = save_stat;
+    delay = save_delay;
+
+    return r;
+}
+
+
+
+/*
+ *  Go to instruction number using checkpoint n, future is discarded
+ */
+static t_stat rev_goto (int n, t_uint64 target)
+{
+    t_stat  r;
+
+    rev_restore (n);
+    rev_truncate (n+1);
+    free (REV_SLOT(n)->delta);
+    REV_SLOT(n)->delta = NULL;
+    REV_SLOT(n)->delta_num = 0;
+    memcpy (rev_shadow, MOSU, sizeof(MOSU));
+    r = rev_replay (target);
+    rev_checkpoint ();
+
+    return r;
+}
+
+
+
+/*
+ *  Find newest checkpoint before instruction number
+ */
+static int rev_find (t_uint64 target)
+{
+    int  i;
+
+    for( i=rev_num-1; i>0; i-- ) {
+        if (REV_SLOT(i)->count <= target) break;
+    }
+    return i;
+}
+
+
+
+/*
+ *  Print new position
+ */
+static void rev_print_position (void)
+{
+    t_value  w;
+
+    printf ("KRA: %04o  (instruction %.0f)  ", regKRA, (double)cpu_instr_count);
+    if (regKRA < MAX_MEM_SIZE) {
+        w = MOSU[regKRA];
+        fprint_sym (stdout, regKRA, &w, NULL, SWMASK ('M'));
+    }
+    printf ("\n");
+}
+
+
+
+/*
+ *  BSTEP command
+ */
+t_stat rev_bstep_cmd (int32 flag, CONST char *cptr)
+{
+    t_stat  r;
+    t_uint64  n = 1, target;
+
+    if (rev_num == 0) return sim_messagef (SCPE_NOFNC, "No execution history\n");
+
+    if (*cptr) {
+        n = (t_uint64) get_uint (cptr, 10, 0xffffffff, &r);
+        if (r != SCPE_OK) return SCPE_ARG;
+    }
+    target = (cpu_instr_count > n) ? cpu_instr_count - n : 0;
+    if (target < REV_SLOT(0)->count) {
+        printf ("Start of execution history reached\n");
+        target = REV_SLOT(0)->count;
+    }
+
+    r = rev_goto (rev_find (target), target);
+    rev_print_position ();
+
+    return r;
+}
+
+
+
+/*
+ *  BRUN command
+ */
+t_stat rev_brun_cmd (int32 flag, CONST char *cptr)
+{
+    char  gbuf[CBUFSIZE];
+    t_stat  r;
+    t_uint64  cur, seg_end, hit, p;
+    int  i, watch = 0, addr = -1;
+    t_value  prev;
+
+    if (rev_num == 0) return sim_messagef (SCPE_NOFNC, "No execution history\n");
+
+    if (*cptr) {
+        cptr = get_glyph (cptr, gbuf, 0);
+        if (strcmp (gbuf, "WATCH") == 0) {
+            watch = 1;
+            cptr = get_glyph (cptr, gbuf, 0);
+        }
+        addr = (int) get_uint (gbuf, 8, MAX_ADDR_VALUE, &r);
+        if ((r != SCPE_OK) || *cptr) return SCPE_ARG;
+    }
+
+    cur = cpu_instr_count;
+    for( i=rev_num-1; (i>=0) && (addr >= 0); i-- ) {
+        seg_end = (i == rev_num-1) ? cur : REV_SLOT(i+1)->count;
+        if (seg_end > cur) seg_end = cur;
+        rev_restore (i);
+        hit = 0;
+        p = cpu_instr_count;
+        prev = MOSU[addr];
+        for (;;) {
+            if (!watch && (regKRA == addr) && (p < cur)) hit = p + 1;
+            if (watch && (MOSU[addr] != prev) && (p < cur)) hit = p + 1;
+            prev = MOSU[addr];
+            if (p >= seg_end) break;
+            if (rev_replay (p + 1) != SCPE_OK) break;
+            p = cpu_instr_count;
+        }
+        if (hit) {
+            r = rev_goto (i, hit - 1);
+            rev_print_position ();
+            return r;
+        }
+    }
+
+    if (addr >= 0) printf ("Start of execution history reached\n");
+    r = rev_goto (0, REV_SLOT(0)->count);
+    rev_print_position ();
+
+    return r;
+}
+
+
+
+/*
+ *  Show execution history
+ */
+t_stat rev_show_history (FILE *st, UNIT *uptr, int32 val, CONST void *desc)
+{
+    int  i;
+    double  words = 0;
+
+    for( i=0; i<rev_num; i++ ) words += REV_SLOT(i)->delta_num;
+
+    fprintf (st, "reverse execution %s, interval=%d, depth=%d\n",
+             rev_enable ? "enabled" : "disabled", rev_interval, rev_depth );
+    if (rev_num == 0) {
+        fprintf (st, "no execution history\n");
+        return SCPE_OK;
+    }
+    fprintf (st, "checkpoints=%d, instructions=%.0f-%.0f, delta_words=%.0f, memory=%.0f bytes\n",
+             rev_num, (double)REV_SLOT(0)->count, (double)REV_SLOT(rev_num-1)->count,
+             words, words*sizeof(REV_DELTA) + sizeof(rev_shadow) + rev_ring_size*sizeof(REV_CHECKPOINT) );
+
+    return SCPE_OK;
+}
@@ -10,6 +10,7 @@
  *
  *  15-Dec-2014  DVS  Initial Implemementation
  *  29-Jun-2021  DVS  Changed sim_stop_messages definitions
+ *  19-Oct-2026  DVS  Added run limit stop messages
  *
  */
 
@@ -31,6 +32,7 @@ const char *sim_stop_messages[SCPE_BASE] = {
 	"९  㬭",			/* Multiplication overflow */
 	"९  ",			/* Division overflow */
 	"९   ",		/* Division mantissa overflow */
+	"  ",				/* Division by zero */
 	"७  ⥫쭮 ᫠",		/* SQRT from negative number */
 	"訡 ᫥ ",			/* SQRT error */
 	"訡 ⥭ ࠡ",			/* Drum read error */
@@ -84,6 +86,9 @@ const char *sim_stop_messages[SCPE_BASE] = {
 	" ⠢ ०   ⭮ ",/* tape not in write mode */
 	" ⠢ ० ⥭  ⭮ ",/* tape not in read mode */
 	"訡  ",                       /* one more logical tapes mapped to one physical tape */
+	"௠  ᫠ ",          /* instruction limit reached */
+	"௠  ६ -20",          /* emulated time limit reached */
+	"௠  ६ (஦ ⠩)", /* host time limit reached (watchdog) */
     };
 
 
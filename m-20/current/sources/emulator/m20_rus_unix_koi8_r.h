@@ -10,6 +10,7 @@
  *
  *  19-Jan-2015  DVS  Initial Implemementation
  *  29-Jun-2021  DVS  Changed sim_stop_messages definitions
+ *  19-Oct-2026  DVS  Added run limit stop messages
  *
  */
 
@@ -86,6 +87,9 @@ const char *sim_stop_messages[SCPE_BASE] = {
 	"      ",/* tape not in write mode */
 	"      ",/* tape not in read mode */
 	"  ",                       /* one more logical tapes mapped to one physical tape */
+	"   ",          /* instruction limit reached */
+	"   -20",          /* emulated time limit reached */
+	"   ( )", /* host time limit reached (watchdog) */
     };
 
 
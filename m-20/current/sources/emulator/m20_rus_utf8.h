@@ -10,6 +10,7 @@
  *
  *  19-Jan-2015  DVS  Initial Implemementation
  *  29-Jun-2021  DVS  Changed sim_stop_messages definitions
+ *  19-Oct-2026  DVS  Added run limit stop messages
  *
  */
 
@@ -31,6 +32,7 @@ const char *sim_stop_messages[SCPE_BASE] = {
 	"Переполнение при умножении",			/* Multiplication overflow */
 	"Переполнение при делении",			/* Division overflow */
 	"Переполнение мантиссы при делении",		/* Division mantissa overflow */
+	"Деление на нуль",				/* Division by zero */
 	"Корень из отрицательного числа",		/* SQRT from negative number */
 	"Ошибка вычисления корня",			/* SQRT error */
 	"Ошибка чтения барабана",			/* Drum read error */
@@ -84,6 +86,9 @@ const char *sim_stop_messages[SCPE_BASE] = {
 	"Не выставлен режим записи для магнитной ленты",/* tape not in write mode */
 	"Не выставлен режим чтения для магнитной ленты",/* tape not in read mode */
 	"ошибка коммутация лент",                       /* one more logical tapes mapped to one physical tape */
+	"Исчерпан лимит числа команд",          /* instruction limit reached */
+	"Исчерпан лимит времени М-20",          /* emulated time limit reached */
+	"Исчерпан лимит времени (сторожевой таймер)", /* host time limit reached (watchdog) */
     };
 
 
@@ -17,6 +17,7 @@
  *  03-Dec-2014  DVS  Updated long form of symbolic instructions
  *  05-Dec-2014  DVS  Updated
  *  29-Jun-2021  DVS  Changed sim_stop_messages definitions
+ *  19-Oct-2026  DVS  Added run limit stop messages
  *
  */
 
@@ -93,6 +94,9 @@ const char *sim_stop_messages[SCPE_BASE] = {
 	"      ",/* tape not in write mode */
 	"      ",/* tape not in read mode */
 	"  ",                       /* one more logical tapes mapped to one physical tape */
+	"   ",          /* instruction limit reached */
+	"   -20",          /* emulated time limit reached */
+	"   ( )", /* host time limit reached (watchdog) */
     };
 
 
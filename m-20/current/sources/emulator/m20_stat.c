@@ -0,0 +1,300 @@
+/*
+ * File:     m20_stat.c
+ * Purpose:  M-20 simulator run statistics (emulated vs. host time)
+ *
+ * Copyright (c) 2026, Dmitry Stefankov
+ *
+ * $Id$
+ *
+ * Statistics are counted from last RESET STATS (or simulator start):
+ * executed instructions, emulated time (sum of instruction delays, usec),
+ * host time of simulation (only while CPU is running), MIPS, speedup
+ * over real M-20 (emulated time / host time) and operations, words and
+ * emulated time of every external device.  Peak resident set size of
+ * simulator process is added where host tells it (not on Windows).
+ * Instructions skipped by idle loop fast-forward (IDLE) are not executed
+ * by host, they are shown apart and are not in instructions and MIPS.
+ *
+ * Commands:
+ *   SHOW STATS (or STATS)      print statistics
+ *   RESET STATS                clear statistics
+ *   STATS FILE file [sec]      append statistics to file every sec seconds
+ *                              of host time (default 10) and on every stop
+ *   STATS FILE OFF             stop writing of statistics file
+ *
+ * Line of statistics file is a list of key=value pairs, separated by
+ * spaces; keys are never removed or renamed, new keys are appended:
+ *
+ *   time=... instructions=... emul_us=... host_ns=... mips=... speedup=...
+ *   drum.ops=... drum.words=... drum.emul_us=... tape.ops=... ...
+ *   maxrss_kb=... idle_skip=...
+ *
+ * Revision History.
+ *
+ *  19-Oct-2026  DVS  Initial Implementation
+ *  19-Oct-2026  DVS  Instructions skipped by idle fast-forward apart (idle_skip)
+ *
+ */
+
+#include "m20_defs.h"
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+
+/* CPU module references */
+
+extern t_uint64 cpu_instr_count;
+extern t_uint64 cpu_tick_count;
+extern t_uint64 idle_skip_count;
+
+
+#define  STAT_FILE_INTERVAL   10		/* default file interval, sec */
+#define  STAT_CHECK_COUNT     4096		/* instructions between host time checks */
+
+
+/* Device statistics */
+typedef  struct stat_io {
+    t_uint64  ops;
+    t_uint64  words;
+    double    emul_us;
+} STAT_IO;
+
+
+static const char * stat_io_name[STAT_IO_NUM] = {
+    "drum", "tape", "card", "printer", "punch"
+};
+
+static STAT_IO   stat_io[STAT_IO_NUM];
+static t_uint64  stat_base_instr = 0;	/* counters at RESET STATS */
+static t_uint64  stat_base_ticks = 0;
+static t_uint64  stat_base_skip = 0;
+static double    stat_host = 0;		/* host time of finished runs, sec */
+static double    stat_run_start = 0;	/* host time of current run start */
+static int       stat_running = 0;
+
+static FILE *    stat_file = NULL;
+static char      stat_file_name[CBUFSIZE] = "";
+static int32     stat_file_sec = STAT_FILE_INTERVAL;
+static uint32    stat_file_next;	/* host msec of next line */
+t_uint64         stat_file_check = 0;	/* instruction of next check, 0 = no file */
+
+
+
+/*
+ *  Collection
+ */
+void m20_stat_io (int dev, int words, double emul_us)
+{
+    if ((dev < 0) || (dev >= STAT_IO_NUM)) return;
+    stat_io[dev].ops++;
+    stat_io[dev].words += (words > 0) ? words : 0;
+    stat_io[dev].emul_us += emul_us;
+}
+
+
+/* Peak resident set size of process, KB (0 - unknown) */
+static t_uint64 m20_stat_maxrss_kb (void)
+{
+#if !defined(_WIN32)
+    struct rusage  ru;
+
+    if (getrusage (RUSAGE_SELF, &ru) != 0) return 0;
+#if defined(__APPLE__)
+    return (t_uint64) ru.ru_maxrss / 1024;	/* bytes on macOS */
+#else
+    return (t_uint64) ru.ru_maxrss;
+#endif
+#else
+    return 0;
+#endif
+}
+
+
+static double m20_stat_host_sec (void)
+{
+    if (stat_running) return stat_host + (sim_timenow_double () - stat_run_start);
+    return stat_host;
+}
+
+
+void m20_stat_reset (void)
+{
+    memset (stat_io, 0, sizeof(stat_io));
+    stat_base_instr = cpu_instr_count;
+    stat_base_ticks = cpu_tick_count;
+    stat_base_skip = idle_skip_count;
+    stat_host = 0;
+    if (stat_running) stat_run_start = sim_timenow_double ();
+}
+
+
+
+/*
+ *  Output
+ */
+static void m20_stat_counts (t_uint64 *instr, t_uint64 *emul, t_uint64 *skip)
+{
+    /* instruction counter goes back on BSTEP/BRUN */
+    *instr = (cpu_instr_count > stat_base_instr) ? cpu_instr_count - stat_base_instr : 0;
+    *emul  = (cpu_tick_count > stat_base_ticks) ? cpu_tick_count - stat_base_ticks : 0;
+    *skip  = (idle_skip_count > stat_base_skip) ? idle_skip_count - stat_base_skip : 0;
+    *instr = (*instr > *skip) ? *instr - *skip : 0;	/* executed by host */
+}
+
+
+static void m20_stat_print (FILE *st)
+{
+    t_uint64 instr, emul, skip, rss;
+    double   host, mips, speedup;
+    int      i;
+
+    m20_stat_counts (&instr, &emul, &skip);
+    host  = m20_stat_host_sec ();
+    mips    = (host > 0) ? instr / host / 1000000.0 : 0;
+    speedup = (host > 0) ? emul / host / 1000000.0 : 0;
+
+    fprintf (st, "Instructions:     %llu\n", instr);
+    if (skip != 0)
+        fprintf (st, "Idle skipped:     %llu\n", skip);
+    fprintf (st, "Emulated time:    %.6f s\n", emul / 1000000.0);
+    fprintf (st, "Host time:        %.6f s\n", host);
+    fprintf (st, "MIPS:             %.3f\n", mips);
+    fprintf (st, "Speedup:          %.1f x real M-20\n", speedup);
+    if ((rss = m20_stat_maxrss_kb ()) != 0)
+        fprintf (st, "Peak RSS:         %llu KB\n", rss);
+    fprintf (st, "\n");
+    fprintf (st, "Device        Operations       Words  Emulated time, s\n");
+    for (i = 0; i < STAT_IO_NUM; i++) {
+        fprintf (st, "%-10s  %12llu  %10llu  %16.6f\n", stat_io_name[i],
+                 stat_io[i].ops, stat_io[i].words, stat_io[i].emul_us / 1000000.0);
+    }
+}
+
+
+static void m20_stat_line (FILE *st)
+{
+    t_uint64 instr, emul, skip;
+    double   host;
+    int      i;
+
+    m20_stat_counts (&instr, &emul, &skip);
+    host  = m20_stat_host_sec ();
+
+    fprintf (st, "time=%ld instructions=%llu emul_us=%llu host_ns=%.0f mips=%.3f speedup=%.3f",
+             (long) time (NULL), instr, emul, host * 1e9,
+             (host > 0) ? instr / host / 1000000.0 : 0,
+             (host > 0) ? emul / host / 1000000.0 : 0);
+    for (i = 0; i < STAT_IO_NUM; i++) {
+        fprintf (st, " %s.ops=%llu %s.words=%llu %s.emul_us=%.0f",
+                 stat_io_name[i], stat_io[i].ops, stat_io_name[i], stat_io[i].words,
+                 stat_io_name[i], stat_io[i].emul_us);
+    }
+    fprintf (st, " maxrss_kb=%llu idle_skip=%llu\n", m20_stat_maxrss_kb (), skip);
+    fflush (st);
+}
+
+
+t_stat m20_stat_show (FILE *st)
+{
+    m20_stat_print (st);
+    return SCPE_OK;
+}
+
+
+
+/*
+ *  Periodic statistics file
+ */
+void m20_stat_check (void)
+{
+    stat_file_check = cpu_instr_count + STAT_CHECK_COUNT;
+    if ((stat_file == NULL) || ((int32) (sim_os_msec () - stat_file_next) < 0)) return;
+    m20_stat_line (stat_file);
+    stat_file_next = sim_os_msec () + stat_file_sec * 1000;
+}
+
+
+static void m20_stat_file_close (void)
+{
+    if (stat_file == NULL) return;
+    fclose (stat_file);
+    stat_file = NULL;
+    stat_file_name[0] = 0;
+    stat_file_check = 0;
+}
+
+
+/*
+ *  Called on start and stop of simulation
+ */
+void m20_stat_run_start (void)
+{
+    stat_run_start = sim_timenow_double ();
+    stat_running = 1;
+    if (stat_file != NULL) {
+        stat_file_check = cpu_instr_count + STAT_CHECK_COUNT;
+        stat_file_next = sim_os_msec () + stat_file_sec * 1000;
+    }
+}
+
+
+void m20_stat_run_stop (void)
+{
+    if (!stat_running) return;
+    stat_host += sim_timenow_double () - stat_run_start;
+    stat_running = 0;
+    if (stat_file != NULL) m20_stat_line (stat_file);
+}
+
+
+
+/*
+ *  STATS command
+ */
+t_stat m20_stat_cmd (int32 flag, CONST char *cptr)
+{
+    char  gbuf[CBUFSIZE];
+    t_stat r;
+    int32 sec;
+
+    cptr = get_glyph (cptr, gbuf, 0);
+    if (gbuf[0] == 0) {
+        m20_stat_print (stdout);
+        if (sim_log && (sim_log != stdout)) m20_stat_print (sim_log);
+        return SCPE_OK;
+    }
+    if (strcmp (gbuf, "FILE") != 0) return SCPE_ARG;
+
+    cptr = get_glyph_nc (cptr, gbuf, 0);
+    if (gbuf[0] == 0) {
+        if (stat_file == NULL) printf ("Statistics file is not open\n");
+        else printf ("Statistics file: %s, every %d s\n", stat_file_name, stat_file_sec);
+        return SCPE_OK;
+    }
+    if (strcasecmp (gbuf, "OFF") == 0) {
+        if (*cptr) return SCPE_2MARG;
+        m20_stat_file_close ();
+        return SCPE_OK;
+    }
+
+    sec = STAT_FILE_INTERVAL;
+    if (*cptr) {
+        char  nbuf[CBUFSIZE];
+
+        cptr = get_glyph (cptr, nbuf, 0);
+        sec = (int32) get_uint (nbuf, 10, 86400, &r);
+        if ((r != SCPE_OK) || (sec == 0)) return SCPE_ARG;
+        if (*cptr) return SCPE_2MARG;
+    }
+
+    m20_stat_file_close ();
+    stat_file = sim_fopen (gbuf, "a");
+    if (stat_file == NULL) return SCPE_OPENERR;
+    strcpy (stat_file_name, gbuf);
+    stat_file_sec = sec;
+    stat_file_check = cpu_instr_count + STAT_CHECK_COUNT;
+    stat_file_next = sim_os_msec () + stat_file_sec * 1000;
+    return SCPE_OK;
+}
@@ -0,0 +1,472 @@
+/*
+ * File:     m20_sweep.c
+ * Purpose:  M-20 simulator sweeps of jobs in forked processes
+ *
+ * Copyright (c) 2026, Dmitry Stefankov
+ *
+ * $Id$
+ *
+ * Sweep runs many jobs of one loaded program.  The program is run once
+ * to the ready address (usually the point after loading and setup),
+ * then the emulator process is forked once per job: every child starts
+ * with copy of MOSU, registers and devices of the parent, applies its
+ * job settings (key registers, card deck, drum images), runs the
+ * program to the stop and writes printer output into its own file.
+ * Results of children (stop, KRA, instructions, emulated time) are
+ * passed to the parent through shared memory and printed as table.
+ *
+ * Host files of attached units are shared between parent and children,
+ * so every child copies images of attached input units (drums, tapes,
+ * card reader) into private temporary files before the run.  Memory
+ * files (mem:name) are private already.  Tape units can't be attached
+ * by jobs, because detach of tape container writes the container file.
+ *
+ * Job file:  one job per line, '#' and ';' start comments,
+ *   name {key=value} ...
+ *   rpu1 .. rpu4 = octal   values of key registers RPU1..RPU4
+ *   cdr = file             card deck
+ *   drumN = file           drum image
+ *   lpt = file             printer output (default name.lst)
+ *   cdp = file             punch output (default name.cdp, if attached)
+ *
+ * Commands:
+ *   SWEEP [-R addr] [-P n] [-I n] [-T time] [-W time] jobfile
+ *
+ *   -R addr   run to ready address before fork (default: current state)
+ *   -P n      parallel children (default: number of host processors)
+ *   -I -T -W  limits of every job run (as for RUN)
+ *
+ * Sweep isn't available on Windows hosts (no fork()).
+ *
+ * Revision History.
+ *
+ *  19-Oct-2026  DVS  Initial Implementation
+ *
+ */
+
+#include "m20_defs.h"
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#endif
+
+
+/* CPU module references */
+
+extern uint16   regKRA;
+extern t_value  RPU1, RPU2, RPU3, RPU4;
+extern t_uint64 cpu_instr_count;
+extern t_uint64 cpu_tick_count;
+
+extern DEVICE   cdp_dev;
+extern DEVICE   lpt_dev;
+extern DEVICE   mt_dev;
+
+extern t_stat cpu_run_cmd (int32 flag, CONST char *cptr);
+extern t_stat sim_brk_set (t_addr loc, int32 sw, int32 ncnt, CONST char *act);
+extern t_stat sim_brk_clr (t_addr loc, int32 sw);
+
+
+#define  SWEEP_NAME_SIZE    64
+#define  SWEEP_MAX_JOBS     4096
+#define  SWEEP_MAX_PAR      256
+
+
+/* Job of sweep */
+typedef  struct sweep_job {
+    char       name[SWEEP_NAME_SIZE];
+    char      *args;		/* key=value settings */
+} SWEEP_JOB, * PSWEEP_JOB;
+
+/* Result of job, written by child into shared memory */
+typedef  struct sweep_result {
+    int        done;		/* child has finished run */
+    t_stat     r;		/* stop code */
+    uint16     KRA;
+    t_uint64   count;		/* instructions executed */
+    t_uint64   ticks;		/* emulated time, usec */
+    int        status;		/* waitpid() status */
+    pid_t      pid;
+} SWEEP_RESULT, * PSWEEP_RESULT;
+
+
+static SWEEP_JOB *sweep_jobs;
+static int        sweep_num;
+
+
+
+/*
+ *  Read job file
+ */
+static void sweep_free (void)
+{
+    int i;
+
+    for (i = 0; i < sweep_num; i++) free (sweep_jobs[i].args);
+    free (sweep_jobs);
+    sweep_jobs = NULL;
+    sweep_num = 0;
+}
+
+static t_stat sweep_job_apply (PSWEEP_JOB job, int apply);
+
+static t_stat sweep_read (const char *fname)
+{
+    FILE      *f;
+    char       line[CBUFSIZE], gbuf[CBUFSIZE];
+    char      *p, *e;
+    CONST char *cptr;
+    int        lineno = 0;
+    t_stat     r;
+
+    f = fopen (fname, "r");
+    if (f == NULL) return SCPE_OPENERR;
+    sweep_jobs = (SWEEP_JOB *) calloc (SWEEP_MAX_JOBS, sizeof (SWEEP_JOB));
+    if (sweep_jobs == NULL) {
+        fclose (f);
+        return SCPE_MEM;
+    }
+    while (fgets (line, sizeof (line), f) != NULL) {
+        lineno++;
+        for (p = line; *p && (*p != '#') && (*p != ';'); p++) ;
+        *p = 0;
+        for (e = line; *e && isspace ((unsigned char) *e); e++) ;
+        if (*e == 0) continue;
+        if (sweep_num >= SWEEP_MAX_JOBS) {
+            fclose (f);
+            return SCPE_2MARG;
+        }
+        cptr = get_glyph_nc (e, gbuf, 0);
+        if ((strchr (gbuf, '=') != NULL) || (strlen (gbuf) >= SWEEP_NAME_SIZE)) {
+            printf ("Sweep: bad job name at line %d\n", lineno);
+            fclose (f);
+            return SCPE_ARG;
+        }
+        strcpy (sweep_jobs[sweep_num].name, gbuf);
+        sweep_jobs[sweep_num].args = (char *) malloc (strlen (cptr) + 1);
+        if (sweep_jobs[sweep_num].args == NULL) {
+            fclose (f);
+            return SCPE_MEM;
+        }
+        strcpy (sweep_jobs[sweep_num].args, cptr);
+        sweep_num++;
+        r = sweep_job_apply (&sweep_jobs[sweep_num - 1], FALSE);
+        if (r != SCPE_OK) {
+            printf ("Sweep: bad settings of job %s at line %d\n", gbuf, lineno);
+            fclose (f);
+            return r;
+        }
+    }
+    fclose (f);
+    return (sweep_num > 0) ? SCPE_OK : SCPE_2FARG;
+}
+
+
+
+/*
+ *  Check (apply = FALSE) or apply settings of job
+ */
+static t_stat sweep_attach (const char *dev, const char *file, int32 sw)
+{
+    char   cmd[CBUFSIZE];
+    t_stat r;
+
+    snprintf (cmd, sizeof (cmd), "%s %s", dev, file);
+    sim_switches = sw | SWMASK ('Q');		/* quiet */
+    r = attach_cmd (0, cmd);
+    sim_switches = 0;
+    return SCPE_BARE_STATUS (r);
+}
+
+static t_stat sweep_job_apply (PSWEEP_JOB job, int apply)
+{
+    char       gbuf[CBUFSIZE], fname[CBUFSIZE];
+    char      *val, *p;
+    CONST char *cptr = job->args;
+    CONST char *tptr;
+    t_value    v;
+    DEVICE    *dptr;
+    UNIT      *uptr;
+    int        lpt_set = FALSE, cdp_set = FALSE;
+    t_stat     r;
+
+    while (*cptr) {
+        cptr = get_glyph_nc (cptr, gbuf, 0);
+        val = strchr (gbuf, '=');
+        if ((val == NULL) || (val == gbuf) || (val[1] == 0)) return SCPE_ARG;
+        *val++ = 0;
+        for (p = gbuf; *p; p++) *p = (char) toupper ((unsigned char) *p);
+        if ((strlen (gbuf) == 4) && (strncmp (gbuf, "RPU", 3) == 0) &&
+            (gbuf[3] >= '1') && (gbuf[3] <= '4')) {
+            v = (t_value) strtotv (val, &tptr, 8);
+            if ((tptr == val) || (*tptr != 0) || (v & ~WORD45)) return SCPE_ARG;
+            if (!apply) continue;
+            switch (gbuf[3]) {
+            case '1':  RPU1 = v;  break;
+            case '2':  RPU2 = v;  break;
+            case '3':  RPU3 = v;  break;
+            default:   RPU4 = v;  break;
+            }
+            continue;
+        }
+        dptr = find_unit (gbuf, &uptr);
+        if ((dptr == NULL) || (uptr == NULL) || (dptr == &mt_dev) ||
+            !(uptr->flags & UNIT_ATTABLE)) return SCPE_ARG;
+        if (dptr == &lpt_dev) lpt_set = TRUE;
+        if (dptr == &cdp_dev) cdp_set = TRUE;
+        if (!apply) continue;
+        r = sweep_attach (gbuf, val,
+                          ((dptr == &lpt_dev) || (dptr == &cdp_dev)) ? SWMASK ('N') : 0);
+        if (r != SCPE_OK) return r;
+    }
+    if (!apply) return SCPE_OK;
+
+    /* own printer and punch output */
+    if (!lpt_set) {
+        snprintf (fname, sizeof (fname), "%s.lst", job->name);
+        r = sweep_attach ("LPT", fname, SWMASK ('N'));
+        if (r != SCPE_OK) return r;
+    }
+    if (!cdp_set && (cdp_dev.units->flags & UNIT_ATT)) {
+        snprintf (fname, sizeof (fname), "%s.cdp", job->name);
+        r = sweep_attach ("CDP", fname, SWMASK ('N'));
+        if (r != SCPE_OK) return r;
+    }
+    return SCPE_OK;
+}
+
+
+
+#if !defined(_WIN32)
+
+/*
+ *  Child: copy host file of input unit into private temporary file
+ */
+static t_stat sweep_private_unit (UNIT *uptr)
+{
+    FILE     *f;
+    char      buf[8192];
+    off_t     pos;
+    ssize_t   n;
+    long      cur;
+    int       fd;
+
+    if (!(uptr->flags & UNIT_ATT) || (uptr->fileref == NULL)) return SCPE_OK;
+    fd = fileno (uptr->fileref);
+    if (fd < 0) return SCPE_OK;			/* memory file */
+    cur = ftell (uptr->fileref);
+    f = tmpfile ();
+    if (f == NULL) return SCPE_OPENERR;
+    for (pos = 0; (n = pread (fd, buf, sizeof (buf), pos)) > 0; pos += n) {
+        if (fwrite (buf, 1, (size_t) n, f) != (size_t) n) break;
+    }
+    if ((n != 0) || fflush (f) || (fseek (f, (cur > 0) ? cur : 0, SEEK_SET) != 0)) {
+        fclose (f);
+        return SCPE_IOERR;
+    }
+    uptr->fileref = f;				/* shared file stays open */
+    return SCPE_OK;
+}
+
+static t_stat sweep_private_units (void)
+{
+    DEVICE  *dptr;
+    uint32   i, u;
+    t_stat   r;
+
+    for (i = 0; (dptr = sim_devices[i]) != NULL; i++) {
+        if ((dptr == &lpt_dev) || (dptr == &cdp_dev)) continue;
+        for (u = 0; u < dptr->numunits; u++) {
+            r = sweep_private_unit (dptr->units + u);
+            if (r != SCPE_OK) return r;
+        }
+    }
+    return SCPE_OK;
+}
+
+
+
+/*
+ *  Child: run job and exit
+ */
+static void sweep_child (PSWEEP_JOB job, PSWEEP_RESULT res, const char *runsw)
+{
+    t_uint64  start_count, start_ticks;
+    t_stat    r;
+
+    r = sweep_private_units ();
+    if (r == SCPE_OK) r = sweep_job_apply (job, TRUE);
+    if (r == SCPE_OK) {
+        if (sim_brk_fnd (regKRA))		/* don't stop at ready address */
+            sim_brk_clr (regKRA, SWMASK ('E'));
+        start_count = cpu_instr_count;
+        start_ticks = cpu_tick_count;
+        r = cpu_run_cmd (RU_CONT, runsw);
+        res->count = cpu_instr_count - start_count;
+        res->ticks = cpu_tick_count - start_ticks;
+    }
+    res->r = r;
+    res->KRA = regKRA;
+    fflush (NULL);
+    res->done = TRUE;
+    _exit (0);
+}
+
+
+
+/*
+ *  Print results
+ */
+static const char *sweep_stop_text (t_stat r)
+{
+    r = SCPE_BARE_STATUS (r);
+    if ((r > 0) && (r < SCPE_BASE) && (sim_stop_messages[r] != NULL))
+        return sim_stop_messages[r];
+    return sim_error_text (r);
+}
+
+static void sweep_print (FILE *st, PSWEEP_RESULT res, int par, double host_sec)
+{
+    int   i, ok = 0;
+    char  buf[64];
+
+    for (i = 0; i < sweep_num; i++) if (res[i].done) ok++;
+    fprintf (st, "Sweep: %d jobs, %d finished, %d parallel, host time %.3f s\n",
+             sweep_num, ok, par, host_sec);
+    fprintf (st, "Job                KRA   Instructions  Time, s\n");
+    for (i = 0; i < sweep_num; i++) {
+        if (!res[i].done) {
+            if (res[i].pid < 0) snprintf (buf, sizeof (buf), "fork failed");
+            else if (WIFSIGNALED (res[i].status))
+                snprintf (buf, sizeof (buf), "killed by signal %d", WTERMSIG (res[i].status));
+            else snprintf (buf, sizeof (buf), "exit code %d", WEXITSTATUS (res[i].status));
+            fprintf (st, "%-16s   ----  %12s  %8s  %s\n", sweep_jobs[i].name, "", "", buf);
+            continue;
+        }
+        fprintf (st, "%-16s   %04o  %12.0f  %.6f  %s\n", sweep_jobs[i].name,
+                 res[i].KRA, (double) res[i].count, res[i].ticks / 1000000.0,
+                 sweep_stop_text (res[i].r));
+    }
+}
+
+#endif
+
+
+
+/*
+ *  SWEEP command
+ */
+t_stat m20_sweep_cmd (int32 flag, CONST char *cptr)
+{
+#if defined(_WIN32)
+    printf ("Sweep isn't supported on this host\n");
+    return SCPE_NOFNC;
+#else
+    char      gbuf[CBUFSIZE], runsw[CBUFSIZE], *tptr;
+    int       ready = -1, par, running, next, i;
+    int       had_brk, status;
+    uint32    start_msec;
+    double    v;
+    pid_t     pid;
+    PSWEEP_RESULT res;
+    t_stat    r;
+
+    par = (int) sysconf (_SC_NPROCESSORS_ONLN);
+    runsw[0] = 0;
+    while (*cptr == '-') {
+        cptr = get_glyph (cptr, gbuf, 0);
+        if (*cptr == 0) return SCPE_2FARG;
+        if (strcmp (gbuf, "-R") == 0) {
+            cptr = get_glyph (cptr, gbuf, 0);
+            ready = (int) strtotv (gbuf, (CONST char **) &tptr, 8);
+            if ((tptr == gbuf) || (*tptr != 0) || (ready > MAX_ADDR_VALUE)) return SCPE_ARG;
+        }
+        else if (strcmp (gbuf, "-P") == 0) {
+            cptr = get_glyph (cptr, gbuf, 0);
+            v = strtod (gbuf, &tptr);
+            if ((tptr == gbuf) || (*tptr != 0) || (v < 1) || (v > SWEEP_MAX_PAR)) return SCPE_ARG;
+            par = (int) v;
+        }
+        else if ((strcmp (gbuf, "-I") == 0) || (strcmp (gbuf, "-T") == 0) ||
+                 (strcmp (gbuf, "-W") == 0)) {
+            strlcat (runsw, gbuf, sizeof (runsw));
+            strlcat (runsw, " ", sizeof (runsw));
+            cptr = get_glyph (cptr, gbuf, 0);
+            strlcat (runsw, gbuf, sizeof (runsw));
+            strlcat (runsw, " ", sizeof (runsw));
+        }
+        else return SCPE_ARG;
+    }
+    if (*cptr == 0) return SCPE_2FARG;
+    if (par < 1) par = 1;
+
+    r = sweep_read (cptr);
+    if (r != SCPE_OK) {
+        sweep_free ();
+        return r;
+    }
+
+    /* run to ready address */
+    if (ready >= 0) {
+        had_brk = (sim_brk_fnd ((t_addr) ready) != NULL);
+        if (!had_brk) sim_brk_set ((t_addr) ready, SWMASK ('E'), 0, NULL);
+        r = cpu_run_cmd (RU_CONT, "");
+        if (!had_brk) sim_brk_clr ((t_addr) ready, SWMASK ('E'));
+        if ((r != STOP_IBKPT) || (regKRA != ready)) {
+            printf ("Sweep: ready address %04o isn't reached, %s, KRA: %04o\n",
+                    ready, sweep_stop_text (r), regKRA);
+            if (sim_log && (sim_log != stdout))
+                fprintf (sim_log, "Sweep: ready address %04o isn't reached, %s, KRA: %04o\n",
+                         ready, sweep_stop_text (r), regKRA);
+            sweep_free ();
+            return SCPE_OK;
+        }
+    }
+
+    res = (PSWEEP_RESULT) mmap (NULL, sweep_num * sizeof (SWEEP_RESULT),
+                                PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANON, -1, 0);
+    if (res == (PSWEEP_RESULT) MAP_FAILED) {
+        sweep_free ();
+        return SCPE_MEM;
+    }
+    memset (res, 0, sweep_num * sizeof (SWEEP_RESULT));
+
+    /* children inherit empty stdio buffers */
+    fflush (NULL);
+    start_msec = sim_os_msec ();
+    running = 0;
+    next = 0;
+    while ((next < sweep_num) || (running > 0)) {
+        while ((running < par) && (next < sweep_num)) {
+            pid = fork ();
+            if (pid == 0) sweep_child (&sweep_jobs[next], &res[next], runsw);
+            res[next].pid = pid;
+            if (pid > 0) running++;
+            next++;
+        }
+        if (running == 0) continue;
+        pid = waitpid (-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (i = 0; i < sweep_num; i++) {
+            if (res[i].pid != pid) continue;
+            res[i].status = status;
+            running--;
+            break;
+        }
+    }
+
+    sweep_print (stdout, res, par, (sim_os_msec () - start_msec) / 1000.0);
+    if (sim_log && (sim_log != stdout))
+        sweep_print (sim_log, res, par, (sim_os_msec () - start_msec) / 1000.0);
+
+    munmap ((void *) res, sweep_num * sizeof (SWEEP_RESULT));
+    sweep_free ();
+    return SCPE_OK;
+#endif
+}
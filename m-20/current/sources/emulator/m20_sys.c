@@ -29,6 +29,22 @@
  *  07-Dec-2014  DVS  Added decimal numbers input
  *  21-Dec-2014  DVS  Added opcode and modifiers for cpu trace output
  *  13-Mar-2015  DVS  Cleanup code
+ *  19-Oct-2026  DVS  Added simulator specific commands (reverse execution)
+ *  19-Oct-2026  DVS  Added PROFILE command
+ *  19-Oct-2026  DVS  Added symbol map (LOAD -S) and symbolic addresses
+ *  19-Oct-2026  DVS  Added binary object file loader
+ *  19-Oct-2026  DVS  Added MEMFILE command
+ *  19-Oct-2026  DVS  Added run limits for RUN, GO, CONTINUE, BOOT
+ *  19-Oct-2026  DVS  Added SHOW THROTTLE statistics of real time pacing
+ *  19-Oct-2026  DVS  Added STATS command, SHOW STATS and RESET STATS
+ *  19-Oct-2026  DVS  Added ENSEMBLE command
+ *  19-Oct-2026  DVS  Added SWEEP command
+ *  19-Oct-2026  DVS  Added HEATMAP command
+ *  19-Oct-2026  DVS  Added TRACE command
+ *  19-Oct-2026  DVS  Added PROFILE HOST
+ *  19-Oct-2026  DVS  Labels starting with @ in addresses
+ *  19-Oct-2026  DVS  Symbol map is cleared by binary object without map
+ *  19-Oct-2026  DVS  Symbol map is cleared by text memory image too
  *
  */
 
@@ -90,6 +106,96 @@ DEVICE *sim_devices[] = {
     };
 
 
+/*
+ * Simulator specific commands (sim_vm_cmd)
+ */
+
+extern t_stat rev_bstep_cmd (int32 flag, CONST char *cptr);
+extern t_stat rev_brun_cmd (int32 flag, CONST char *cptr);
+extern t_stat prof_cmd (int32 flag, CONST char *cptr);
+extern t_stat m20_mem_cmd (int32 flag, CONST char *cptr);
+extern t_stat cpu_run_cmd (int32 flag, CONST char *cptr);
+extern void   cpu_run_cmd_message (const char *unechoed_cmdline, t_stat r);
+extern t_stat cpu_show_cmd (int32 flag, CONST char *cptr);
+extern t_stat cpu_reset_cmd (int32 flag, CONST char *cptr);
+extern t_stat m20_stat_cmd (int32 flag, CONST char *cptr);
+extern t_stat m20_ens_cmd (int32 flag, CONST char *cptr);
+extern t_stat m20_sweep_cmd (int32 flag, CONST char *cptr);
+extern t_stat m20_heat_cmd (int32 flag, CONST char *cptr);
+extern t_stat m20_trace_cmd (int32 flag, CONST char *cptr);
+
+/* RESET, BOOT, BREAK and STEP are repeated to keep SCP abbreviations (R, B, BR, S) */
+CTAB m20_cmd[] = {
+    { "RESET", &cpu_reset_cmd, 0,
+      "r{eset} {ALL|<device>}   reset simulator\n"
+      "r{eset} STATS            clear run statistics (SHOW STATS)\n"
+      "r{eset} MEMORY HEATMAP   clear data access heatmap\n" },
+    { "RUN",   &cpu_run_cmd, RU_RUN,
+      "ru{n} {-I n} {-T time} {-W time} {new PC}\n"
+      "                         reset and start simulation with limits:\n"
+      "                         -I instructions, -T emulated time,\n"
+      "                         -W host time (time: n{US|MS|S|M|H})\n", NULL, &cpu_run_cmd_message },
+    { "GO",    &cpu_run_cmd, RU_GO,
+      "go {-I n} {-T time} {-W time} {new PC}\n"
+      "                         start simulation with limits\n", NULL, &cpu_run_cmd_message },
+    { "CONTINUE", &cpu_run_cmd, RU_CONT,
+      "c{ont} {-I n} {-T time} {-W time}\n"
+      "                         continue simulation with limits\n", NULL, &cpu_run_cmd_message },
+    { "BOOT",  &cpu_run_cmd, RU_BOOT,
+      "b{oot} {-I n} {-T time} {-W time} <unit>\n"
+      "                         bootstrap unit with limits\n", NULL, &cpu_run_cmd_message },
+    { "BREAK", &brk_cmd, SSH_ST,
+      "br{eak} <list>           set breakpoints\n" },
+    { "STEP",  &run_cmd, RU_STEP,
+      "*Commands Running_A_Simulated_Program STEP", NULL, &run_cmd_message },
+    { "SHOW",  &cpu_show_cmd, 0,
+      "*Commands SHOW" },           /* SHOW THROTTLE adds M-20 real time pacing */
+    { "BSTEP", &rev_bstep_cmd, 0,
+      "bs{tep} {n}              step back n instructions\n" },
+    { "BRUN",  &rev_brun_cmd,  0,
+      "brun                     run back to start of execution history\n"
+      "brun addr                run back until KRA = addr\n"
+      "brun WATCH addr          run back until last change of memory word\n" },
+    { "PROFILE", &prof_cmd, 0,
+      "prof{ile} CALLS          print call graph profile (DEP CALL_PROFILE 1)\n"
+      "prof{ile} FOLDED file {TIME}  write call stacks in folded format\n"
+      "prof{ile} LOOPS          print loop profile (DEP LOOP_PROFILE 1)\n"
+      "prof{ile} SMC {n}        print self-modifying code (DEP SMC_PROFILE 1)\n"
+      "prof{ile} HOST {n}       print host counters by opcodes (DEP HPC_SAMPLE n)\n"
+      "prof{ile} LISTING file   load autocode listing for source lines\n"
+      "prof{ile} RESET          clear profile data\n" },
+    { "MEMFILE", &m20_mem_cmd, 0,
+      "memfile SHOW             list memory files (ATTACH dev mem:name)\n"
+      "memfile LOAD name file   copy host file into memory file\n"
+      "memfile SAVE name file   write memory file into host file\n"
+      "memfile FREE name|ALL    delete memory file(s)\n" },
+    { "STATS", &m20_stat_cmd, 0,
+      "stats                    print run statistics (SHOW STATS)\n"
+      "stats FILE file {sec}    append statistics to file every sec seconds\n"
+      "stats FILE OFF           stop writing of statistics file\n" },
+    { "ENSEMBLE", &m20_ens_cmd, 0,
+      "ensemble {-I n} {-D addr{-addr}} lane ...\n"
+      "                         run program in lanes with own key registers,\n"
+      "                         lane = rpu1{/rpu2{/rpu3{/rpu4}}} (octal)\n" },
+    { "SWEEP", &m20_sweep_cmd, 0,
+      "sweep {-R addr} {-P n} {-I n} {-T time} {-W time} jobfile\n"
+      "                         run jobs of jobfile in forked processes\n"
+      "                         from ready address (not on Windows)\n" },
+    { "HEATMAP", &m20_heat_cmd, 0,
+      "heatmap                  print data access heatmap (SHOW MEMORY HEATMAP)\n"
+      "heatmap FILE file        write heatmap counters into binary file\n" },
+    { "TRACE", &m20_trace_cmd, 0,
+      "trace                    show trace control (SET CPU DEBUG)\n"
+      "trace INCLUDE|EXCLUDE addr{-addr}  trace only/not address range\n"
+      "trace OPCODE op{,op...}|ALL  trace only these opcodes\n"
+      "trace START|STOP AT addr|AFTER n|WATCH addr value|NONE\n"
+      "                         start/stop trigger (START STOP: on stop)\n"
+      "trace WINDOW n           pre-trigger window of n instructions\n"
+      "trace RESET              trace all instructions\n" },
+    { NULL }
+    };
+
+
 
 /*
  * Transform real number into M-20 format
@@ -383,6 +489,340 @@ t_stat m20_abs_mem_dump ( FILE *of, char *fname )
 
 
 
+/*
+ *  Symbol map (produced by autocode_m20 -m)
+ *
+ *  Names are kept in a hash table (case-insensitive, as in autocode),
+ *  addresses are mapped to first label and source line by direct index.
+ */
+
+#define  SYM_HASH_SIZE     1024
+
+typedef struct m20_sym {
+    struct m20_sym * next;
+    int     value;
+    char    name[1];
+} M20_SYM, *PM20_SYM;
+
+static PM20_SYM      sym_hash[SYM_HASH_SIZE];
+static const char *  sym_addr_name[MAX_MEM_SIZE];
+static int           sym_addr_line[MAX_MEM_SIZE];
+static int           sym_num = 0;
+
+
+static int m20_sym_toupper (int c)
+{
+    return (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+}
+
+
+static unsigned int m20_sym_hash (const char *name, int len)
+{
+    unsigned int h = 0;
+
+    while (len-- > 0)
+        h = h * 31 + m20_sym_toupper ((unsigned char) *name++);
+    return h & (SYM_HASH_SIZE-1);
+}
+
+
+static PM20_SYM m20_sym_find (const char *name, int len)
+{
+    PM20_SYM sp;
+    int i;
+
+    for (sp = sym_hash[m20_sym_hash (name, len)]; sp != NULL; sp = sp->next) {
+        for (i=0; i<len; i++)
+            if (m20_sym_toupper ((unsigned char) sp->name[i]) != m20_sym_toupper ((unsigned char) name[i])) break;
+        if ((i == len) && (sp->name[len] == '\0')) return sp;
+    }
+    return NULL;
+}
+
+
+void m20_sym_reset (void)
+{
+    PM20_SYM sp, next;
+    int i;
+
+    for (i=0; i<SYM_HASH_SIZE; i++) {
+        for (sp = sym_hash[i]; sp != NULL; sp = next) {
+            next = sp->next;
+            free (sp);
+        }
+        sym_hash[i] = NULL;
+    }
+    memset (sym_addr_name, 0, sizeof(sym_addr_name));
+    memset (sym_addr_line, 0, sizeof(sym_addr_line));
+    sym_num = 0;
+}
+
+
+/*
+ *  Label and source line by address (NULL/0 if none)
+ */
+const char * m20_sym_name (int addr)
+{
+    return sym_addr_name[addr & MAX_ADDR_VALUE];
+}
+
+
+int m20_sym_line (int addr)
+{
+    return sym_addr_line[addr & MAX_ADDR_VALUE];
+}
+
+
+/*
+ *  Load map file:  S aaaa name | L aaaa line | A value name | @ssss
+ */
+static t_stat m20_sym_load_line (char *buf)
+{
+    char name[256];
+    char *p;
+    unsigned int addr;
+    int line, len;
+    unsigned int h;
+    PM20_SYM sp;
+
+    p = skip_spaces (buf);
+    if (*p == 'S' || *p == 's') {
+        if (sscanf (p+1, "%o %255s", &addr, name) != 2 || addr > MAX_ADDR_VALUE)
+            return SCPE_FMT;
+        len = (int) strlen (name);
+        if (m20_sym_find (name, len) != NULL) return SCPE_OK;
+        sp = (PM20_SYM) malloc (sizeof(M20_SYM) + len);
+        if (sp == NULL) return SCPE_MEM;
+        strcpy (sp->name, name);
+        sp->value = addr;
+        h = m20_sym_hash (name, len);
+        sp->next = sym_hash[h];
+        sym_hash[h] = sp;
+        if (sym_addr_name[addr] == NULL) sym_addr_name[addr] = sp->name;
+        sym_num++;
+    } else if (*p == 'L' || *p == 'l') {
+        if (sscanf (p+1, "%o %d", &addr, &line) != 2 || addr > MAX_ADDR_VALUE)
+            return SCPE_FMT;
+        if (sym_addr_line[addr] == 0) sym_addr_line[addr] = line;
+    }
+    /* comments, start address and absolute values are not used */
+
+    return SCPE_OK;
+}
+
+
+t_stat m20_sym_load (FILE *input)
+{
+    char buf[512];
+    t_stat err;
+
+    m20_sym_reset ();
+
+    while (fgets (buf, sizeof(buf), input) != NULL) {
+        err = m20_sym_load_line (buf);
+        if (err) return err;
+    }
+
+    sim_printf ("%d symbols loaded\n", sym_num);
+    return SCPE_OK;
+}
+
+
+/*
+ *  Load symbol map from memory (binary object file)
+ */
+t_stat m20_sym_load_buf (char *buf, size_t size)
+{
+    char line[512];
+    size_t i, n;
+    t_stat err;
+
+    m20_sym_reset ();
+
+    for (i=0; i<size; ) {
+        for (n=0; (i < size) && (buf[i] != '\n'); i++)
+            if (n < sizeof(line)-1) line[n++] = buf[i];
+        line[n] = '\0';
+        i++;
+        err = m20_sym_load_line (line);
+        if (err) return err;
+    }
+
+    return SCPE_OK;
+}
+
+
+/*
+ *  Show symbol table (by address)
+ */
+static int m20_sym_cmp (const void *p1, const void *p2)
+{
+    PM20_SYM s1 = *(PM20_SYM const *)p1;
+    PM20_SYM s2 = *(PM20_SYM const *)p2;
+
+    if (s1->value != s2->value) return s1->value - s2->value;
+    return strcmp (s1->name, s2->name);
+}
+
+
+t_stat m20_sym_show (FILE *st, UNIT *uptr, int32 val, CONST void *desc)
+{
+    PM20_SYM sp, *order;
+    int i, n = 0;
+
+    order = (PM20_SYM *) malloc ((sym_num+1) * sizeof(PM20_SYM));
+    if (order == NULL) return SCPE_MEM;
+    for (i=0; i<SYM_HASH_SIZE; i++)
+        for (sp = sym_hash[i]; sp != NULL; sp = sp->next) order[n++] = sp;
+    qsort (order, n, sizeof(PM20_SYM), m20_sym_cmp);
+
+    for (i=0; i<n; i++) {
+        fprintf (st, "%04o  %-32s", order[i]->value, order[i]->name);
+        if (sym_addr_line[order[i]->value] > 0) fprintf (st, "  line %d", sym_addr_line[order[i]->value]);
+        fprintf (st, "\n");
+    }
+    fprintf (st, "%d symbols\n", n);
+    free (order);
+    return SCPE_OK;
+}
+
+
+/*
+ *  Address input: octal number or label{+offset|-offset} (sim_vm_parse_addr)
+ *  Labels of autocode may start with '@' (@FILL), it may be omitted (FILL),
+ *  as EXAMINE takes @ for output file.
+ */
+t_addr m20_parse_addr (DEVICE *dptr, CONST char *cptr, CONST char **tptr)
+{
+    const char *p = cptr;
+    CONST char *ep;
+    PM20_SYM sp;
+    t_addr addr;
+    int off;
+    char name[CBUFSIZE];
+
+    if ((dptr != &cpu_dev) || !(isalpha ((unsigned char) *p) || *p == '_' || *p == '@' || (*p & 0x80)))
+        return (t_addr) strtotv (cptr, tptr, dptr->aradix);
+
+    if (*p == '@') p++;
+    while (isalnum ((unsigned char) *p) || *p == '_' || (*p & 0x80)) p++;
+    sp = m20_sym_find (cptr, (int) (p - cptr));
+    if ((sp == NULL) && (*cptr != '@') && (p - cptr < CBUFSIZE - 1)) {
+        name[0] = '@';
+        memcpy (name + 1, cptr, p - cptr);
+        sp = m20_sym_find (name, (int) (p - cptr) + 1);
+    }
+    if (sp == NULL) {
+        *tptr = cptr;
+        return 0;
+    }
+    addr = sp->value;
+    if (*p == '+' || *p == '-') {
+        off = (int) strtotv (p+1, &ep, 8);
+        if (ep != p+1) {
+            addr = (*p == '+') ? addr + off : addr - off;
+            p = ep;
+        }
+    }
+    *tptr = p;
+    return addr & MAX_ADDR_VALUE;
+}
+
+
+/*
+ *  Address output: octal number and label (sim_vm_fprint_addr)
+ */
+void m20_fprint_vm_addr (FILE *st, DEVICE *dptr, t_addr addr)
+{
+    fprint_val (st, addr, dptr->aradix, dptr->awidth, PV_LEFT);
+    if ((dptr == &cpu_dev) && (addr < MAX_MEM_SIZE) && sym_addr_name[addr])
+        fprintf (st, " <%s>", sym_addr_name[addr]);
+}
+
+
+
+/*
+ *  Load binary object file (see M20_OBJ_xxx in m20_defs.h)
+ *  Whole file is read at once, runs are copied into memory.
+ */
+static t_value m20_get_le (const unsigned char *p, int size)
+{
+    t_value v = 0;
+
+    while (size-- > 0) v = (v << 8) | p[size];
+    return v;
+}
+
+
+t_stat m20_obj_load (FILE *input)
+{
+    unsigned char *buf, *p, *end;
+    long size;
+    int addr, n, runs, i;
+    size_t map_size;
+    t_stat err = SCPE_OK;
+
+    if (fseek (input, 0, SEEK_END) != 0) return SCPE_IOERR;
+    size = ftell (input);
+    fseek (input, 0, SEEK_SET);
+    if (size < M20_OBJ_HEADER_SIZE) return SCPE_FMT;
+
+    buf = (unsigned char *) malloc (size);
+    if (buf == NULL) return SCPE_MEM;
+    if (fread (buf, 1, size, input) != (size_t) size) {
+        free (buf);
+        return SCPE_IOERR;
+    }
+    end = buf + size;
+
+    if ((memcmp (buf, M20_OBJ_MAGIC, 4) != 0) ||
+        (m20_get_le (buf+4, 2) != M20_OBJ_VERSION)) {
+        free (buf);
+        return SCPE_FMT;
+    }
+    regKRA = (uint16) (m20_get_le (buf+6, 2) & MAX_ADDR_VALUE);
+    runs = (int) m20_get_le (buf+8, 2);
+    map_size = (size_t) m20_get_le (buf+12, 4);
+
+    p = buf + M20_OBJ_HEADER_SIZE;
+    while (runs-- > 0) {
+        if (p + M20_OBJ_RUN_SIZE > end) { err = SCPE_FMT; break; }
+        addr = (int) m20_get_le (p, 2);
+        n = (int) m20_get_le (p+2, 2);
+        p += M20_OBJ_RUN_SIZE;
+        if ((addr + n > MAX_MEM_SIZE) || (p + n * M20_OBJ_WORD_SIZE > end)) { err = SCPE_FMT; break; }
+        for (i=0; i<n; i++, p += M20_OBJ_WORD_SIZE)
+            mosu_store (addr+i, m20_get_le (p, M20_OBJ_WORD_SIZE) & WORD45);
+    }
+
+    if ((err == SCPE_OK) && (map_size == 0))	/* no map, old labels are wrong */
+        m20_sym_reset ();
+    if ((err == SCPE_OK) && (map_size > 0)) {
+        if (p + map_size > end) err = SCPE_FMT;
+        else err = m20_sym_load_buf ((char *) p, map_size);
+    }
+
+    free (buf);
+    return err;
+}
+
+
+
+/*
+ *  Test for binary object file (file position is not changed)
+ */
+static int m20_is_obj_file (FILE *input)
+{
+    char magic[4];
+    size_t n;
+
+    n = fread (magic, 1, sizeof(magic), input);
+    fseek (input, 0, SEEK_SET);
+    return (n == sizeof(magic)) && (memcmp (magic, M20_OBJ_MAGIC, 4) == 0);
+}
+
+
+
 /*
  *  Loader/dumper
  */
@@ -390,8 +830,12 @@ t_stat sim_load (FILE *fi, CONST char *cptr, CONST char *fnam, int dump_flag)
 {
     t_stat err;
 
+    if (!dump_flag && (sim_switches & SWMASK ('S'))) return m20_sym_load(fi);
+
     if (dump_flag) err = m20_abs_mem_dump( fi, fnam );
-    else err = m20_abs_load(fi);
+    else if (m20_is_obj_file(fi)) err = m20_obj_load(fi);
+    else if ((err = m20_abs_load(fi)) == SCPE_OK)
+        m20_sym_reset ();		/* text image has no map, old labels are wrong */
 
     return err;
 }
@@ -425,6 +869,7 @@ void m20_fprint_addr ( FILE *of, int a, int flag )
     } else {
 	if (flag) putc ('+', of);
 	fprintf (of, "%04o", a);
+	if (!flag && sym_addr_name[a]) fprintf (of, "<%s>", sym_addr_name[a]);
     }
 }
 
@@ -0,0 +1,450 @@
+/*
+ * File:     m20_trace.c
+ * Purpose:  M-20 simulator trace control (triggers, filters, window)
+ *
+ * Copyright (c) 2026, Dmitry Stefankov
+ *
+ * $Id$
+ *
+ * Instruction trace of CPU (SET CPU DEBUG) is written for instructions
+ * that pass address and opcode filters while trace is active.  Trace is
+ * started by start trigger (or at once without it) and ended by stop
+ * trigger.  Before the start, filtered instructions are kept in a ring
+ * (pre-trigger window), which is written when trace starts or when the
+ * program stops with start trigger STOP.
+ *
+ * Filters and address triggers are compiled into map of addresses and
+ * map of opcodes on every run, instruction count triggers into counters,
+ * so untraced instructions cost only a few tests.  DISABLE_IS2_TRACE
+ * adds exclusion of IS-2 library addresses.
+ *
+ * Commands:
+ *   TRACE                          show trace control
+ *   TRACE INCLUDE addr{-addr}      trace only included ranges
+ *   TRACE EXCLUDE addr{-addr}      do not trace range
+ *   TRACE OPCODE op{,op...}|ALL    trace only these opcodes (octal)
+ *   TRACE START AT addr            start trigger:  at address,
+ *   TRACE START AFTER n            after n instructions (from command),
+ *   TRACE START WATCH addr value   when word gets value (octal),
+ *   TRACE START STOP               on stop of program (window only)
+ *   TRACE STOP AT addr|AFTER n|WATCH addr value
+ *                                  stop trigger (AFTER counts from start)
+ *   TRACE WINDOW n                 pre-trigger window of n instructions
+ *   TRACE RESET                    trace all instructions
+ *
+ * Revision History.
+ *
+ *  19-Oct-2026  DVS  Initial Implementation
+ *  19-Oct-2026  DVS  STOP AFTER counts also without start trigger
+ *
+ */
+
+#include "m20_defs.h"
+
+
+/* CPU module references */
+
+extern DEVICE   cpu_dev;
+extern uint16   regRA;
+extern int      trgSW;
+extern t_value  regRK;
+extern t_value  regRR;
+extern t_value  MOSU[MAX_MEM_SIZE];
+extern t_uint64 cpu_instr_count;
+extern int      debug_dump_regs;
+extern int      disable_is2_trace;
+
+
+/* System module references (symbol map) */
+
+extern const char * m20_sym_name (int addr);
+
+
+#define  TRACE_MAX_RANGES    16
+#define  TRACE_MAX_WINDOW    65536
+
+/* Address map flags */
+#define  TRACE_ADDR_IN       1		/* address is traced */
+#define  TRACE_ADDR_START    2		/* start trigger */
+#define  TRACE_ADDR_STOP     4		/* stop trigger */
+
+/* Trigger kinds */
+#define  TRIG_NONE           0
+#define  TRIG_AT             1
+#define  TRIG_AFTER          2
+#define  TRIG_WATCH          3
+#define  TRIG_STOP           4
+
+/* Trace states */
+#define  TRACE_WAIT          0		/* waiting for start trigger */
+#define  TRACE_ACTIVE        1
+#define  TRACE_DONE          2		/* stop trigger was hit */
+
+
+typedef  struct trace_range {
+    int      lo, hi;
+} TRACE_RANGE;
+
+typedef  struct trace_trig {
+    int       kind;
+    int       addr;
+    t_value   value;
+    t_uint64  count;
+} TRACE_TRIG;
+
+/* Instruction of pre-trigger window */
+typedef  struct trace_rec {
+    int       pc;
+    int       ra;
+    int       sw;
+    t_value   rk;
+    t_value   rr;
+    t_uint64  count;
+} TRACE_REC;
+
+
+static TRACE_RANGE   trace_incl[TRACE_MAX_RANGES];
+static int           trace_incl_num = 0;
+static TRACE_RANGE   trace_excl[TRACE_MAX_RANGES];
+static int           trace_excl_num = 0;
+static unsigned char trace_ops[MAX_OPCODE_VALUE+1];
+static int           trace_ops_all = 1;
+static TRACE_TRIG    trace_start = { TRIG_NONE };
+static TRACE_TRIG    trace_stop = { TRIG_NONE };
+static t_uint64      trace_start_count = 0;	/* instruction of AFTER triggers */
+static t_uint64      trace_stop_count = 0;
+static int           trace_state = TRACE_ACTIVE;
+
+static unsigned char trace_map[MAX_MEM_SIZE];	/* compiled filters and triggers */
+static unsigned char trace_op_map[MAX_OPCODE_VALUE+1];
+
+static TRACE_REC *   trace_ring = NULL;
+static int           trace_window = 0;
+static int           trace_ring_pos = 0;
+static int           trace_ring_num = 0;
+
+static t_uint64      trace_traced = 0;		/* counters */
+static t_uint64      trace_skipped = 0;
+
+
+
+/*
+ *  Compile filters and address triggers (on every run)
+ */
+void m20_trace_compile (void)
+{
+    int  a, i, in;
+
+    for (a = 0; a < MAX_MEM_SIZE; a++) {
+        in = (trace_incl_num == 0);
+        for (i = 0; i < trace_incl_num; i++)
+            if ((a >= trace_incl[i].lo) && (a <= trace_incl[i].hi)) in = 1;
+        for (i = 0; i < trace_excl_num; i++)
+            if ((a >= trace_excl[i].lo) && (a <= trace_excl[i].hi)) in = 0;
+        if (disable_is2_trace && (a >= IS2_START_ADDRESS) && (a <= IS2_END_ADDRESS)) in = 0;
+        trace_map[a] = in ? TRACE_ADDR_IN : 0;
+    }
+    if (trace_start.kind == TRIG_AT) trace_map[trace_start.addr] |= TRACE_ADDR_START;
+    if (trace_stop.kind == TRIG_AT) trace_map[trace_stop.addr] |= TRACE_ADDR_STOP;
+    for (i = 0; i <= MAX_OPCODE_VALUE; i++)
+        trace_op_map[i] = trace_ops_all || trace_ops[i];
+}
+
+
+static void trace_arm (void)
+{
+    trace_state = (trace_start.kind == TRIG_NONE) ? TRACE_ACTIVE : TRACE_WAIT;
+    if (trace_start.kind == TRIG_AFTER) trace_start_count = cpu_instr_count + trace_start.count;
+    trace_stop_count = 0;
+    if ((trace_start.kind == TRIG_NONE) && (trace_stop.kind == TRIG_AFTER))
+        trace_stop_count = cpu_instr_count + trace_stop.count;	/* active now */
+    trace_ring_pos = trace_ring_num = 0;
+}
+
+
+
+/*
+ *  Pre-trigger window
+ */
+static void trace_ring_put (int pc)
+{
+    TRACE_REC *rp;
+
+    if (trace_ring == NULL) return;
+    rp = &trace_ring[trace_ring_pos];
+    rp->pc = pc;
+    rp->ra = regRA;
+    rp->sw = trgSW;
+    rp->rk = MOSU[pc];
+    rp->rr = regRR;
+    rp->count = cpu_instr_count;
+    if (++trace_ring_pos >= trace_window) trace_ring_pos = 0;
+    if (trace_ring_num < trace_window) trace_ring_num++;
+}
+
+
+static void trace_ring_flush (const char *why)
+{
+    TRACE_REC *rp;
+    int  i, n;
+
+    if ((trace_ring_num == 0) || (sim_deb == NULL)) return;
+    fprintf (sim_deb, "cpu: --- window of %d instructions before %s ---\n", trace_ring_num, why);
+    n = trace_ring_pos - trace_ring_num;
+    if (n < 0) n += trace_window;
+    for (i = 0; i < trace_ring_num; i++) {
+        rp = &trace_ring[(n + i) % trace_window];
+        if (m20_sym_name (rp->pc)) fprintf (sim_deb, "cpu: %04o <%s>: ", rp->pc, m20_sym_name (rp->pc));
+        else fprintf (sim_deb, "cpu: %04o: ", rp->pc);
+        fprint_sym (sim_deb, rp->pc, &rp->rk, 0, SWMASK ('M'));
+        fprintf (sim_deb, "\n");
+        if (debug_dump_regs)
+            fprintf (sim_deb, "cpu: [dreg]: ra=%04o,  sw=%d,  rr=%015llo\n", rp->ra, rp->sw, rp->rr );
+    }
+    fprintf (sim_deb, "cpu: --- end of window ---\n");
+    trace_ring_pos = trace_ring_num = 0;
+}
+
+
+
+/*
+ *  Called before every instruction while CPU trace is on
+ *  Returns TRUE if instruction is traced.
+ */
+int m20_trace_inst (int pc, int op)
+{
+    int  f = trace_map[pc];
+    int  hit;
+
+    if (trace_state == TRACE_DONE) return FALSE;
+    if (trace_state == TRACE_WAIT) {
+        switch (trace_start.kind) {
+          case TRIG_AT:    hit = (f & TRACE_ADDR_START) != 0; break;
+          case TRIG_AFTER: hit = (cpu_instr_count >= trace_start_count); break;
+          case TRIG_WATCH: hit = (MOSU[trace_start.addr] == trace_start.value); break;
+          default:         hit = FALSE; break;
+        }
+        if (!hit) {
+            if ((f & TRACE_ADDR_IN) && trace_op_map[op]) trace_ring_put (pc);
+            trace_skipped++;
+            return FALSE;
+        }
+        trace_state = TRACE_ACTIVE;
+        trace_ring_flush ("start trigger");
+        if (sim_deb) fprintf (sim_deb, "cpu: --- trace started at %04o ---\n", pc);
+        if (trace_stop.kind == TRIG_AFTER) trace_stop_count = cpu_instr_count + trace_stop.count;
+    }
+
+    switch (trace_stop.kind) {			/* last traced instruction */
+      case TRIG_AT:    hit = (f & TRACE_ADDR_STOP) != 0; break;
+      case TRIG_AFTER: hit = (trace_stop_count != 0) && (cpu_instr_count + 1 >= trace_stop_count); break;
+      case TRIG_WATCH: hit = (MOSU[trace_stop.addr] == trace_stop.value); break;
+      default:         hit = FALSE; break;
+    }
+    if (hit) {
+        trace_state = TRACE_DONE;
+        if (sim_deb) fprintf (sim_deb, "cpu: --- trace stops at %04o ---\n", pc);
+    }
+
+    if ((f & TRACE_ADDR_IN) && trace_op_map[op]) {
+        trace_traced++;
+        return TRUE;
+    }
+    trace_skipped++;
+    return FALSE;
+}
+
+
+
+/*
+ *  Called on stop of simulation
+ */
+void m20_trace_run_stop (t_stat r)
+{
+    if (!(sim_deb && cpu_dev.dctrl) || (trace_state != TRACE_WAIT)) return;
+    if ((trace_start.kind == TRIG_STOP) && (r > 0) && (r < SCPE_BASE))
+        trace_ring_flush ("stop");
+}
+
+
+
+/*
+ *  TRACE command
+ */
+static void trace_print_trig (FILE *st, const char *name, TRACE_TRIG *tp)
+{
+    fprintf (st, "  %s:", name);
+    switch (tp->kind) {
+      case TRIG_AT:    fprintf (st, " at %04o\n", tp->addr); break;
+      case TRIG_AFTER: fprintf (st, " after %llu instructions\n", tp->count); break;
+      case TRIG_WATCH: fprintf (st, " when %04o = %015llo\n", tp->addr, tp->value); break;
+      case TRIG_STOP:  fprintf (st, " on program stop\n"); break;
+      default:         fprintf (st, " none\n"); break;
+    }
+}
+
+
+static void trace_print (FILE *st)
+{
+    static const char *state_name[] = { "waiting for start", "active", "stopped" };
+    int  i, n;
+
+    fprintf (st, "Trace control (%s):\n", state_name[trace_state]);
+    fprintf (st, "  include:");
+    if (trace_incl_num == 0) fprintf (st, " all");
+    for (i = 0; i < trace_incl_num; i++) fprintf (st, " %04o-%04o", trace_incl[i].lo, trace_incl[i].hi);
+    fprintf (st, "\n  exclude:");
+    if (trace_excl_num == 0) fprintf (st, " none");
+    for (i = 0; i < trace_excl_num; i++) fprintf (st, " %04o-%04o", trace_excl[i].lo, trace_excl[i].hi);
+    if (disable_is2_trace) fprintf (st, " %04o-%04o (IS-2)", IS2_START_ADDRESS, IS2_END_ADDRESS);
+    fprintf (st, "\n  opcodes:");
+    if (trace_ops_all) fprintf (st, " all");
+    for (i = 0, n = 0; !trace_ops_all && (i <= MAX_OPCODE_VALUE); i++)
+        if (trace_ops[i]) fprintf (st, "%s%02o", (n++ > 0) ? "," : " ", i);
+    fprintf (st, "\n");
+    trace_print_trig (st, "start", &trace_start);
+    trace_print_trig (st, "stop", &trace_stop);
+    fprintf (st, "  window:  %d instructions (%d kept)\n", trace_window, trace_ring_num);
+    fprintf (st, "  traced:  %llu, not traced: %llu\n", trace_traced, trace_skipped);
+}
+
+
+static t_stat trace_get_range (CONST char *cptr, TRACE_RANGE *rng, int *num)
+{
+    t_addr  lo, hi;
+
+    if (*cptr == 0) return SCPE_2FARG;
+    if (*num >= TRACE_MAX_RANGES) return SCPE_ARG;
+    cptr = get_range (&cpu_dev, cptr, &lo, &hi, 8, MAX_ADDR_VALUE, 0);
+    if ((cptr == NULL) || *cptr || (lo > hi)) return SCPE_ARG;
+    rng[*num].lo = (int) lo;
+    rng[*num].hi = (int) hi;
+    (*num)++;
+    return SCPE_OK;
+}
+
+
+static t_stat trace_get_trig (CONST char *cptr, TRACE_TRIG *tp, int allow_stop)
+{
+    char  gbuf[CBUFSIZE];
+    TRACE_TRIG  t;
+    t_stat r = SCPE_OK;
+
+    memset (&t, 0, sizeof(t));
+    cptr = get_glyph (cptr, gbuf, 0);
+    if (strcmp (gbuf, "AT") == 0) {
+        cptr = get_glyph (cptr, gbuf, 0);
+        t.kind = TRIG_AT;
+        t.addr = (int) get_uint (gbuf, 8, MAX_ADDR_VALUE, &r);
+    }
+    else if (strcmp (gbuf, "AFTER") == 0) {
+        cptr = get_glyph (cptr, gbuf, 0);
+        t.kind = TRIG_AFTER;
+        t.count = get_uint (gbuf, 10, 0xFFFFFFFFFFFFFFFFull, &r);
+    }
+    else if (strcmp (gbuf, "WATCH") == 0) {
+        cptr = get_glyph (cptr, gbuf, 0);
+        t.kind = TRIG_WATCH;
+        t.addr = (int) get_uint (gbuf, 8, MAX_ADDR_VALUE, &r);
+        if (r == SCPE_OK) {
+            cptr = get_glyph (cptr, gbuf, 0);
+            t.value = get_uint (gbuf, 8, WORD45, &r);
+        }
+    }
+    else if (allow_stop && (strcmp (gbuf, "STOP") == 0))
+        t.kind = TRIG_STOP;
+    else if ((strcmp (gbuf, "NONE") != 0) && (strcmp (gbuf, "OFF") != 0))
+        return SCPE_ARG;
+    if ((r != SCPE_OK) || (gbuf[0] == 0)) return SCPE_ARG;
+    if (*cptr) return SCPE_2MARG;
+    *tp = t;
+    return SCPE_OK;
+}
+
+
+static t_stat trace_get_ops (CONST char *cptr)
+{
+    char  gbuf[CBUFSIZE];
+    unsigned char  ops[MAX_OPCODE_VALUE+1];
+    t_stat r = SCPE_OK;
+    int  op;
+
+    if (*cptr == 0) return SCPE_2FARG;
+    if ((*get_glyph (cptr, gbuf, 0) == 0) && (strcmp (gbuf, "ALL") == 0)) {
+        trace_ops_all = 1;
+        return SCPE_OK;
+    }
+    memset (ops, 0, sizeof(ops));
+    while (*cptr) {
+        cptr = get_glyph (cptr, gbuf, ',');
+        op = (int) get_uint (gbuf, 8, MAX_OPCODE_VALUE, &r);
+        if (r != SCPE_OK) return SCPE_ARG;
+        ops[op] = 1;
+    }
+    memcpy (trace_ops, ops, sizeof(ops));
+    trace_ops_all = 0;
+    return SCPE_OK;
+}
+
+
+static t_stat trace_set_window (CONST char *cptr)
+{
+    TRACE_REC *ring = NULL;
+    t_stat r = SCPE_OK;
+    int  n;
+
+    n = (int) get_uint (cptr, 10, TRACE_MAX_WINDOW, &r);
+    if (r != SCPE_OK) return SCPE_ARG;
+    if (n > 0) {
+        ring = (TRACE_REC *) calloc (n, sizeof(TRACE_REC));
+        if (ring == NULL) return SCPE_MEM;
+    }
+    free (trace_ring);
+    trace_ring = ring;
+    trace_window = n;
+    trace_ring_pos = trace_ring_num = 0;
+    return SCPE_OK;
+}
+
+
+t_stat m20_trace_cmd (int32 flag, CONST char *cptr)
+{
+    char  gbuf[CBUFSIZE];
+    t_stat r;
+
+    cptr = get_glyph (cptr, gbuf, 0);
+    if (gbuf[0] == 0) {
+        trace_print (stdout);
+        if (sim_log && (sim_log != stdout)) trace_print (sim_log);
+        return SCPE_OK;
+    }
+    if (strcmp (gbuf, "INCLUDE") == 0)
+        return trace_get_range (cptr, trace_incl, &trace_incl_num);
+    if (strcmp (gbuf, "EXCLUDE") == 0)
+        return trace_get_range (cptr, trace_excl, &trace_excl_num);
+    if (strcmp (gbuf, "OPCODE") == 0)
+        return trace_get_ops (cptr);
+    if (strcmp (gbuf, "START") == 0) {
+        if ((r = trace_get_trig (cptr, &trace_start, TRUE)) != SCPE_OK) return r;
+        trace_arm ();
+        return SCPE_OK;
+    }
+    if (strcmp (gbuf, "STOP") == 0) {
+        if ((r = trace_get_trig (cptr, &trace_stop, FALSE)) != SCPE_OK) return r;
+        trace_arm ();
+        return SCPE_OK;
+    }
+    if (strcmp (gbuf, "WINDOW") == 0)
+        return trace_set_window (cptr);
+    if (strcmp (gbuf, "RESET") == 0) {
+        if (*cptr) return SCPE_2MARG;
+        trace_incl_num = trace_excl_num = 0;
+        trace_ops_all = 1;
+        memset (&trace_start, 0, sizeof(trace_start));
+        memset (&trace_stop, 0, sizeof(trace_stop));
+        trace_traced = trace_skipped = 0;
+        trace_arm ();
+        return SCPE_OK;
+    }
+    return SCPE_ARG;
+}
@@ -0,0 +1,294 @@
+/*
+ * File:     m20cfg.c
+ * Purpose:  control-flow graph of M-20 program without its run
+ *
+ * Copyright (c) 2026, Dmitry Stefankov
+ *
+ * $Id$
+ *
+ * Program is loaded from text memory image (.m20, as written by DUMP of
+ * simulator) or from binary object file (autocode_m20 -b) and analyzed
+ * by m20_cfg.c, as SHOW CPU CFG of simulator.  Decimal constants of text
+ * image (=, +, -, #) are taken as loaded data words.
+ *
+ * Revision History.
+ *
+ *  19-Oct-2026  DVS  Initial Implementation
+ *
+ */
+
+
+#include "m20_defs.h"
+
+#if _UNIX
+#include <unistd.h>
+#endif
+#if _WIN32
+#include "getopt.h"
+#endif
+
+
+/*------------------------------- GNU C library -----------------------------*/
+#if _WIN32
+extern int       opterr;
+extern int       optind;
+extern char     *optarg;
+#endif
+
+
+#define  MAX_ENTRIES        16
+
+/* Local data */
+
+extern  int        optind;
+extern  int        opterr;
+extern  char     * optarg;
+
+char         * in_file = NULL;
+char         * out_file = NULL;
+int           dot_output = 0;
+int           verbose = 0;
+
+static t_value       mem_words[MAX_MEM_SIZE];
+static unsigned char mem_used[MAX_MEM_SIZE];
+static int           entries[MAX_ENTRIES];
+static int           entries_num = 0;
+static int           start_addr = 1;
+
+
+const char prog_ver[] = "1.0.0";
+const char rcs_id[] = "$Id$";
+
+
+/* Analyzer (m20_cfg.c) */
+
+struct m20_cfg;
+extern struct m20_cfg * m20_cfg_build (const t_value *mem, const unsigned char *used,
+                                       const int *entries, int n);
+extern void m20_cfg_print (FILE *st, struct m20_cfg *cfg);
+extern void m20_cfg_dot (FILE *st, struct m20_cfg *cfg);
+extern void m20_cfg_free (struct m20_cfg *cfg);
+
+
+
+
+/*----------------------- Functions ---------------------------------------*/
+
+
+/*
+ *  Print help screen
+ */
+void usage(void)
+{
+  fprintf( stderr, "\n" );
+  fprintf( stderr, "Control-flow graph of M-20 program, version %s\n", prog_ver );
+  fprintf( stderr, "Usage: m20cfg [-hdv] [-e addr] [-o out-file] -i image-file\n" );
+  fprintf( stderr, "       -h   this help\n" );
+  fprintf( stderr, "       -v   verbose output\n" );
+  fprintf( stderr, "       -d   write graph in Graphviz DOT format\n" );
+  fprintf( stderr, "       -e   entry address (octal), may be repeated\n" );
+  fprintf( stderr, "       -o   output file\n" );
+  fprintf( stderr, "Default parameters:\n" );
+  fprintf( stderr, "   entry is start address of image (@), report to stdout\n" );
+  fprintf( stderr, "Sample command line:\n" );
+  fprintf( stderr, "   ./m20cfg  -i primes.m20\n" );
+  fprintf( stderr, "   ./m20cfg  -d -e 0200 -i primes.obj -o primes.dot\n" );
+  fprintf( stderr, "\n" );
+  exit(1);
+}
+
+
+
+
+/*
+ *  Get little-endian number of object file
+ */
+static t_value get_le( const unsigned char * p, int size )
+{
+  t_value v = 0;
+
+  while (size-- > 0) v = (v << 8) | p[size];
+  return v;
+}
+
+
+
+/*
+ *  Load binary object file (magic is already checked)
+ */
+int load_object( FILE * fp_in )
+{
+  unsigned char  hdr[M20_OBJ_HEADER_SIZE];
+  unsigned char  run[M20_OBJ_RUN_SIZE];
+  unsigned char  word[M20_OBJ_WORD_SIZE];
+  int            runs, addr, n, i;
+
+  if ((fread( hdr, 1, sizeof(hdr), fp_in ) != sizeof(hdr)) ||
+      (get_le( hdr+4, 2 ) != M20_OBJ_VERSION)) {
+    return(-1);
+  }
+  start_addr = (int)(get_le( hdr+6, 2 ) & MAX_ADDR_VALUE);
+  runs = (int)get_le( hdr+8, 2 );
+  while (runs-- > 0) {
+    if (fread( run, 1, sizeof(run), fp_in ) != sizeof(run)) return(-1);
+    addr = (int)get_le( run, 2 );
+    n = (int)get_le( run+2, 2 );
+    if (addr + n > MAX_MEM_SIZE) return(-1);
+    for( i=0; i<n; i++ ) {
+      if (fread( word, 1, sizeof(word), fp_in ) != sizeof(word)) return(-1);
+      mem_words[addr+i] = get_le( word, M20_OBJ_WORD_SIZE ) & WORD45;
+      mem_used[addr+i] = 1;
+    }
+  }
+  return(0);
+}
+
+
+
+/*
+ *  Load text memory image
+ */
+int load_text( FILE * fp_in )
+{
+  char      buf[1024];
+  char    * p;
+  int       addr = 1, lineno = 0, i;
+  t_value   w;
+
+  while (fgets( buf, sizeof(buf), fp_in ) != NULL) {
+    lineno++;
+    for( p=buf; (*p == ' ') || (*p == '\t'); p++ ) ;
+    if ((*p == '\n') || (*p == '\r') || (*p == ';') || (*p == '*') || (*p == 0)) continue;
+    if (*p == ':') {
+      addr = (int)strtol( p+1, NULL, 8 );
+      continue;
+    }
+    if (*p == '@') {
+      start_addr = (int)strtol( p+1, NULL, 8 ) & MAX_ADDR_VALUE;
+      continue;
+    }
+    w = 0;
+    if ((*p >= '0') && (*p <= '7')) {
+      for( i=0; i<15; i++ ) {
+        while ((*p == ' ') || (*p == '\t')) p++;
+        if ((*p < '0') || (*p > '7')) break;
+        w = (w << 3) | (*p++ - '0');
+      }
+      if (i < 15) {
+        fprintf( stderr, "ERROR: bad word at line %d!\n", lineno );
+        return(-1);
+      }
+    }
+    else if ((*p != '=') && (*p != '+') && (*p != '-') && (*p != '#')) {
+      fprintf( stderr, "ERROR: bad line %d!\n", lineno );
+      return(-1);
+    }
+    if ((addr < 0) || (addr >= MAX_MEM_SIZE)) {
+      fprintf( stderr, "ERROR: address out of memory at line %d!\n", lineno );
+      return(-1);
+    }
+    mem_words[addr] = w;
+    mem_used[addr] = 1;
+    addr++;
+  }
+  return(0);
+}
+
+
+
+/*
+ *  Main program stream
+ */
+int main( int argc, char ** argv )
+{
+  int                 ret_code = 0;
+  int                 op;
+  FILE *              fp_in = NULL;
+  FILE *              fp_out = stdout;
+  char                magic[4];
+  size_t              read_count;
+  struct m20_cfg *    cfg;
+  int                 i, n = 0;
+
+/* Process command line  */
+  opterr = 0;
+  while( (op = getopt(argc,argv,"vhdi:o:e:")) != -1)
+    switch(op) {
+      case 'i':
+               in_file = optarg;
+      	       break;
+      case 'o':
+               out_file = optarg;
+      	       break;
+      case 'e':
+               if (entries_num < MAX_ENTRIES) {
+                 entries[entries_num++] = (int)strtol( optarg, NULL, 8 ) & MAX_ADDR_VALUE;
+               }
+      	       break;
+      case 'd':
+               dot_output = 1;
+      	       break;
+      case 'v':
+               verbose = 1;
+      	       break;
+      case 'h':
+               usage();
+               break;
+      default:
+               break;
+    }
+
+  if (in_file == NULL) {
+       usage();
+  }
+
+  fp_in = fopen( in_file, "rb" );
+  if (fp_in == NULL) {
+    fprintf( stderr, "ERROR: cannot open file %s!\n", in_file );
+    return(10);
+  }
+
+  /* Load program: binary object or text image */
+  read_count = fread( magic, 1, sizeof(magic), fp_in );
+  fseek( fp_in, 0, SEEK_SET );
+  if ((read_count == sizeof(magic)) && (memcmp( magic, M20_OBJ_MAGIC, sizeof(magic) ) == 0)) {
+    if (load_object( fp_in ) != 0) {
+      fprintf( stderr, "ERROR: bad object file %s!\n", in_file );
+      fclose(fp_in);
+      return(11);
+    }
+  }
+  else if (load_text( fp_in ) != 0) {
+    fclose(fp_in);
+    return(11);
+  }
+  fclose(fp_in);
+
+  if (entries_num == 0) entries[entries_num++] = start_addr;
+  for( i=0; i<MAX_MEM_SIZE; i++ ) n += mem_used[i];
+  if (verbose) fprintf( stderr, "%d words loaded from %s.\n", n, in_file );
+
+  cfg = m20_cfg_build( mem_words, mem_used, entries, entries_num );
+  if (cfg == NULL) {
+    fprintf( stderr, "ERROR: not enough memory!\n" );
+    return(12);
+  }
+
+  if (out_file != NULL) {
+    fp_out = fopen( out_file, "w" );
+    if (fp_out == NULL) {
+      fprintf( stderr, "ERROR: cannot write file %s!\n", out_file );
+      m20_cfg_free( cfg );
+      return(13);
+    }
+  }
+
+  if (dot_output) m20_cfg_dot( fp_out, cfg );
+  else m20_cfg_print( fp_out, cfg );
+
+  if (ferror(fp_out)) ret_code = 13;
+  if (fp_out != stdout) fclose(fp_out);
+  m20_cfg_free( cfg );
+
+  return(ret_code);
+}
@@ -0,0 +1,344 @@
+#!/bin/sh
+#
+# Standard performance benchmark of M-20 simulator
+#
+# $Id$
+#
+# usage: bench.sh [-n reps] [-m m20] [-o out.json] [-c baseline.json]
+#                 [-t percent] [workload ...]
+#
+# Every workload is run n times (default 3), every time in fresh copy of
+# its data files (work directory bench_work).  Wall time and peak RSS of
+# every simulator process are measured by script (python3 getrusage of
+# child, without python3 wall time by date only), so all generations of
+# simulator are measured the same way.  Counters of simulator are taken
+# from last line of its statistics file (STATS FILE):  instructions,
+# emulated time, host time of CPU run and peak RSS.  Times are medians of
+# runs, MIPS = instructions / median host time.  Report is written as
+# JSON, one workload per line.
+#
+# Scripts are written for all generations of simulator.  Commands of
+# current one only (STATS FILE, WATCHDOG) are removed from scripts, if
+# simulator doesn't accept them (probe before runs).  Output of every
+# run is checked for command errors of SCP (unknown command, invalid
+# argument and so on), such run is invalid:  it is counted in report
+# (invalid_runs), but its times are not, and exit code is 1.
+#
+# With -c MIPS of every workload and total are compared with baseline
+# report, drop over percent (default 10) is reported as regression and
+# exit code is 1.  Without MIPS on either side (m-20/2015 and m-20/2021
+# have no STATS FILE, so no instruction counts) median wall times are
+# compared.  Workloads shorter than 10 ms are shown, but not judged.
+# Changed instruction count is reported too (workload runs differently,
+# times are not comparable).
+#
+# Workloads (default, every one runs about a second or more of host time):
+#   sample_0101              real program, 50 million instructions
+#   arith_kernel             floating point operations only
+#   io_kernel                drum and tape transfers
+#
+# Short workloads (only by name, not in total, start of simulator is
+# longer than them):
+#   sample_0105, sample_0107 real programs (drums, tapes)
+#
+
+
+# variables
+REPS=3
+M20="../emulator/m20"
+OUT="bench.json"
+BASE=""
+THRESHOLD=10
+WORK="bench_work"
+REAL="../emulator_samples/real_programs"
+RESULTS="bench_results.txt"
+CURRENT_SCP=1
+
+ALL_WORKLOADS="sample_0101 arith_kernel io_kernel"
+SHORT_WORKLOADS="sample_0105 sample_0107"
+
+# command errors of SCP (all generations)
+SCP_ERRORS="Unknown command|Invalid argument|Invalid switch|Too few arguments|Too many arguments|Missing value|Non-existent (device|unit|register|parameter)|Ambiguous register name|File open error|Unit not attachable|Unit not attached|Unit already attached|Command not allowed|Command not completed|No settable parameters|Read only argument"
+
+
+usage()
+{
+  echo "usage: $0 [-n reps] [-m m20] [-o out.json] [-c baseline.json] [-t percent] [workload ...]" >&2
+  exit 2
+}
+
+
+abspath()
+{
+  case "$1" in
+    /*) echo "$1" ;;
+    *)  echo "`pwd`/$1" ;;
+  esac
+}
+
+
+# copy data files of workload $1 into clean work directory
+prepare()
+{
+  rm -rf $WORK
+  mkdir $WORK || return 1
+  case "$1" in
+    sample_*)
+      for f in $REAL/$1.*; do
+        case "$f" in
+          *.simh) ;;
+          *) cp "$f" $WORK/ ;;
+        esac
+      done
+      ;;
+    *)
+      cp $1.m20 $WORK/ || return 1
+      ;;
+  esac
+  if [ -n "$CURRENT_SCP" ]; then
+    cp bench_$1.simh $WORK/
+  else
+    sed -e '/^de WATCHDOG /d' -e '/^stats /d' bench_$1.simh >$WORK/bench_$1.simh
+  fi
+}
+
+
+# does simulator accept commands of current generation?
+probe()
+{
+  rm -rf $WORK
+  mkdir $WORK || return 1
+  printf 'de WATCHDOG 600\nstats file bench.log\nquit\n' >$WORK/probe.simh
+  if (cd $WORK && "$M20" probe.simh 2>&1) | grep -E "^($SCP_ERRORS)" >/dev/null; then
+    CURRENT_SCP=""
+    echo "bench: no STATS FILE in simulator, wall times only" >&2
+  fi
+  rm -rf $WORK
+}
+
+
+# first command error of SCP in output of run
+scp_error()
+{
+  grep -E "^($SCP_ERRORS)" $WORK/bench.out | head -1
+}
+
+
+# run simulator in work directory, output wall_ns= and proc_maxrss_kb=
+run_measured()
+{
+  if python3 -c "import resource" >/dev/null 2>&1; then
+    (cd $WORK && python3 -c '
+import resource, subprocess, sys, time
+out = open("bench.out", "w")
+start = time.perf_counter()
+subprocess.call(sys.argv[1:], stdout=out, stderr=subprocess.STDOUT)
+wall = time.perf_counter() - start
+rss = resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss
+if sys.platform == "darwin": rss //= 1024           # bytes
+print("wall_ns=%.0f proc_maxrss_kb=%d" % (wall * 1e9, rss))' "$@")
+  else
+    start=`date +%s%N`
+    (cd $WORK && "$@" >bench.out 2>&1)
+    end=`date +%s%N`
+    case "$start$end" in
+      *[!0-9]*) ;;                      # no nanoseconds in date
+      *) echo "wall_ns=`expr $end - $start`" ;;
+    esac
+  fi
+}
+
+
+# JSON report from results file ($1 - simulator, $2 - repetitions)
+report()
+{
+  awk -v sim="$1" -v reps="$2" -v short=" $SHORT_WORKLOADS " -v host="`uname -sm`" -v date="`date '+%Y-%m-%d %H:%M:%S'`" '
+    function val(key,   i, n, kv) {
+      for (i = 2; i <= NF; i++) {
+        n = split($i, kv, "=");
+        if ((n == 2) && (kv[1] == key)) return kv[2];
+      }
+      return "";
+    }
+    function num(v) { return (v == "") ? "null" : v; }
+    {
+      w = $1;
+      if (!(w in runs)) order[nw++] = w;
+      runs[w]++;
+      if ($2 == "invalid") { invalid[w]++; next; }
+      if (NF < 2) next;
+      instr[w] = val("instructions"); emul[w] = val("emul_us");
+      h = val("host_ns");
+      if (h != "") hosts[w, nh[w]++] = h + 0;
+      h = val("wall_ns");
+      if (h != "") walls[w, nwl[w]++] = h + 0;
+      r = val("maxrss_kb");
+      if ((r != "") && (r + 0 > rss[w] + 0)) rss[w] = r;
+      r = val("proc_maxrss_kb");
+      if ((r != "") && (r + 0 > prss[w] + 0)) prss[w] = r;
+    }
+    function median(a, w, n,   i, j, t) {
+      for (i = 1; i < n; i++)               # sort times
+        for (j = i; (j > 0) && (a[w, j-1] > a[w, j]); j--) {
+          t = a[w, j]; a[w, j] = a[w, j-1]; a[w, j-1] = t;
+        }
+      return (n % 2) ? a[w, int(n/2)] : (a[w, n/2-1] + a[w, n/2]) / 2;
+    }
+    END {
+      printf "{\n";
+      printf "  \"suite\": \"m20-bench-1\",\n";
+      printf "  \"simulator\": \"%s\",\n", sim;
+      printf "  \"host\": \"%s\",\n", host;
+      printf "  \"date\": \"%s\",\n", date;
+      printf "  \"repetitions\": %d,\n", reps;
+      printf "  \"workloads\": [\n";
+      for (k = 0; k < nw; k++) {
+        w = order[k]; n = nh[w];
+        is_short = index(short, " " w " ") > 0;    # not in total
+        if (n > 0) {
+          med = median(hosts, w, n);
+          hmin = sprintf("%.0f", hosts[w, 0]); hmed = sprintf("%.0f", med);
+          mips = (med > 0) ? sprintf("%.3f", instr[w] * 1000.0 / med) : "null";
+          if (!is_short) { tot_instr += instr[w]; tot_host += med; }
+        }
+        else { hmin = ""; hmed = ""; mips = "null"; }
+        if (nwl[w] > 0) {
+          med = median(walls, w, nwl[w]);
+          wmed = sprintf("%.0f", med);
+          if (!is_short) tot_wall += med;
+        }
+        else wmed = "";
+        printf "    {\"name\": \"%s\", \"runs\": %d, \"invalid_runs\": %d, \"short\": %s, \"instructions\": %s, \"emul_us\": %s, \"host_ns_min\": %s, \"host_ns_median\": %s, \"mips\": %s, \"maxrss_kb\": %s, \"wall_ns_median\": %s, \"proc_maxrss_kb\": %s}%s\n",
+               w, runs[w], invalid[w], is_short ? "true" : "false", num(instr[w]), num(emul[w]),
+               num(hmin), num(hmed), mips, num(rss[w]), num(wmed), num(prss[w]), (k < nw-1) ? "," : "";
+      }
+      printf "  ],\n";
+      printf "  \"total\": {\"name\": \"total\", \"instructions\": %.0f, \"host_ns_median\": %.0f, \"mips\": %s, \"wall_ns_median\": %s}\n",
+             tot_instr, tot_host, (tot_host > 0) ? sprintf("%.3f", tot_instr * 1000.0 / tot_host) : "null",
+             (tot_wall > 0) ? sprintf("%.0f", tot_wall) : "null";
+      printf "}\n";
+    }' $RESULTS
+}
+
+
+# compare report $2 with baseline $1, threshold $3 (percent)
+compare()
+{
+  awk -v base="$1" -v threshold="$3" '
+    function field(key,   s) {
+      if (!match($0, "\"" key "\": [^,}]*")) return "";
+      s = substr($0, RSTART, RLENGTH);
+      sub(/^"[^"]*": /, "", s); gsub(/"/, "", s);
+      return (s == "null") ? "" : s;
+    }
+    /"name":/ {
+      w = field("name");
+      if (FILENAME == base) {
+        bmips[w] = field("mips"); binstr[w] = field("instructions"); bwall[w] = field("wall_ns_median");
+        next;
+      }
+      order[n++] = w; mips[w] = field("mips"); instr[w] = field("instructions");
+      host[w] = field("host_ns_median"); wall[w] = field("wall_ns_median");
+      short[w] = (field("short") == "true");
+    }
+    END {
+      printf "%-14s %12s %12s %9s\n", "workload", "base_mips", "mips", "change";
+      for (k = 0; k < n; k++) {
+        w = order[k]; note = "";
+        if ((bmips[w] == "") || (mips[w] == "")) {
+          if ((bwall[w] + 0 > 0) && (wall[w] + 0 > 0)) {     # speed by wall time
+            change = 100.0 * (bwall[w] / wall[w] - 1);
+            if (short[w] || ((w != "total") && (wall[w] + 0 < 10000000))) note = "  (short, not judged)";
+            else if (change < -threshold) { note = "  REGRESSION"; bad++; }
+            printf "%-14s %10.3fs %10.3fs %8.1f%%  wall time%s\n", w, bwall[w] / 1e9, wall[w] / 1e9, change, note;
+          }
+          else printf "%-14s %12s %12s %9s  no data\n", w, bmips[w], mips[w], "";
+          continue;
+        }
+        change = (bmips[w] + 0 > 0) ? 100.0 * (mips[w] - bmips[w]) / bmips[w] : 0;
+        if (instr[w] != binstr[w]) note = "  instructions " binstr[w] " -> " instr[w];
+        else if (short[w] || ((w != "total") && (host[w] + 0 < 10000000))) note = "  (short, not judged)";
+        else if (change < -threshold) { note = "  REGRESSION"; bad++; }
+        printf "%-14s %12.3f %12.3f %8.1f%%%s\n", w, bmips[w], mips[w], change, note;
+      }
+      if (bad) printf "%d regression(s) over %s%%\n", bad, threshold;
+      exit (bad ? 1 : 0);
+    }' "$1" "$2"
+}
+
+
+# process command line
+while getopts n:m:o:c:t:h opt; do
+  case $opt in
+    n) REPS="$OPTARG" ;;
+    m) M20=`abspath "$OPTARG"` ;;
+    o) OUT=`abspath "$OPTARG"` ;;
+    c) BASE=`abspath "$OPTARG"` ;;
+    t) THRESHOLD="$OPTARG" ;;
+    *) usage ;;
+  esac
+done
+shift `expr $OPTIND - 1`
+WORKLOADS="${*:-$ALL_WORKLOADS}"
+
+cd `dirname "$0"` || exit 1		# defaults are relative to suite
+M20=`abspath "$M20"`
+if [ ! -x "$M20" ]; then
+  echo "ERROR: simulator $M20 not found!" >&2
+  exit 10
+fi
+if ! probe; then
+  echo "ERROR: cannot create work directory $WORK!" >&2
+  exit 12
+fi
+
+# run workloads
+rm -f $RESULTS
+INVALID=0
+for w in $WORKLOADS; do
+  if [ ! -f bench_$w.simh ]; then
+    echo "ERROR: unknown workload $w!" >&2
+    exit 11
+  fi
+  i=1
+  while [ $i -le $REPS ]; do
+    echo "bench: $w, run $i of $REPS" >&2
+    if ! prepare $w; then
+      echo "ERROR: cannot prepare workload $w!" >&2
+      rm -rf $WORK
+      exit 12
+    fi
+    meas=`run_measured "$M20" bench_$w.simh`
+    err=`scp_error`
+    if [ -n "$err" ]; then
+      echo "ERROR: $w, run $i: $err, run is invalid!" >&2
+      echo "$w invalid" >>$RESULTS
+      INVALID=`expr $INVALID + 1`
+    elif [ -f $WORK/bench.log ]; then
+      echo "$w $meas `tail -1 $WORK/bench.log`" >>$RESULTS
+    else
+      echo "$w $meas" >>$RESULTS
+    fi
+    i=`expr $i + 1`
+  done
+done
+rm -rf $WORK
+
+report "$M20" $REPS >"$OUT"
+rm -f $RESULTS
+cat "$OUT"
+if [ $INVALID -gt 0 ]; then
+  echo "$INVALID invalid run(s), see errors above" >&2
+fi
+
+# compare with baseline
+if [ -n "$BASE" ]; then
+  if [ ! -f "$BASE" ]; then
+    echo "Baseline $BASE not found, comparison skipped (make bench_baseline)"
+    [ $INVALID -eq 0 ]
+    exit
+  fi
+  echo
+  compare "$BASE" "$OUT" "$THRESHOLD" || exit 1
+fi
+[ $INVALID -eq 0 ]
@@ -3,5 +3,8 @@ del *.out
 del *.cdp 
 del *.err 
 del *.txt
+del *.drum1
+del *.mt0
+del *.fld
 
 
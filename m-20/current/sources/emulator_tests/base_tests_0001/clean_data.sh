@@ -1,6 +1,6 @@
 #!/bin/sh
 
 # clean all
-rm -f *.lst *.out *.cdp *.err *.txt
+rm -f *.lst *.out *.cdp *.err *.txt *.drum1 *.mt0 *.fld
 exit 0
 
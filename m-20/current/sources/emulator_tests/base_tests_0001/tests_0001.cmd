@@ -18,3 +18,43 @@ m20ru.exe primes_0001.simh >primes_0001_ru.out 2>primes_0001_ru.err
 m20ru.exe debug_demo.simh >debug_demo_ru.out 2>debug_demo_ru.err
 @REM constants_test
 m20ru.exe constants_test.simh >constants_test_ru.out 2>constants_test_ru.err
+@REM reverse execution
+m20ru.exe reverse_0001.simh >reverse_0001_ru.out 2>reverse_0001_ru.err
+@REM run limits
+m20ru.exe run_limits_0001.simh >run_limits_0001_ru.out 2>run_limits_0001_ru.err
+@REM idle loop
+m20ru.exe idle_0001.simh >idle_0001_ru.out 2>idle_0001_ru.err
+@REM real time pacing
+m20ru.exe realtime_0001.simh >realtime_0001_ru.out 2>realtime_0001_ru.err
+@REM run statistics
+m20ru.exe stats_0001.simh >stats_0001_ru.out 2>stats_0001_ru.err
+@REM sparse drum image
+m20ru.exe drum_sparse_0001.simh >drum_sparse_0001_ru.out 2>drum_sparse_0001_ru.err
+@REM compressed tape container
+m20ru.exe tape_cont_0001.simh >tape_cont_0001_ru.out 2>tape_cont_0001_ru.err
+@REM ensemble runs
+m20ru.exe ensemble_0001.simh >ensemble_0001_ru.out 2>ensemble_0001_ru.err
+@REM sweep of jobs in forked processes (not supported on Windows)
+m20ru.exe sweep_0001.simh >sweep_0001_ru.out 2>sweep_0001_ru.err
+@REM control-flow graph
+m20ru.exe cfg_0001.simh >cfg_0001_ru.out 2>cfg_0001_ru.err
+@REM self-modifying code monitor
+m20ru.exe smc_0001.simh >smc_0001_ru.out 2>smc_0001_ru.err
+@REM data access heatmap
+m20ru.exe heatmap_0001.simh >heatmap_0001_ru.out 2>heatmap_0001_ru.err
+@REM trace control
+m20ru.exe trace_0001.simh >trace_0001_ru.out 2>trace_0001_ru.err
+@REM host performance counters by opcodes
+m20ru.exe hpc_0001.simh >hpc_0001_ru.out 2>hpc_0001_ru.err
+@REM call-graph profiler
+m20ru.exe calls_0001.simh >calls_0001_ru.out 2>calls_0001_ru.err
+@REM loop profiler
+m20ru.exe loops_0001.simh >loops_0001_ru.out 2>loops_0001_ru.err
+@REM symbol map
+m20ru.exe symbols_0001.simh >symbols_0001_ru.out 2>symbols_0001_ru.err
+@REM binary object file
+m20ru.exe obj_0001.simh >obj_0001_ru.out 2>obj_0001_ru.err
+@REM in-memory device attachments
+m20ru.exe memfile_0001.simh >memfile_0001_ru.out 2>memfile_0001_ru.err
+@REM Burst execution (BURST 1 and BURST 0) with same results
+m20ru.exe burst_0001.simh >burst_0001_ru.out 2>burst_0001_ru.err
@@ -34,3 +34,63 @@ ${M20RU} debug_demo.simh >debug_demo_ru.out 2>debug_demo_ru.err
 
 # constants_test
 ${M20RU} constants_test.simh >constants_test_ru.out 2>constants_test_ru.err
+
+# reverse execution
+${M20RU} reverse_0001.simh >reverse_0001_ru.out 2>reverse_0001_ru.err
+
+# run limits
+${M20RU} run_limits_0001.simh >run_limits_0001_ru.out 2>run_limits_0001_ru.err
+
+# idle loop
+${M20RU} idle_0001.simh >idle_0001_ru.out 2>idle_0001_ru.err
+
+# real time pacing
+${M20RU} realtime_0001.simh >realtime_0001_ru.out 2>realtime_0001_ru.err
+
+# run statistics
+${M20RU} stats_0001.simh >stats_0001_ru.out 2>stats_0001_ru.err
+
+# sparse drum image
+${M20RU} drum_sparse_0001.simh >drum_sparse_0001_ru.out 2>drum_sparse_0001_ru.err
+
+# compressed tape container
+${M20RU} tape_cont_0001.simh >tape_cont_0001_ru.out 2>tape_cont_0001_ru.err
+
+# ensemble runs
+${M20RU} ensemble_0001.simh >ensemble_0001_ru.out 2>ensemble_0001_ru.err
+
+# sweep of jobs in forked processes
+${M20RU} sweep_0001.simh >sweep_0001_ru.out 2>sweep_0001_ru.err
+
+# control-flow graph
+${M20RU} cfg_0001.simh >cfg_0001_ru.out 2>cfg_0001_ru.err
+
+# self-modifying code monitor
+${M20RU} smc_0001.simh >smc_0001_ru.out 2>smc_0001_ru.err
+
+# data access heatmap
+${M20RU} heatmap_0001.simh >heatmap_0001_ru.out 2>heatmap_0001_ru.err
+
+# trace control
+${M20RU} trace_0001.simh >trace_0001_ru.out 2>trace_0001_ru.err
+
+# host performance counters by opcodes
+${M20RU} hpc_0001.simh >hpc_0001_ru.out 2>hpc_0001_ru.err
+
+# call-graph profiler
+${M20RU} calls_0001.simh >calls_0001_ru.out 2>calls_0001_ru.err
+
+# loop profiler
+${M20RU} loops_0001.simh >loops_0001_ru.out 2>loops_0001_ru.err
+
+# symbol map
+${M20RU} symbols_0001.simh >symbols_0001_ru.out 2>symbols_0001_ru.err
+
+# binary object file
+${M20RU} obj_0001.simh >obj_0001_ru.out 2>obj_0001_ru.err
+
+# in-memory device attachments
+${M20RU} memfile_0001.simh >memfile_0001_ru.out 2>memfile_0001_ru.err
+
+# Burst execution (BURST 1 and BURST 0) with same results
+${M20RU} burst_0001.simh >burst_0001_ru.out 2>burst_0001_ru.err